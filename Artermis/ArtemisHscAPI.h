@@ -5,7 +5,13 @@
  *
  ****************************************/
 
+#ifdef WIN32
 #include <comdef.h>
+#else
+// Only passed through by pointer/handle to the Windows-only entry points
+typedef void* HWND;
+typedef struct tagVARIANT VARIANT;
+#endif
 
 //////////////////////////////////////////////////////////////////////////
 //
@@ -337,7 +343,7 @@ artfn  int ArtemisTemperatureSensorInfo(ArtemisHandle hCam, int sensor, int* tem
 
 // Try to load the Artemis DLL.
 // Returns true if loaded ok.
-artfn bool ArtemisLoadDLL(char *FileName);
+artfn bool ArtemisLoadDLL(const char *FileName);
 
 // Unload the Artemis DLL.
 artfn void ArtemisUnLoadDLL();
@@ -0,0 +1,399 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          ArtemisSynthetic.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Simulated camera behind the Artemis API
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:     
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#include "ArtemisSynthetic.h"
+#include "ArtemisHscAPI.h"
+#include "../CameraUtilities/DynamicLibrary.h"
+#include "../CameraUtilities/SyntheticCamera.h"
+#include "../CameraUtilities/FramePacer.h"
+#include "../../MMDevice/DeviceThreads.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+const char* g_ArtemisSyntheticLibrary = "Synthetic";
+
+// One simulated camera, device 0. The Artemis handle is just its address.
+namespace
+{
+	MMThreadLock simLock;
+	SyntheticCamera sim;
+	bool connected = false;
+	int subX = 0, subY = 0, subW = 0, subH = 0;
+	int binX = 1, binY = 1;
+	float overlapSeconds = 0.1f;
+
+	// Wall clock time of the monotonic clock's origin, for the start times
+	time_t wallBase = 0;
+	double wallBaseUs = 0;
+	char startTime[32];
+
+	bool valid(ArtemisHandle hCam)
+	{
+		return connected && hCam == (ArtemisHandle) &sim;
+	}
+
+	void applyGeometry()
+	{
+		sim.SetRegion(subX, subY, subW, subH);
+		sim.SetBinning(binX, binY);
+	}
+}
+
+static int DYNLIB_STDCALL simAPIVersion()
+{
+	return 1;
+}
+
+static bool DYNLIB_STDCALL simDeviceIsCamera(int Device)
+{
+	return Device == 0;
+}
+
+static bool DYNLIB_STDCALL simDeviceName(int Device, char *pName)
+{
+	if (Device != 0)
+		return false;
+	strcpy(pName, "Synthetic camera");
+	return true;
+}
+
+static bool DYNLIB_STDCALL simDeviceSerial(int Device, char *pName)
+{
+	if (Device != 0)
+		return false;
+	strcpy(pName, "SYNTH0");
+	return true;
+}
+
+static ArtemisHandle DYNLIB_STDCALL simConnect(int Device)
+{
+	MMThreadGuard g(simLock);
+	if (Device != 0 || connected)
+		return 0;
+
+	const SyntheticCameraConfig& c = sim.GetConfig();
+	subX = 0;
+	subY = 0;
+	subW = c.width;
+	subH = c.height;
+	binX = 1;
+	binY = 1;
+	applyGeometry();
+	sim.SetContinuous(false);
+
+	wallBase = time(0);
+	wallBaseUs = MonotonicClock::NowUs();
+	connected = true;
+	return (ArtemisHandle) &sim;
+}
+
+static bool DYNLIB_STDCALL simDisconnect(ArtemisHandle hCam)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return false;
+	connected = false;
+	return true;
+}
+
+static bool DYNLIB_STDCALL simIsConnected(ArtemisHandle hCam)
+{
+	MMThreadGuard g(simLock);
+	return valid(hCam);
+}
+
+static int DYNLIB_STDCALL simProperties(ArtemisHandle hCam, struct ARTEMISPROPERTIES *pProp)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return ARTEMIS_NOT_CONNECTED;
+
+	const SyntheticCameraConfig& c = sim.GetConfig();
+	memset(pProp, 0, sizeof(*pProp));
+	pProp->nPixelsX = c.width;
+	pProp->nPixelsY = c.height;
+	pProp->PixelMicronsX = (float) c.pixelUm;
+	pProp->PixelMicronsY = (float) c.pixelUm;
+	pProp->cameraflags = ARTEMIS_PROPERTIES_CAMERAFLAGS_HAS_OVERLAP_MODE;
+	strncpy(pProp->Description, "Synthetic camera", sizeof(pProp->Description) - 1);
+	strncpy(pProp->Manufacturer, "Micro-Manager", sizeof(pProp->Manufacturer) - 1);
+	return ARTEMIS_OK;
+}
+
+static int DYNLIB_STDCALL simGetMaxBin(ArtemisHandle hCam, int *x, int *y)
+{
+	*x = 16;
+	*y = 16;
+	return valid(hCam) ? ARTEMIS_OK : ARTEMIS_NOT_CONNECTED;
+}
+
+static int DYNLIB_STDCALL simBin(ArtemisHandle hCam, int x, int y)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return ARTEMIS_NOT_CONNECTED;
+	if (x < 1 || y < 1 || x > 16 || y > 16)
+		return ARTEMIS_INVALID_PARAMETER;
+	binX = x;
+	binY = y;
+	return ARTEMIS_OK;
+}
+
+static int DYNLIB_STDCALL simGetBin(ArtemisHandle hCam, int *x, int *y)
+{
+	MMThreadGuard g(simLock);
+	*x = binX;
+	*y = binY;
+	return valid(hCam) ? ARTEMIS_OK : ARTEMIS_NOT_CONNECTED;
+}
+
+static int DYNLIB_STDCALL simSubframe(ArtemisHandle hCam, int x, int y, int w, int h)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return ARTEMIS_NOT_CONNECTED;
+	subX = x;
+	subY = y;
+	subW = w;
+	subH = h;
+	return ARTEMIS_OK;
+}
+
+static int DYNLIB_STDCALL simSubframePos(ArtemisHandle hCam, int x, int y)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return ARTEMIS_NOT_CONNECTED;
+	subX = x;
+	subY = y;
+	return ARTEMIS_OK;
+}
+
+static int DYNLIB_STDCALL simSubframeSize(ArtemisHandle hCam, int w, int h)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return ARTEMIS_NOT_CONNECTED;
+	subW = w;
+	subH = h;
+	return ARTEMIS_OK;
+}
+
+static int DYNLIB_STDCALL simGetSubframe(ArtemisHandle hCam, int *x, int *y, int *w, int *h)
+{
+	MMThreadGuard g(simLock);
+	*x = subX;
+	*y = subY;
+	*w = subW;
+	*h = subH;
+	return valid(hCam) ? ARTEMIS_OK : ARTEMIS_NOT_CONNECTED;
+}
+
+// The subframe and binning are latched when an exposure starts, as on the
+// camera itself, so they can be set in either order
+static int DYNLIB_STDCALL simStartExposure(ArtemisHandle hCam, float Seconds)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return ARTEMIS_NOT_CONNECTED;
+	applyGeometry();
+	sim.StartExposure(Seconds*1000.0);
+	return ARTEMIS_OK;
+}
+
+static int DYNLIB_STDCALL simSetOverlappedExposureTime(ArtemisHandle hCam, float Seconds)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return ARTEMIS_NOT_CONNECTED;
+	overlapSeconds = Seconds;
+	return ARTEMIS_OK;
+}
+
+static int DYNLIB_STDCALL simStartOverlappedExposure(ArtemisHandle hCam)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return ARTEMIS_NOT_CONNECTED;
+	applyGeometry();
+	sim.StartOverlappedExposure(overlapSeconds*1000.0);
+	return ARTEMIS_OK;
+}
+
+static bool DYNLIB_STDCALL simOverlappedExposureValid(ArtemisHandle hCam)
+{
+	return valid(hCam);
+}
+
+static bool DYNLIB_STDCALL simCanOverlapExposures(ArtemisHandle hCam)
+{
+	return valid(hCam);
+}
+
+static bool DYNLIB_STDCALL simContinuousExposingModeSupported(ArtemisHandle hCam)
+{
+	return valid(hCam);
+}
+
+static int DYNLIB_STDCALL simSetContinuousExposingMode(ArtemisHandle hCam, bool bEnable)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return ARTEMIS_NOT_CONNECTED;
+	sim.SetContinuous(bEnable);
+	return ARTEMIS_OK;
+}
+
+static bool DYNLIB_STDCALL simGetContinuousExposingMode(ArtemisHandle hCam)
+{
+	MMThreadGuard g(simLock);
+	return valid(hCam) && sim.IsContinuous();
+}
+
+static int DYNLIB_STDCALL simAbortExposure(ArtemisHandle hCam)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return ARTEMIS_NOT_CONNECTED;
+	sim.Abort();
+	return ARTEMIS_OK;
+}
+
+// Not under the lock: polling may sleep for up to a millisecond, and only
+// the thread that started the exposure reads it out
+static bool DYNLIB_STDCALL simImageReady(ArtemisHandle hCam)
+{
+	return valid(hCam) && sim.IsReady();
+}
+
+static void* DYNLIB_STDCALL simImageBuffer(ArtemisHandle hCam)
+{
+	if (!valid(hCam))
+		return 0;
+	return (void*) sim.GetFrame();
+}
+
+static int DYNLIB_STDCALL simCameraState(ArtemisHandle hCam)
+{
+	if (!valid(hCam))
+		return CAMERA_ERROR;
+	return sim.IsReady() ? CAMERA_IDLE : CAMERA_EXPOSING;
+}
+
+static char* DYNLIB_STDCALL simLastStartTime(ArtemisHandle hCam)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return 0;
+	time_t t = wallBase + (time_t) ((sim.GetExposureStartUs() - wallBaseUs)/1.0e6);
+	struct tm* local = localtime(&t);
+	if (local == 0)
+		return 0;
+	strftime(startTime, sizeof(startTime), "%Y/%m/%d %H:%M:%S", local);
+	return startTime;
+}
+
+static int DYNLIB_STDCALL simLastStartTimeMilliseconds(ArtemisHandle hCam)
+{
+	MMThreadGuard g(simLock);
+	if (!valid(hCam))
+		return 0;
+	double us = sim.GetExposureStartUs() - wallBaseUs;
+	return (int) ((long long) (us/1000) % 1000);
+}
+
+// Sensor 0 is the number of sensors; temperatures are oC*100
+static int DYNLIB_STDCALL simTemperatureSensorInfo(ArtemisHandle hCam, int sensor, int* temperature)
+{
+	if (!valid(hCam))
+		return ARTEMIS_NOT_CONNECTED;
+	*temperature = (sensor == 0) ? 1 : 2000;
+	return ARTEMIS_OK;
+}
+
+static int DYNLIB_STDCALL simCoolingInfo(ArtemisHandle hCam, int* flags, int* level, int* minlvl, int* maxlvl, int* setpoint)
+{
+	*flags = 0;	//no cooler
+	*level = 0;
+	*minlvl = 0;
+	*maxlvl = 0;
+	*setpoint = 0;
+	return valid(hCam) ? ARTEMIS_OK : ARTEMIS_NOT_CONNECTED;
+}
+
+#define SIM_SYMBOL(name, fn) {name, (DynamicLibrary::Symbol) fn}
+
+// Entry points the simulation doesn't provide resolve to null, which the
+// wrappers in ArtemisHscAPI.cpp treat as a no-op returning 0
+static const DynamicLibrary::VirtualSymbol simSymbols[] =
+{
+	SIM_SYMBOL("ArtemisAPIVersion", simAPIVersion),
+	SIM_SYMBOL("ArtemisDeviceIsCamera", simDeviceIsCamera),
+	SIM_SYMBOL("ArtemisDeviceName", simDeviceName),
+	SIM_SYMBOL("ArtemisDeviceSerial", simDeviceSerial),
+	SIM_SYMBOL("ArtemisConnect", simConnect),
+	SIM_SYMBOL("ArtemisDisconnect", simDisconnect),
+	SIM_SYMBOL("ArtemisIsConnected", simIsConnected),
+	SIM_SYMBOL("ArtemisProperties", simProperties),
+	SIM_SYMBOL("ArtemisGetMaxBin", simGetMaxBin),
+	SIM_SYMBOL("ArtemisBin", simBin),
+	SIM_SYMBOL("ArtemisGetBin", simGetBin),
+	SIM_SYMBOL("ArtemisSubframe", simSubframe),
+	SIM_SYMBOL("ArtemisSubframePos", simSubframePos),
+	SIM_SYMBOL("ArtemisSubframeSize", simSubframeSize),
+	SIM_SYMBOL("ArtemisGetSubframe", simGetSubframe),
+	SIM_SYMBOL("ArtemisStartExposure", simStartExposure),
+	SIM_SYMBOL("ArtemisSetOverlappedExposureTime", simSetOverlappedExposureTime),
+	SIM_SYMBOL("ArtemisStartOverlappedExposure", simStartOverlappedExposure),
+	SIM_SYMBOL("ArtemisOverlappedExposureValid", simOverlappedExposureValid),
+	SIM_SYMBOL("ArtemisCanOverlapExposures", simCanOverlapExposures),
+	SIM_SYMBOL("ArtemisContinuousExposingModeSupported", simContinuousExposingModeSupported),
+	SIM_SYMBOL("ArtemisSetContinuousExposingMode", simSetContinuousExposingMode),
+	SIM_SYMBOL("ArtemisGetContinuousExposingMode", simGetContinuousExposingMode),
+	SIM_SYMBOL("ArtemisAbortExposure", simAbortExposure),
+	SIM_SYMBOL("ArtemisImageReady", simImageReady),
+	SIM_SYMBOL("ArtemisImageBuffer", simImageBuffer),
+	SIM_SYMBOL("ArtemisCameraState", simCameraState),
+	SIM_SYMBOL("ArtemisLastStartTime", simLastStartTime),
+	SIM_SYMBOL("ArtemisLastStartTimeMilliseconds", simLastStartTimeMilliseconds),
+	SIM_SYMBOL("ArtemisTemperatureSensorInfo", simTemperatureSensorInfo),
+	SIM_SYMBOL("ArtemisCoolingInfo", simCoolingInfo),
+	{0, 0}
+};
+
+void RegisterArtemisSynthetic()
+{
+	DynamicLibrary::RegisterVirtual(g_ArtemisSyntheticLibrary, simSymbols);
+}
+
+bool ConfigureArtemisSynthetic(const std::string& spec)
+{
+	MMThreadGuard g(simLock);
+	return sim.Configure(spec);
+}
+
+std::string GetArtemisSyntheticConfig()
+{
+	MMThreadGuard g(simLock);
+	return sim.GetConfigString();
+}
@@ -0,0 +1,40 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          ArtemisSynthetic.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Simulated camera behind the Artemis API
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:     
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#ifndef _ARTEMISSYNTHETIC_H_
+#define _ARTEMISSYNTHETIC_H_
+
+#include <string>
+
+// Library name which loads the simulated camera instead of a vendor DLL
+extern const char* g_ArtemisSyntheticLibrary;
+
+// Make g_ArtemisSyntheticLibrary available to ArtemisLoadDLL(). Call before
+// loading; registering more than once is harmless.
+void RegisterArtemisSynthetic();
+
+// Sensor model, as SyntheticCamera::Configure(). Takes effect on the next
+// ArtemisConnect().
+bool ConfigureArtemisSynthetic(const std::string& spec);
+std::string GetArtemisSyntheticConfig();
+
+#endif //_ARTEMISSYNTHETIC_H_
@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SyntheticSequence.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Headless sequence benchmark against the synthetic Artemis
+//                camera, reporting delivered frame rate and latency
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+// USAGE:         SyntheticSequence [frames] [exposure-ms] [mode] [camera]
+//                mode is normal, overlapped or continuous; camera is a
+//                SyntheticCamera spec, e.g. "width=1392 height=1040 bits=16".
+//                Drives the Artemis calls the way VS14M's sequence thread
+//                does, without Micro-Manager, so it runs on any machine.
+
+#include "ArtemisHscAPI.h"
+#include "ArtemisSynthetic.h"
+#include "../CameraUtilities/FramePacer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Same backoff as CVS14M::waitImageReady, so the latency matches the adapter
+static bool waitReady(ArtemisHandle hCam, double timeoutMs)
+{
+	double startUs = MonotonicClock::NowUs();
+	double backoffUs = 100;
+	while (!ArtemisImageReady(hCam))
+	{
+		double nowUs = MonotonicClock::NowUs();
+		if (nowUs - startUs > timeoutMs*1000)
+			return false;
+		MonotonicClock::SleepUntilUs(nowUs + backoffUs);
+		if (backoffUs < 1000)
+			backoffUs *= 2;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	long frames = (argc > 1) ? atol(argv[1]) : 100;
+	double exposureMs = (argc > 2) ? atof(argv[2]) : 10;
+	std::string mode = (argc > 3) ? argv[3] : "normal";
+	std::string camera = (argc > 4) ? argv[4] : "";
+	if (frames <= 0 || exposureMs < 0 || (mode != "normal" && mode != "overlapped" && mode != "continuous"))
+	{
+		fprintf(stderr, "usage: %s [frames] [exposure-ms] [normal|overlapped|continuous] [camera]\n", argv[0]);
+		return 2;
+	}
+
+	RegisterArtemisSynthetic();
+	if (!ArtemisLoadDLL(g_ArtemisSyntheticLibrary))
+	{
+		fprintf(stderr, "cannot load the synthetic camera\n");
+		return 1;
+	}
+	if (!camera.empty() && !ConfigureArtemisSynthetic(camera))
+	{
+		fprintf(stderr, "bad camera spec: %s\n", camera.c_str());
+		return 2;
+	}
+	ArtemisHandle hCam = ArtemisConnect(0);
+	if (hCam == 0)
+	{
+		fprintf(stderr, "cannot connect to the synthetic camera\n");
+		return 1;
+	}
+
+	struct ARTEMISPROPERTIES props;
+	ArtemisProperties(hCam, &props);
+	ArtemisSubframe(hCam, 0, 0, props.nPixelsX, props.nPixelsY);
+	std::vector<unsigned short> img(props.nPixelsX*props.nPixelsY);
+	float expSeconds = (float) exposureMs/1000;
+	double timeoutMs = exposureMs + 5000;
+
+	FramePacer pacer;
+	FrameRateMeter meter;
+	if (mode == "overlapped")
+		ArtemisSetOverlappedExposureTime(hCam, expSeconds);
+	else if (mode == "continuous")
+	{
+		// flush the charge collected before the sequence, as VS14M does
+		ArtemisSetContinuousExposingMode(hCam, true);
+		ArtemisStartExposure(hCam, expSeconds);
+		if (!waitReady(hCam, timeoutMs))
+		{
+			fprintf(stderr, "timed out flushing the sensor\n");
+			return 1;
+		}
+		pacer.Start(exposureMs);
+	}
+
+	meter.Start();
+	for (long i = 0; i < frames; i++)
+	{
+		if (mode == "continuous")
+		{
+			// each read ends the integration since the previous one
+			pacer.WaitForNextFrame();
+			ArtemisStartExposure(hCam, expSeconds);
+		}
+		else if (mode == "overlapped")
+			ArtemisStartOverlappedExposure(hCam);
+		else
+			ArtemisStartExposure(hCam, expSeconds);
+
+		if (!waitReady(hCam, timeoutMs))
+		{
+			fprintf(stderr, "timed out waiting for frame %ld\n", i);
+			return 1;
+		}
+		double readyUs = MonotonicClock::NowUs();
+		const unsigned short* buf = (const unsigned short*) ArtemisImageBuffer(hCam);
+		if (buf == 0)
+		{
+			fprintf(stderr, "no image for frame %ld\n", i);
+			return 1;
+		}
+		memcpy(&img[0], buf, img.size()*sizeof(unsigned short));
+		meter.AddFrame(readyUs);
+	}
+
+	FrameRateStats stats = meter.GetStats();
+	printf("%s %dx%d, %ld frames of %.3f ms: %.2f fps, latency mean %.3f ms, max %.3f ms\n",
+		mode.c_str(), props.nPixelsX, props.nPixelsY, stats.frames, exposureMs,
+		stats.fps, stats.meanLatencyUs/1000, stats.maxLatencyUs/1000);
+
+	if (mode == "continuous")
+		ArtemisSetContinuousExposingMode(hCam, false);
+	ArtemisDisconnect(hCam);
+	ArtemisUnLoadDLL();
+	return 0;
+}
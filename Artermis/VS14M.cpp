@@ -21,14 +21,15 @@
 
 #include "VS14M.h"
 #include <cstdio>
+#include <ctime>
 #include <string>
 #include <math.h>
 #include "../../MMDevice/ModuleInterface.h"
 #include <sstream>
 #include <algorithm>
 #include <iostream>
-#include "../../3rdparty/ArtemisVS14M/ArtemisHscAPI.h"
-//#include "C:\\Users\\dk1109\\repositories\\umanager\\micromanager\\DeviceAdapters\\Artermis\\ArtemisHscAPI.h"
+#include "ArtemisSynthetic.h"
+#include "../CameraUtilities/DynamicLibrary.h"
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 #include <cmath>
@@ -42,6 +43,15 @@ double g_IntensityFactor_ = 1.0;
 // External names used used by the rest of the system
 // to load particular device from the "VS14M.dll" library
 const char* g_CameraDeviceName = "VS14MCam";
+const char* g_Keyword_CameraIndexSerial = "CameraIndex/Serial";
+const char* g_Keyword_ArtemisLibrary = "ArtemisLibrary";
+const char* g_Keyword_SyntheticCamera = "SyntheticCamera";
+
+#ifdef WIN32
+const char* g_DefaultArtemisLibrary = "C:\\Windows\\SysWOW64\\ArtemisHsc.dll";
+#else
+const char* g_DefaultArtemisLibrary = "libArtemisHsc.so";
+#endif
 
 
 // constants for naming pixel types (allowed values of the "PixelType" property)
@@ -51,6 +61,45 @@ const char* g_PixelType_32bitRGB = "32bitRGB";
 const char* g_PixelType_64bitRGB = "64bitRGB";
 const char* g_PixelType_32bit = "32bit";  // floating point greyscale
 
+// allowed values of the "TriggerSource" property
+const char* g_TriggerSource_Device = "Device adapter";
+const char* g_TriggerSource_GPIO = "Camera GPIO";
+
+// Accuracy of the driver's exposure start times, and the shortest frame
+// interval at which gaps in them are taken as lost frames
+const double g_StartTimeResolutionMs = 100;
+const double g_MinGapIntervalMs = 10*g_StartTimeResolutionMs;
+
+
+// The Artemis DLL and its function table are process wide, so it is loaded
+// once and shared by however many camera instances are open. They must all
+// use the same library.
+static MMThreadLock g_dllLock;
+static int g_dllUsers = 0;
+static std::string g_dllName;
+
+static bool acquireArtemisDLL(const std::string& library)
+{
+	MMThreadGuard g(g_dllLock);
+	if (g_dllUsers == 0)
+	{
+		RegisterArtemisSynthetic();
+		if (!ArtemisLoadDLL(library.c_str()))
+			return false;
+		g_dllName = library;
+	}
+	else if (library != g_dllName)
+		return false;
+	++g_dllUsers;
+	return true;
+}
+
+static void releaseArtemisDLL()
+{
+	MMThreadGuard g(g_dllLock);
+	if (g_dllUsers > 0 && --g_dllUsers == 0)
+		ArtemisUnLoadDLL();
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 // Exported MMDevice API
@@ -135,6 +184,50 @@ CCameraBase<CVS14M> (),
 	sequenceMaxLength_(100),
 	sequenceRunning_(false),
 	sequenceIndex_(0),
+	canOverlap_(false),
+	hwSequence_(false),
+	nextSequenceExposure_(0),
+	armedExposure_(0),
+	frameExposure_(0),
+	frameExposureValid_(true),
+	exposureSequenceMisses_(0),
+	continuousSupported_(false),
+	continuousAllowed_(true),
+	continuousSequence_(false),
+	frameStartMs_(0),
+	startTimeBaseMs_(0),
+	lastStartMs_(0),
+	accumulateFrames_(1),
+	accumulateVariance_(false),
+	accumReady_(false),
+	correctionFrames_(16),
+	hotPixelSigma_(5.0),
+	capturingReference_(false),
+	statsEnabled_(false),
+	histogramEnabled_(false),
+	frameScanned_(false),
+	autoExposureEnabled_(false),
+	autoExposurePending_(0),
+	softBinX_(1),
+	softBinY_(1),
+	softBin32_(false),
+	burstEnabled_(false),
+	burstBackground_(false),
+	burstCapacity_(200),
+	burstActive_(false),
+	streamEnabled_(false),
+	streamToCore_(false),
+	streamDir_(""),
+	streamBuffers_(2),
+	streamBufferMB_(16),
+	streamCount_(0),
+	streamActive_(false),
+	streamCompress_(false),
+	streamPacked_(false),
+	codecThreads_(0),
+	streamRawBytes_(0),
+	streamPackedBytes_(0),
+	codecBenchmark_(""),
 	binSizeX_(1),
 	binSizeY_(1),
 	asymmBinning_(false),
@@ -142,6 +235,12 @@ CCameraBase<CVS14M> (),
 	cameraCCDYSize_(1040),
 	ccdT_ (0.0),
 	triggerDevice_(""),
+	triggerDev_(0),
+	gpioTrigger_(false),
+	gpioTriggerLine_(0),
+	gpioLineCount_(0),
+	hCam_(0),
+	dllLoaded_(false),
 	currentTemp_(-1.0),
 	stopOnOverflow_(false),
 	flipUD_(false),
@@ -153,14 +252,34 @@ CCameraBase<CVS14M> (),
 	processLinearise_(true),
 	overlapExposure_(false), 
 	previewMode_(false),
+	frameReadyUs_(0),
+	tempCenti_(0),
+	coolerPower_(0),
+	coolerSetpointCenti_(0),
+	telemetryHead_(0),
+	telemetryCount_(0),
 	nComponents_(1)
 {
 	//memset(testProperty_,0,sizeof(testProperty_));
 
 	// call the base class method to set-up default error codes/messages
 	InitializeDefaultErrorMessages();
+	SetErrorText(ERR_NO_TRIGGER_DEVICE, "Trigger device not found - check the TriggerDevice property");
+	SetErrorText(ERR_CAMERA_NOT_FOUND, "No camera with this index or serial number - check CameraIndex/Serial");
+	SetErrorText(ERR_CORRECTION_PIXELTYPE, "Dark and flat correction need 16-bit pixels");
+	SetErrorText(ERR_CORRECTION_FILE, "Could not read or write the correction references - check CorrectionReferenceDir");
+	SetErrorText(ERR_BINNING_ACCUMULATE, "32-bit software binning cannot be combined with AccumulateFrames - use 16-bit");
+	SetErrorText(ERR_BURST_FULL, "Burst ring full - raise BurstCapacity or drain in the background");
+	SetErrorText(ERR_BURST_MEMORY, "Could not allocate the burst ring - lower BurstCapacity");
+	SetErrorText(ERR_STREAM_FILE, "Could not write the stream to disk - check StreamDir");
+	SetErrorText(ERR_ARTEMIS_LIBRARY, "Could not load the Artemis library - check ArtemisLibrary");
+	SetErrorText(ERR_CONTINUOUS_EXPOSING, "Could not start continuous exposing - set ContinuousExposingSequence to 0");
+	SetErrorText(ERR_SYNTHETIC_CONFIG, "Bad SyntheticCamera settings - expected key=value pairs, e.g. width=1392 height=1040 bits=16 readout-ms=30 noise=8");
 	readoutStartTime_ = GetCurrentMMTime();
 	thd_ = new MySequenceThread(this);
+	burstDrain_ = new BurstDrainThread(this);
+	telemetry_ = new TelemetryThread(this);
+	telemetryHistory_.resize(64);
 
 	// parent ID display
 	//CreateHubIDProperty();
@@ -168,6 +287,37 @@ CCameraBase<CVS14M> (),
 	CreateFloatProperty("MaximumExposureMs", exposureMaximum_, false,
 		new CPropertyAction(this, &CVS14M::OnMaxExposure),
 		true);
+
+	// Which camera this instance drives, by device index or serial number, so
+	// several cameras can be loaded side by side
+	CreateStringProperty(g_Keyword_CameraIndexSerial, "0", false, 0, true);
+
+	// The SDK library to load, or "Synthetic" for a simulated camera, whose
+	// sensor is described by SyntheticCamera. The default library is loaded
+	// only long enough to list the cameras, so it does not stop another
+	// instance from choosing a different library; Initialize() loads the
+	// chosen one.
+	CreateStringProperty(g_Keyword_ArtemisLibrary, g_DefaultArtemisLibrary, false, 0, true);
+	CreateStringProperty(g_Keyword_SyntheticCamera, GetArtemisSyntheticConfig().c_str(), false, 0, true);
+	if (acquireArtemisDLL(g_DefaultArtemisLibrary))
+	{
+		char serial[64];
+		std::string first;
+		for (int i = 0; i < 10; i++)
+		{
+			if (!ArtemisDeviceIsCamera(i))
+				continue;
+			std::string index = boost::lexical_cast<std::string>(i);
+			AddAllowedValue(g_Keyword_CameraIndexSerial, index.c_str());
+			if (ArtemisDeviceSerial(i, serial) && serial[0] != 0)
+				AddAllowedValue(g_Keyword_CameraIndexSerial, serial);
+			if (first.empty())
+				first = index;
+		}
+		if (!first.empty())
+			SetProperty(g_Keyword_CameraIndexSerial, first.c_str());	// device 0 may not be a camera
+		releaseArtemisDLL();
+	}
 }
 
 /**
@@ -180,10 +330,11 @@ CCameraBase<CVS14M> (),
 CVS14M::~CVS14M()
 {
 	//StopSequenceAcquisition();
-	//ArtemisDisconnectAll();
-	ArtemisUnLoadDLL();
-	LogMessage("DLL unloaded OK");
+	if (dllLoaded_)
+		releaseArtemisDLL();
 	delete thd_;
+	delete burstDrain_;
+	delete telemetry_;
 }
 
 /**
@@ -203,7 +354,7 @@ void CVS14M::GetName(char* name) const
 * Device properties are typically created here as well, except
 * the ones we need to use for defining initialization parameters.
 * Such pre-initialization properties are created in the constructor.
-* (This device does not have any pre-initialization properties)
+* The camera is chosen by the CameraIndex/Serial pre-initialization property.
 */
 int CVS14M::Initialize()
 {
@@ -231,28 +382,43 @@ int CVS14M::Initialize()
 	nRet = CreateStringProperty(MM::g_Keyword_CameraID, "V1.0", true);
 	assert(nRet == DEVICE_OK);
 
-	//Load DLL and connect camera before setting up any properties that need hardware-based limits. 
-	//bool dllOK = ArtemisLoadDLL("C:\\Windows\\SysWOW64\\ArtemisSci.dll");
-	bool dllOK = ArtemisLoadDLL("C:\\Windows\\SysWOW64\\ArtemisHsc.dll"); //change to relative path???
-
-	if (dllOK)
-		LogMessage("DLL loaded OK!");
-	else
-		return DEVICE_ERR;
+	//Load the chosen library; connect camera before setting up any properties that need hardware-based limits. 
+	char library[MM::MaxStrLength];
+	GetProperty(g_Keyword_ArtemisLibrary, library);
+	if (!dllLoaded_)
+	{
+		dllLoaded_ = acquireArtemisDLL(library);
+		if (!dllLoaded_)
+		{
+			LogMessage(std::string("Artemis library: ") + DynamicLibrary::GetLastError());
+			return ERR_ARTEMIS_LIBRARY;
+		}
+		artemisLibrary_ = library;
+	}
+	if (artemisLibrary_ == g_ArtemisSyntheticLibrary)
+	{
+		char synthetic[MM::MaxStrLength];
+		GetProperty(g_Keyword_SyntheticCamera, synthetic);
+		if (!ConfigureArtemisSynthetic(synthetic))
+			return ERR_SYNTHETIC_CONFIG;
+	}
 
-	hCam_ = ArtemisConnect(0);	//Connect first camera found. 
+	// Match a serial number first, otherwise treat the value as a device index
+	char cameraId[MM::MaxStrLength];
+	GetProperty(g_Keyword_CameraIndexSerial, cameraId);
+	int device = -1;
+	char serial[64];
+	for (int i = 0; i < 10 && device < 0; i++)
+	{
+		if (ArtemisDeviceIsCamera(i) && ArtemisDeviceSerial(i, serial) && strcmp(serial, cameraId) == 0)
+			device = i;
+	}
+	if (device < 0)
+		device = atoi(cameraId);
 
-	//// Deal with connecting cameras
-	//char devname[64];
-	//int ncams = 0;
-	//for (int i = 0; i < 10; i++)
-	//{
-	//	if (ArtemisDeviceIsCamera(i))
-	//	{
-	//		ArtemisDeviceName(i,devname);
-	//		std::cout << "Device name: " << devname << ", number " << i <<std::endl;
-	//	}
-	//}
+	hCam_ = ArtemisConnect(device);
+	if (hCam_ == 0)
+		return ERR_CAMERA_NOT_FOUND;
 
 	// API version
 	int APIVer = ArtemisAPIVersion();
@@ -327,14 +493,26 @@ int CVS14M::Initialize()
 		GetCurrentTemperature();
 		ambientTemp_ = currentTemp_;
 		ccdT_ = ambientTemp_;
-		nRet = CreateFloatProperty("CCDTemperature Readout", currentTemp_, false);
+		pAct = new CPropertyAction (this, &CVS14M::OnCCDTempReadout);
+		nRet = CreateFloatProperty("CCDTemperature Readout", currentTemp_, true, pAct);
 		assert(nRet == DEVICE_OK);
 
+		// cooler state and temperature history, all from the telemetry thread (RO)
+		pAct = new CPropertyAction (this, &CVS14M::OnCoolerPower);
+		CreateIntegerProperty("CoolerPower (%)", 0, true, pAct);
+		pAct = new CPropertyAction (this, &CVS14M::OnCoolerSetpoint);
+		CreateFloatProperty("CoolerSetpoint", 0, true, pAct);
+		pAct = new CPropertyAction (this, &CVS14M::OnTemperatureDrift);
+		CreateFloatProperty("TemperatureDrift", 0, true, pAct);
+		pAct = new CPropertyAction (this, &CVS14M::OnTemperatureHistory);
+		CreateStringProperty("TemperatureHistory", "", true, pAct);
+		telemetry_->Start();
+
 		// camera temperature
 		pAct = new CPropertyAction (this, &CVS14M::OnCCDTemp);
 		nRet = CreateFloatProperty(MM::g_Keyword_CCDTemperature, ambientTemp_, false, pAct);
 		assert(nRet == DEVICE_OK);
-		float minTemp = max((ambientTemp_ - 35), -20.0); //Attempt to account for case where camera has been pre-cooled. 
+		float minTemp = (float) max((double) (ambientTemp_ - 35), -20.0); //Attempt to account for case where camera has been pre-cooled. 
 		SetPropertyLimits(MM::g_Keyword_CCDTemperature, minTemp, ambientTemp_);
 	}
 
@@ -354,6 +532,23 @@ int CVS14M::Initialize()
 		CreateStringProperty("TriggerDevice", "", false, pAct);
 	}
 
+	// Trigger the intensifier from the camera's own GPIO lines rather than
+	// via another device adapter - include only if camera has GPIO
+	if (pProp.cameraflags & ARTEMIS_PROPERTIES_CAMERAFLAGS_HAS_GPIO){
+		int lineValues = 0;
+		ArtemisGetGpioInformation(hCam_, &gpioLineCount_, &lineValues);
+		if (gpioLineCount_ > 0){
+			pAct = new CPropertyAction (this, &CVS14M::OnTriggerSource);
+			CreateStringProperty("TriggerSource", g_TriggerSource_Device, false, pAct);
+			AddAllowedValue("TriggerSource", g_TriggerSource_Device);
+			AddAllowedValue("TriggerSource", g_TriggerSource_GPIO);
+
+			pAct = new CPropertyAction (this, &CVS14M::OnGpioTriggerLine);
+			CreateIntegerProperty("TriggerGpioLine", 0, false, pAct);
+			SetPropertyLimits("TriggerGpioLine", 0, gpioLineCount_ - 1);
+		}
+	}
+
 	// Whether or not to use exposure time sequencing
 	pAct = new CPropertyAction (this, &CVS14M::OnIsSequenceable);
 	std::string propName = "UseExposureSequences";
@@ -436,14 +631,30 @@ int CVS14M::Initialize()
 
 	// Camera modes to increase speed 
 
-	//if (ArtemisContinuousExposingModeSupported(hCam_))	//what is difference to ArtemisCanOverlapExposures?
+	// Continuous exposing: the exposure call reads out the CCD without clearing
+	// it first, so the camera integrates back-to-back between reads. Used by
+	// sequence acquisition whenever it is supported and allowed here.
+	if (ArtemisContinuousExposingModeSupported(hCam_))
+	{
+		continuousSupported_ = true;
+		pAct = new CPropertyAction(this, &CVS14M::OnContinuousExposing);
+		CreateIntegerProperty("ContinuousExposingSequence", 1, false, pAct);
+		AddAllowedValue("ContinuousExposingSequence","0");
+		AddAllowedValue("ContinuousExposingSequence","1");
+	}
+
 	//if (ArtemisCanOverlapExposures(hCam_))
 	if (pProp.cameraflags & ARTEMIS_PROPERTIES_CAMERAFLAGS_HAS_OVERLAP_MODE)
 	{
+		canOverlap_ = true;
 		pAct = new CPropertyAction(this, &CVS14M::OnOverlappedExposure);
 		CreateIntegerProperty("OverlappedExposure", 0, false, pAct);
 		AddAllowedValue("OverlappedExposure","0");
 		AddAllowedValue("OverlappedExposure","1");
+
+		// Frames in a hardware exposure sequence that didn't get the requested exposure
+		pAct = new CPropertyAction(this, &CVS14M::OnExposureSequenceMisses);
+		CreateIntegerProperty("ExposureSequenceMisses", 0, true, pAct);
 	}
 
 	if (pProp.cameraflags & ARTEMIS_PROPERTIES_CAMERAFLAGS_PREVIEW)
@@ -456,6 +667,186 @@ int CVS14M::Initialize()
 
 
 
+	// Frame pacing statistics for sequence acquisition (read only)
+	pAct = new CPropertyAction(this, &CVS14M::OnJitterMean);
+	CreateFloatProperty("FrameJitterMeanUs", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnJitterStd);
+	CreateFloatProperty("FrameJitterStdUs", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnJitterMax);
+	CreateFloatProperty("FrameJitterMaxUs", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnLateFrames);
+	CreateIntegerProperty("LateFrames", 0, true, pAct);
+
+	// Delivered frame rate, and latency from the camera having a frame to
+	// its delivery, for the last (or current) sequence (read only)
+	pAct = new CPropertyAction(this, &CVS14M::OnSequenceFrameRate);
+	CreateFloatProperty("SequenceFrameRate-fps", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnSequenceLatencyMean);
+	CreateFloatProperty("SequenceLatencyMean-ms", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnSequenceLatencyMax);
+	CreateFloatProperty("SequenceLatencyMax-ms", 0, true, pAct);
+
+	// Frames missing from a free-running sequence, judged from the camera's
+	// exposure start times
+	pAct = new CPropertyAction(this, &CVS14M::OnDroppedFrames);
+	CreateIntegerProperty("DroppedFrames", 0, true, pAct);
+
+	// Sum several exposures into each delivered frame (32-bit float)
+	pAct = new CPropertyAction(this, &CVS14M::OnAccumulateFrames);
+	CreateIntegerProperty("AccumulateFrames", accumulateFrames_, false, pAct);
+	SetPropertyLimits("AccumulateFrames", 1, FrameAccumulator::MaxExactFrames);	// float output stays exact
+	pAct = new CPropertyAction(this, &CVS14M::OnAccumulateVariance);
+	CreateStringProperty("AccumulateVariance", "No", false, pAct);
+	AddAllowedValue("AccumulateVariance", "No");
+	AddAllowedValue("AccumulateVariance", "Yes");
+
+	// Dark-frame subtraction and flat-field gain, captured from the camera
+	pAct = new CPropertyAction(this, &CVS14M::OnDarkCorrection);
+	CreateStringProperty("DarkCorrection", "Off", false, pAct);
+	AddAllowedValue("DarkCorrection", "Off");
+	AddAllowedValue("DarkCorrection", "On");
+	pAct = new CPropertyAction(this, &CVS14M::OnFlatCorrection);
+	CreateStringProperty("FlatCorrection", "Off", false, pAct);
+	AddAllowedValue("FlatCorrection", "Off");
+	AddAllowedValue("FlatCorrection", "On");
+	pAct = new CPropertyAction(this, &CVS14M::OnCorrectionFrames);
+	CreateIntegerProperty("CorrectionReferenceFrames", correctionFrames_, false, pAct);
+	SetPropertyLimits("CorrectionReferenceFrames", 1, 256);
+	pAct = new CPropertyAction(this, &CVS14M::OnCorrectionDir);
+	CreateStringProperty("CorrectionReferenceDir", "", false, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnCorrectionCommand);
+	CreateStringProperty("CorrectionCommand", "Idle", false, pAct);
+	AddAllowedValue("CorrectionCommand", "Idle");
+	AddAllowedValue("CorrectionCommand", "Capture dark");
+	AddAllowedValue("CorrectionCommand", "Capture flat");
+	AddAllowedValue("CorrectionCommand", "Save references");
+	AddAllowedValue("CorrectionCommand", "Load references");
+	AddAllowedValue("CorrectionCommand", "Clear references");
+	pAct = new CPropertyAction(this, &CVS14M::OnCorrectionStatus);
+	CreateStringProperty("CorrectionStatus", "", true, pAct);
+
+	// Hot pixels are found in the dark reference and repaired from their neighbours
+	pAct = new CPropertyAction(this, &CVS14M::OnHotPixelCorrection);
+	CreateStringProperty("HotPixelCorrection", "Off", false, pAct);
+	AddAllowedValue("HotPixelCorrection", "Off");
+	AddAllowedValue("HotPixelCorrection", "On");
+	pAct = new CPropertyAction(this, &CVS14M::OnHotPixelSigma);
+	CreateFloatProperty("HotPixelSigma", hotPixelSigma_, false, pAct);
+	SetPropertyLimits("HotPixelSigma", 2, 50);
+	pAct = new CPropertyAction(this, &CVS14M::OnHotPixelCount);
+	CreateIntegerProperty("HotPixelCount", 0, true, pAct);
+
+	// Statistics of the last frame read out, also put in sequence image metadata
+	pAct = new CPropertyAction(this, &CVS14M::OnFrameStatistics);
+	CreateStringProperty("FrameStatistics", "Off", false, pAct);
+	AddAllowedValue("FrameStatistics", "Off");
+	AddAllowedValue("FrameStatistics", "On");
+	pAct = new CPropertyAction(this, &CVS14M::OnFrameHistogram);
+	CreateStringProperty("FrameHistogram", "Off", false, pAct);
+	AddAllowedValue("FrameHistogram", "Off");
+	AddAllowedValue("FrameHistogram", "On");
+	pAct = new CPropertyAction(this, &CVS14M::OnFrameMin);
+	CreateIntegerProperty("FrameMin", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnFrameMax);
+	CreateIntegerProperty("FrameMax", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnFrameMean);
+	CreateFloatProperty("FrameMean", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnFrameStdDev);
+	CreateFloatProperty("FrameStdDev", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnFrameSaturated);
+	CreateIntegerProperty("FrameSaturatedPixels", 0, true, pAct);
+
+	// Closed-loop exposure: AutoExposurePercentile of each frame is brought to
+	// AutoExposureTarget-% of full scale, within MaximumExposureMs
+	pAct = new CPropertyAction(this, &CVS14M::OnAutoExposure);
+	CreateStringProperty("AutoExposure", "Off", false, pAct);
+	AddAllowedValue("AutoExposure", "Off");
+	AddAllowedValue("AutoExposure", "On");
+	pAct = new CPropertyAction(this, &CVS14M::OnAutoExposureTarget);
+	CreateFloatProperty("AutoExposureTarget-%", autoExposure_.GetTarget()*100, false, pAct);
+	SetPropertyLimits("AutoExposureTarget-%", 5, 95);
+	pAct = new CPropertyAction(this, &CVS14M::OnAutoExposurePercentile);
+	CreateFloatProperty("AutoExposurePercentile", autoExposure_.GetPercentile(), false, pAct);
+	SetPropertyLimits("AutoExposurePercentile", 50, 100);
+	pAct = new CPropertyAction(this, &CVS14M::OnAutoExposureDamping);
+	CreateFloatProperty("AutoExposureDamping", autoExposure_.GetDamping(), false, pAct);
+	SetPropertyLimits("AutoExposureDamping", 0, 0.95);
+
+	// Host-side NxM binning on top of the camera's own; edge remainders are cropped
+	pAct = new CPropertyAction(this, &CVS14M::OnSoftwareBinX);
+	CreateIntegerProperty("SoftwareBinningX", softBinX_, false, pAct);
+	SetPropertyLimits("SoftwareBinningX", 1, 16);
+	pAct = new CPropertyAction(this, &CVS14M::OnSoftwareBinY);
+	CreateIntegerProperty("SoftwareBinningY", softBinY_, false, pAct);
+	SetPropertyLimits("SoftwareBinningY", 1, 16);
+	pAct = new CPropertyAction(this, &CVS14M::OnSoftwareBinDepth);
+	CreateStringProperty("SoftwareBinningOutput", "16bit", false, pAct);
+	AddAllowedValue("SoftwareBinningOutput", "16bit");
+	AddAllowedValue("SoftwareBinningOutput", "32bit");
+
+	// Burst capture to RAM: sequence frames are held in a preallocated ring and
+	// passed to the core after the burst, or from a background thread
+	pAct = new CPropertyAction(this, &CVS14M::OnBurstMode);
+	CreateStringProperty("BurstMode", "Off", false, pAct);
+	AddAllowedValue("BurstMode", "Off");
+	AddAllowedValue("BurstMode", "Drain after burst");
+	AddAllowedValue("BurstMode", "Drain in background");
+	pAct = new CPropertyAction(this, &CVS14M::OnBurstCapacity);
+	CreateIntegerProperty("BurstCapacity", burstCapacity_, false, pAct);
+	SetPropertyLimits("BurstCapacity", 1, 10000);
+	pAct = new CPropertyAction(this, &CVS14M::OnBurstFramesHeld);
+	CreateIntegerProperty("BurstFramesHeld", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnBurstHighWater);
+	CreateIntegerProperty("BurstHighWater", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnBurstMemoryLocked);
+	CreateStringProperty("BurstMemoryLocked", "No", true, pAct);
+
+	// Stream to disk: StreamDir/VS14M_<date>_<time>_<n>.raw holds the frames
+	// back to back, the .json beside it their size and metadata
+	pAct = new CPropertyAction(this, &CVS14M::OnStreamToDisk);
+	CreateStringProperty("StreamToDisk", "Off", false, pAct);
+	AddAllowedValue("StreamToDisk", "Off");
+	AddAllowedValue("StreamToDisk", "Disk only");
+	AddAllowedValue("StreamToDisk", "Disk and core");
+	pAct = new CPropertyAction(this, &CVS14M::OnStreamDir);
+	CreateStringProperty("StreamDir", "", false, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnStreamBuffers);
+	CreateIntegerProperty("StreamBuffers", streamBuffers_, false, pAct);
+	SetPropertyLimits("StreamBuffers", 2, 64);
+	pAct = new CPropertyAction(this, &CVS14M::OnStreamBufferSize);
+	CreateIntegerProperty("StreamBufferSize-MB", streamBufferMB_, false, pAct);
+	SetPropertyLimits("StreamBufferSize-MB", 1, 256);
+	pAct = new CPropertyAction(this, &CVS14M::OnStreamFile);
+	CreateStringProperty("StreamFile", "", true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnStreamFramesWritten);
+	CreateIntegerProperty("StreamFramesWritten", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnStreamQueueDepth);
+	CreateIntegerProperty("StreamQueueDepth", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnStreamQueueHighWater);
+	CreateIntegerProperty("StreamQueueHighWater", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnStreamThroughput);
+	CreateFloatProperty("StreamThroughput-MB/s", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnStreamDirectIO);
+	CreateStringProperty("StreamDirectIO", "No", true, pAct);
+
+	// Lossless compression of 16-bit frames before they are streamed; the
+	// benchmark runs on the last frame read out
+	pAct = new CPropertyAction(this, &CVS14M::OnStreamCompression);
+	CreateStringProperty("StreamCompression", "Off", false, pAct);
+	AddAllowedValue("StreamCompression", "Off");
+	AddAllowedValue("StreamCompression", "Lossless");
+	pAct = new CPropertyAction(this, &CVS14M::OnCompressionThreads);
+	CreateIntegerProperty("CompressionThreads", codecThreads_, false, pAct);
+	SetPropertyLimits("CompressionThreads", 0, 32);
+	pAct = new CPropertyAction(this, &CVS14M::OnStreamCompressionRatio);
+	CreateFloatProperty("StreamCompressionRatio", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CVS14M::OnCompressionBenchmark);
+	CreateStringProperty("CompressionBenchmark", "Idle", false, pAct);
+	AddAllowedValue("CompressionBenchmark", "Idle");
+	AddAllowedValue("CompressionBenchmark", "Run");
+	pAct = new CPropertyAction(this, &CVS14M::OnCompressionBenchmarkResult);
+	CreateStringProperty("CompressionBenchmarkResult", "", true, pAct);
+
 	// synchronize all properties
 	// --------------------------
 	nRet = UpdateStatus();
@@ -501,8 +892,12 @@ int CVS14M::Shutdown()
 {
 	initialized_ = false;
 	StopSequenceAcquisition();
+	finishStream();
+	burst_.Release();
+	telemetry_->Stop();
 	ArtemisCoolerWarmUp(hCam_);
-	ArtemisDisconnectAll();
+	ArtemisDisconnect(hCam_);	// not DisconnectAll - other instances may be open
+	hCam_ = 0;
 	return DEVICE_OK;
 }
 
@@ -514,29 +909,56 @@ int CVS14M::Shutdown()
 */
 int CVS14M::SnapImage()
 {
-	static int callCounter = 0;
-	++callCounter;
+	applyAutoExposure();
+	if (accumulateFrames_ > 1)
+	{
+		// All but the last exposure are read here, GetImageBuffer reads the last
+		MMThreadGuard g(imgPixelsLock_);
+		accumulator_.Restart();
+		for (long i = 1; i < accumulateFrames_; i++)
+		{
+			int ret = snapFrame();
+			if (ret != DEVICE_OK)
+				return ret;
+			accumulateFrame(readFrame());
+		}
+	}
+	return snapFrame();
+}
 
+/**
+* Expose one frame, returning once the exposure has ended.
+*/
+int CVS14M::snapFrame()
+{
 	MM::MMTime startTime = GetCurrentMMTime();
 	double exp = GetExposure();
-	float exp_seconds = ((float) exp)/1000;
 	if (sequenceRunning_ && IsCapturing()) 
 	{
 		exp = GetSequenceExposure();
 	}
+	float exp_seconds = ((float) exp)/1000;
+	frameExposure_ = exp;
 
-	if (triggerDevice_.length() > 0) {
-		
-		int err = ArtemisTriggeredExposure(hCam_, true);
-		//send trigger signal.
-
-	}
-	else if  (overlapExposure_)
 	{
-		ArtemisStartOverlappedExposure(hCam_);
+		MMThreadGuard bus(busLock_);
+		if (gpioTrigger_) {
+			ArtemisStartExposure(hCam_, exp_seconds);
+			int ret = fireGpioTrigger();
+			if (ret != DEVICE_OK)
+				return ret;
+		}
+		else if (triggerDevice_.length() > 0) {
+			ArtemisTriggeredExposure(hCam_, true);
+			//send trigger signal.
+		}
+		else if  (overlapExposure_)
+		{
+			ArtemisStartOverlappedExposure(hCam_);
+		}
+		else
+			ArtemisStartExposure(hCam_, exp_seconds);
 	}
-	else
-		ArtemisStartExposure(hCam_, exp_seconds);
 
 	if (!overlapExposure_)
 	{
@@ -574,6 +996,77 @@ int CVS14M::SnapImage()
 * appropriate properties are set (such as binning, pixel type, etc.)
 */
 const unsigned char* CVS14M::GetImageBuffer()
+{
+	MMThreadGuard g(imgPixelsLock_);
+	const unsigned char* pixels = readFrame();
+	if (accumulateFrames_ <= 1)
+		return pixels;
+
+	accumulateFrame(pixels);
+	return accumImg_.GetPixels();
+}
+
+/**
+* Channel 1, when accumulating with variance, is the per-pixel variance of
+* the summed exposures. It is filled by reading channel 0.
+*/
+const unsigned char* CVS14M::GetImageBuffer(unsigned channelNr)
+{
+	if (channelNr == 0 || GetNumberOfChannels() < 2)
+		return GetImageBuffer();
+
+	MMThreadGuard g(imgPixelsLock_);
+	return varianceImg_.GetPixels();
+}
+
+unsigned CVS14M::GetNumberOfChannels() const
+{
+	return (accumulateFrames_ > 1 && accumulateVariance_) ? 2 : 1;
+}
+
+int CVS14M::GetChannelName(unsigned channel, char* name)
+{
+	CDeviceUtils::CopyLimitedString(name, (channel == 1) ? "Variance" : "Sum");
+	return DEVICE_OK;
+}
+
+/**
+* Add a frame to the accumulator; once the sum is complete, convert it (and
+* the variance) to the float output buffers.
+*/
+void CVS14M::accumulateFrame(const unsigned char* pixels)
+{
+	if (img_.Depth() == 1)
+		accumReady_ = accumulator_.Add(pixels);
+	else
+		accumReady_ = accumulator_.Add((const unsigned short*) pixels);
+
+	// Autoexposure judges the whole sum, from the histograms of its exposures
+	if (autoExposureEnabled_ && !capturingReference_)
+	{
+		const std::vector<unsigned int>& hist = stats_.GetHistogram();
+		if (accumulator_.GetCount() == 1 || aeHistogram_.size() != hist.size())
+			aeHistogram_ = hist;
+		else
+			for (size_t i = 0; i < hist.size(); ++i)
+				aeHistogram_[i] += hist[i];
+		if (accumReady_)
+			updateAutoExposure(aeHistogram_);
+	}
+
+	if (accumReady_)
+	{
+		accumulator_.SumToFloat((float*) accumImg_.GetPixelsRW());
+		if (accumulator_.HasVariance())
+			accumulator_.VarianceToFloat((float*) varianceImg_.GetPixelsRW());
+	}
+}
+
+/**
+* Wait for the exposed frame and download it into img_, applying the
+* flip/rotation and the dark/flat correction, and take its statistics.
+*/
+const unsigned char* CVS14M::readFrame()
 {
 	MMThreadGuard g(imgPixelsLock_);
 
@@ -583,9 +1076,26 @@ const unsigned char* CVS14M::GetImageBuffer()
 	//		return ARTEMIS_OPERATION_FAILED;
 
 	//}
-	while (!ArtemisImageReady(hCam_)) {}
-	if (overlapExposure_)
-		bool overlappedOK = ArtemisOverlappedExposureValid(hCam_);
+	// Poll without the bus lock so the telemetry thread is not shut out for
+	// the length of the exposure.
+	if (hwSequence_ && sequenceRunning_)
+	{
+		// Arm the next exposure of the sequence once this one has ended and
+		// the frame is downloading
+		double backoffUs = 100;
+		int state = ArtemisCameraState(hCam_);
+		while (state != CAMERA_DOWNLOADING && state != CAMERA_ERROR && !ArtemisImageReady(hCam_))
+		{
+			MonotonicClock::SleepUntilUs(MonotonicClock::NowUs() + backoffUs);
+			if (backoffUs < 1000)
+				backoffUs *= 2;
+			state = ArtemisCameraState(hCam_);
+		}
+		MMThreadGuard bus(busLock_);
+		armNextSequenceExposure();
+	}
+	waitImageReady(-1);
+	frameReadyUs_ = MonotonicClock::NowUs();
 
 	////Debug
 	//int dw = img_.Width();
@@ -595,7 +1105,16 @@ const unsigned char* CVS14M::GetImageBuffer()
 	unsigned short *pBuf;
 	unsigned short *nBuf;
 	pBuf = (unsigned short*) const_cast<unsigned char*>(img_.GetPixelsRW());
-	nBuf = (unsigned short*)ArtemisImageBuffer(hCam_);
+	{
+		MMThreadGuard bus(busLock_);
+		frameExposureValid_ = true;
+		if (overlapExposure_ || hwSequence_)
+			frameExposureValid_ = ArtemisOverlappedExposureValid(hCam_);
+		frameStartMs_ = lastExposureStartMs();
+		nBuf = (unsigned short*)ArtemisImageBuffer(hCam_);
+	}
+	bool correct = !capturingReference_ && img_.Depth() == 2 && correction_.IsActive();
+	frameScanned_ = false;
 	
 	if (flipUD_)
 		mirrorY(img_.Width(), img_.Height(), nBuf, pBuf);
@@ -615,10 +1134,25 @@ const unsigned char* CVS14M::GetImageBuffer()
         }
     }
 
+	else if (correct)
+	{
+		// corrected on the way out of the driver's buffer, no separate copy
+		correction_.Apply(nBuf, pBuf);
+		correct = false;
+	}
+	else if (statsEnabled_ || autoExposureEnabled_)
+		scanFrame((const unsigned char*) nBuf);	// statistics fused with the copy
 	else
 		memcpy(pBuf, nBuf, img_.Width()*img_.Height()*img_.Depth());
 
-	return img_.GetPixels();
+	if (correct)
+		correction_.Apply(pBuf, pBuf);
+	if ((statsEnabled_ || autoExposureEnabled_) && !frameScanned_)
+		scanFrame(0);
+	if (autoExposureEnabled_ && !capturingReference_ && accumulateFrames_ <= 1)
+		updateAutoExposure(stats_.GetHistogram());
+
+	return softBinning() ? binFrame() : img_.GetPixels();
 }
 
 /**
@@ -627,7 +1161,7 @@ const unsigned char* CVS14M::GetImageBuffer()
 */
 unsigned CVS14M::GetImageWidth() const
 {
-	return img_.Width();
+	return softBinning() ? binning_.GetOutputWidth() : img_.Width();
 }
 
 /**
@@ -636,7 +1170,7 @@ unsigned CVS14M::GetImageWidth() const
 */
 unsigned CVS14M::GetImageHeight() const
 {
-	return img_.Height();
+	return softBinning() ? binning_.GetOutputHeight() : img_.Height();
 }
 
 /**
@@ -645,7 +1179,7 @@ unsigned CVS14M::GetImageHeight() const
 */
 unsigned CVS14M::GetImageBytesPerPixel() const
 {
-	return img_.Depth();
+	return (accumulateFrames_ > 1 || (softBinning() && softBin32_)) ? 4 : img_.Depth();
 } 
 
 /**
@@ -665,7 +1199,7 @@ unsigned CVS14M::GetBitDepth() const
 */
 long CVS14M::GetImageBufferSize() const
 {
-	return img_.Width() * img_.Height() * GetImageBytesPerPixel();
+	return GetImageWidth() * GetImageHeight() * GetImageBytesPerPixel();
 }
 
 /**
@@ -684,6 +1218,15 @@ long CVS14M::GetImageBufferSize() const
 */
 int CVS14M::SetROI(unsigned x, unsigned y, unsigned xSize, unsigned ySize)
 {
+	// an ROI drawn on a software binned image
+	if (softBinning())
+	{
+		x *= softBinX_;
+		y *= softBinY_;
+		xSize *= softBinX_;
+		ySize *= softBinY_;
+	}
+
 	if (xSize == 0 && ySize == 0)
 	{
 		// effectively clear ROI
@@ -727,6 +1270,13 @@ int CVS14M::GetROI(unsigned& x, unsigned& y, unsigned& xSize, unsigned& ySize)
 	ySize = img_.Height();
 
 	img_.Resize(xSize,ySize);
+	if (softBinning())
+	{
+		x /= softBinX_;
+		y /= softBinY_;
+		xSize = binning_.GetOutputWidth();
+		ySize = binning_.GetOutputHeight();
+	}
 	//roiX_ = x;
 	//roiY_ = y;
 
@@ -902,11 +1452,29 @@ int CVS14M::AddToExposureSequence(double exposureTime_ms)
 	return DEVICE_OK;
 }
 
+/**
+* The camera has no sequence memory, so the list stays on the host. If the
+* camera can overlap exposures the sequence thread arms each entry with
+* ArtemisSetOverlappedExposureTime while the previous frame exposes and
+* downloads; otherwise each frame is started with its own exposure.
+*/
 int CVS14M::SendExposureSequence() const {
 	if (!isSequenceable_) {
 		return DEVICE_UNSUPPORTED_COMMAND;
 	}
 
+	if ((long) exposureSequence_.size() > sequenceMaxLength_)
+		return DEVICE_INVALID_INPUT_PARAM;
+
+	for (unsigned int i = 0; i < exposureSequence_.size(); ++i)
+	{
+		if (exposureSequence_[i] < 0 || exposureSequence_[i] > exposureMaximum_)
+			return DEVICE_INVALID_INPUT_PARAM;
+	}
+
+	if (!canOverlap_)
+		LogMessage("Camera cannot overlap exposures, exposure sequence will be run from software", true);
+
 	return DEVICE_OK;
 }
 
@@ -983,8 +1551,59 @@ int CVS14M::StartSequenceAcquisition(long numImages, double interval_ms, bool st
 		return ret;
 	sequenceStartTime_ = GetCurrentMMTime();
 	imageCounter_ = 0;
+	gapDetector_.Reset();
+	startTimeBaseMs_ = 0;
+	lastStartMs_ = 0;
+	accumulator_.Restart();
+	accumReady_ = false;
+	ret = resolveTriggerDevice();
+	if (ret != DEVICE_OK)
+		return ret;
+	ret = startBurst(numImages);
+	if (ret != DEVICE_OK)
+		return ret;
+	ret = startStream(numImages);
+	if (ret != DEVICE_OK)
+		return ret;
+
+	// Hardware exposure sequencing: arm the first exposure now, each frame
+	// then arms its successor while it downloads.
+	hwSequence_ = sequenceRunning_ && canOverlap_ && (exposureSequence_.size() > 0);
+	exposureSequenceMisses_ = 0;
+	if (hwSequence_)
+	{
+		armedExposure_ = -1;
+		armNextSequenceExposure();
+	}
+
+	// Continuous exposing: each read ends one exposure and starts the next, so
+	// frames are paced at the exposure time (or the interval, if longer).
+	continuousSequence_ = continuousSupported_ && continuousAllowed_ && !hwSequence_
+		&& !sequenceRunning_ && !gpioTrigger_ && (triggerDev_ == 0);
+	if (continuousSequence_)
+	{
+		if (interval_ms < GetExposure())
+			interval_ms = GetExposure();
+		ret = startContinuousExposing();
+		if (ret != DEVICE_OK)
+		{
+			continuousSequence_ = false;
+			return ret;
+		}
+	}
+
+	pacer_.Start(interval_ms);
+	if (continuousSequence_)
+		pacer_.WaitForNextFrame();	//the flush read above was frame 0
+	{
+		MMThreadGuard g(pacerLock_);
+		pacingStats_ = FramePacingStats();
+		rateMeter_.Start();
+	}
+	stopOnOverflow_ = stopOnOverflow;	// read by both threads
+	if (burstActive_ && burstBackground_)
+		burstDrain_->Start();
 	thd_->Start(numImages,interval_ms);
-	stopOnOverflow_ = stopOnOverflow;
 	return DEVICE_OK;
 }
 
@@ -1016,10 +1635,107 @@ int CVS14M::InsertImage()
 	const unsigned char* pI;
 	pI = GetImageBuffer();
 
+	md.put(MM::g_Keyword_Exposure, CDeviceUtils::ConvertToString(frameExposure_));
+
+	// Exposure start as recorded by the camera driver
+	double startMs = frameStartMs_ + startTimeBaseMs_;
+	if (imageCounter_ > 1 && startMs + 12*3600*1000.0 < lastStartMs_)
+	{
+		startTimeBaseMs_ += 24*3600*1000.0;	//passed midnight
+		startMs += 24*3600*1000.0;
+	}
+	lastStartMs_ = startMs;
+	md.put("CameraStartTime-ms", CDeviceUtils::ConvertToString(startMs));
+
+	// Frames missing from the sequence according to those start times. Only
+	// free-running frames are spaced at a known interval; otherwise the
+	// spacing follows the trigger, the exposure sequence or the host, and a
+	// long gap is not a lost frame. The start times are too coarse to tell
+	// shorter intervals apart.
+	double intervalMs = pacer_.GetIntervalMs();
+	if (continuousSequence_ && intervalMs >= g_MinGapIntervalMs)
+	{
+		long missed = gapDetector_.AddTimestamp(startMs*1000, intervalMs*1000);
+		if (missed > 0)
+			LogMessage("Gap in exposure start times, " + boost::lexical_cast<std::string>(missed) + " frame(s) missing", true);
+		md.put("DroppedFrames", CDeviceUtils::ConvertToString(gapDetector_.GetDropped()));
+	}
+
+	if (hwSequence_)
+	{
+		md.put("ExposureValid", frameExposureValid_ ? "1" : "0");
+		if (!frameExposureValid_)
+			++exposureSequenceMisses_;
+	}
+
+	if (statsEnabled_)
+		putFrameStatistics(md);
+	if (autoExposureEnabled_)
+		md.put("AutoExposureLevel-%", CDeviceUtils::ConvertToString(autoExposure_.GetLevel()*100));
+	if (softBinning())
+	{
+		std::ostringstream os;
+		os << softBinX_ << "x" << softBinY_;
+		md.put("SoftwareBinning", os.str());
+	}
+
+	if (accumulateFrames_ <= 1)
+		return insertIntoCore(pI, md);
+
+	// Accumulating: only complete sums go to the core
+	if (!accumReady_)
+		return DEVICE_OK;
+	md.put("AccumulatedFrames", CDeviceUtils::ConvertToString(accumulateFrames_));
+	if (!accumulateVariance_)
+		return insertIntoCore(pI, md);
+
+	md.put(MM::g_Keyword_CameraChannelIndex, "0");
+	md.put(MM::g_Keyword_CameraChannelName, "Sum");
+	int ret = insertIntoCore(pI, md);
+	if (ret != DEVICE_OK)
+		return ret;
+	md.put(MM::g_Keyword_CameraChannelIndex, "1");
+	md.put(MM::g_Keyword_CameraChannelName, "Variance");
+	return insertIntoCore(varianceImg_.GetPixels(), md);
+}
+
+int CVS14M::insertIntoCore(const unsigned char* pI, Metadata& md)
+{
 	unsigned int w = GetImageWidth();
 	unsigned int h = GetImageHeight();
 	unsigned int b = GetImageBytesPerPixel();
 
+	if (streamActive_)
+	{
+		bool written;
+		if (streamPacked_)
+		{
+			size_t bytes = codec_.Compress((const unsigned short*) pI, w, h, &packed_[0]);
+			streamRawBytes_ += (double) w*h*b;
+			streamPackedBytes_ += bytes;
+			written = stream_.WriteRecord(&packed_[0], bytes, MetadataToJson(md));
+		}
+		else
+			written = stream_.Write(pI, MetadataToJson(md));
+		if (!written)
+		{
+			LogMessage("Stream to disk: " + stream_.GetError(), false);
+			return ERR_STREAM_FILE;
+		}
+		if (!streamToCore_)
+			return DEVICE_OK;
+	}
+
+	if (burstActive_)
+	{
+		if (!burst_.Push(pI, w, h, b, md.Serialize()))
+		{
+			LogMessage("Burst ring full after " + boost::lexical_cast<std::string>(burst_.Capacity()) + " frames", false);
+			return ERR_BURST_FULL;
+		}
+		return DEVICE_OK;
+	}
+
 	int ret = GetCoreCallback()->InsertImage(this, pI, w, h, b, md.Serialize().c_str());
 	if (!stopOnOverflow_ && ret == DEVICE_BUFFER_OVERFLOW)
 	{
@@ -1031,40 +1747,192 @@ int CVS14M::InsertImage()
 		return ret;
 }
 
+/**
+* Poll the camera until the exposed frame is ready for download, backing off
+* from 0.1 ms to 1 ms between polls. The bus lock is not taken, so other
+* threads can talk to the camera meanwhile. A negative timeout waits
+* indefinitely. Returns false if the frame was not ready in time.
+*/
+bool CVS14M::waitImageReady(double timeoutMs)
+{
+	double startUs = MonotonicClock::NowUs();
+	double backoffUs = 100;
+	while (!ArtemisImageReady(hCam_))
+	{
+		double nowUs = MonotonicClock::NowUs();
+		if (timeoutMs >= 0 && nowUs - startUs > timeoutMs*1000)
+			return false;
+		MonotonicClock::SleepUntilUs(nowUs + backoffUs);
+		if (backoffUs < 1000)
+			backoffUs *= 2;
+	}
+	return true;
+}
+
+/**
+* Start of the last exposure in milliseconds since midnight, from the time
+* string and millisecond part recorded by the Artemis driver. The driver
+* only claims ~0.1 s accuracy. Returns 0 if the time can't be parsed.
+*/
+double CVS14M::lastExposureStartMs()
+{
+	const char* startTime = ArtemisLastStartTime(hCam_);
+	if (startTime == 0)
+		return 0;
+
+	// use the last hh:mm:ss in the string, whatever date format precedes it
+	int hh = 0, mm = 0, ss = 0;
+	bool found = false;
+	for (const char* p = startTime; *p != 0; ++p)
+	{
+		int h, m, s;
+		if (sscanf(p, "%2d:%2d:%2d", &h, &m, &s) == 3)
+		{
+			hh = h; mm = m; ss = s;
+			found = true;
+			p = strchr(p, ':') + 1;
+			p = strchr(p, ':');
+		}
+	}
+	if (!found)
+		return 0;
+
+	return ((hh*60.0 + mm)*60.0 + ss)*1000.0 + ArtemisLastStartTimeMilliseconds(hCam_);
+}
+
+/**
+* Switch the camera into continuous exposing mode and do one read to flush
+* the charge collected since the last clear. The first harvested frame then
+* has a full exposure.
+*/
+int CVS14M::startContinuousExposing()
+{
+	int camErr = ArtemisSetContinuousExposingMode(hCam_, true);
+	if (camErr != ARTEMIS_OK)
+	{
+		LogMessage("ArtemisSetContinuousExposingMode failed, error " + boost::lexical_cast<std::string>(camErr));
+		return ERR_CONTINUOUS_EXPOSING;
+	}
+
+	ArtemisStartExposure(hCam_, (float) GetExposure()/1000);
+	if (!waitImageReady(GetExposure() + 5000))
+	{
+		LogMessage("Timed out flushing the sensor for continuous exposing");
+		ArtemisAbortExposure(hCam_);
+		ArtemisSetContinuousExposingMode(hCam_, overlapExposure_);
+		return ERR_CONTINUOUS_EXPOSING;
+	}
+	return DEVICE_OK;
+}
+
+/**
+* Take the next exposure from the sequence and set it as the overlapped
+* exposure time, so that it applies to the exposure which starts while the
+* current frame is downloading. The camera is only told when the value
+* actually changes.
+*/
+void CVS14M::armNextSequenceExposure()
+{
+	nextSequenceExposure_ = GetSequenceExposure();
+	if (nextSequenceExposure_ != armedExposure_)
+	{
+		ArtemisSetOverlappedExposureTime(hCam_, (float) nextSequenceExposure_/1000);
+		armedExposure_ = nextSequenceExposure_;
+	}
+}
+
 /*
 * Do actual capturing
 * Called from inside the thread  
 */
-int CVS14M::RunSequenceOnThread(MM::MMTime startTime)
+int CVS14M::RunSequenceOnThread(MM::MMTime /*startTime*/)
+{
+	// When accumulating, one delivered image takes several exposures, all
+	// at the same exposure time
+	applyAutoExposure();
+	int ret;
+	do
+	{
+		ret = runSequenceFrame();
+	} while (ret == DEVICE_OK && accumulateFrames_ > 1 && !accumReady_ && !thd_->IsStopped());
+
+	if (ret == DEVICE_OK && (accumulateFrames_ <= 1 || accumReady_))
+	{
+		MMThreadGuard g(pacerLock_);
+		rateMeter_.AddFrame(frameReadyUs_);
+	}
+	return ret;
+}
+
+/*
+* Expose and read one frame of a sequence
+*/
+int CVS14M::runSequenceFrame()
 {
 	int ret=DEVICE_ERR;
 
-	double exp = GetExposure();
-	float exp_seconds = ((float) exp)/1000;		//seems cumbersome to do every time...
+	// Take this frame's exposure exactly once - GetSequenceExposure() advances
+	// the sequence index every time it is called.
+	double exp;
+	if (hwSequence_)
+		exp = nextSequenceExposure_;	// already armed on the camera
+	else
+		exp = sequenceRunning_ ? GetSequenceExposure() : GetExposure();
+	float exp_seconds = ((float) exp)/1000;
+	frameExposure_ = exp;
 
-	// Trigger
-	if (triggerDevice_.length() > 0) {
-		MM::Device* triggerDev = GetDevice(triggerDevice_.c_str());
-		if (triggerDev != 0) {
-			LogMessage("trigger requested");
-			
-			std::string dummy = triggerDevice_;
-			triggerDev->SetProperty("Trigger","+");
+	// Hold off until this frame's absolute deadline (no-op for interval 0)
+	pacer_.WaitForNextFrame();
+	{
+		MMThreadGuard g(pacerLock_);
+		pacingStats_ = pacer_.GetStats();
+	}
+
+	if (continuousSequence_)
+	{
+		// The camera has been integrating since the previous read; this read
+		// ends the frame and the next exposure starts straight away.
+		frameExposure_ = pacer_.GetIntervalMs();
+		{
+			MMThreadGuard bus(busLock_);
+			ArtemisStartExposure(hCam_, exp_seconds);
 		}
-	//send trigger signal
+		ret = InsertImage();
+		telemetry_->SignalBusIdle();	//nothing to read until the next deadline
+		return ret;
 	}
-	else
-		ArtemisStartExposure(hCam_, exp_seconds);
-	
 
-	ret = InsertImage();
+	{
+		MMThreadGuard bus(busLock_);
 
+		// Start exposure, unless an external device is triggering the camera.
+		// The next exposure of a hardware sequence is armed by readFrame.
+		if (triggerDev_ == 0)
+		{
+			if (hwSequence_)
+				ArtemisStartOverlappedExposure(hCam_);
+			else
+				ArtemisStartExposure(hCam_, exp_seconds);
+		}
 
-	while (((double) (this->GetCurrentMMTime() - startTime).getMsec() / imageCounter_) < this->GetSequenceExposure())
-	{
-		CDeviceUtils::SleepMs(1);
+		// Trigger
+		if (gpioTrigger_) {
+			ret = fireGpioTrigger();
+			if (ret != DEVICE_OK)
+				return ret;
+		}
+		else if (triggerDev_ != 0) {
+			//send trigger signal
+			triggerDev_->SetProperty("Trigger","+");
+		}
 	}
 
+	// The camera is exposing; no USB traffic until the image is ready
+	telemetry_->SignalBusIdle();
+	
+
+	ret = InsertImage();
+
 	if (ret != DEVICE_OK)
 	{
 		return ret;
@@ -1084,6 +1952,17 @@ void CVS14M::OnThreadExiting() throw()
 	try
 	{
 		LogMessage(g_Msg_SEQUENCE_ACQUISITION_THREAD_EXITING);
+
+		FrameRateStats rate;
+		{
+			MMThreadGuard g(pacerLock_);
+			rate = rateMeter_.GetStats();
+		}
+		std::ostringstream os;
+		os << "Sequence delivered " << rate.frames << " frames at " << rate.fps << " fps, latency mean "
+			<< rate.meanLatencyUs/1000 << " ms, max " << rate.maxLatencyUs/1000 << " ms";
+		LogMessage(os.str(), false);
+
 		GetCoreCallback()?GetCoreCallback()->AcqFinished(this,0):DEVICE_OK;
 	}
 	catch(...)
@@ -1157,6 +2036,9 @@ int MySequenceThread::svc(void) throw()
 		} while (DEVICE_OK == ret && !IsStopped() && imageCounter_++ < numImages_-1);
 		if (IsStopped())
 			camera_->LogMessage("SeqAcquisition interrupted by the user\n");
+		camera_->finishBurst();	// hand over whatever is still held in RAM
+		camera_->finishStream();
+		camera_->finishSequenceModes();
 	}catch(...){
 		camera_->LogMessage(g_Msg_EXCEPTION_IN_THREAD, false);
 	}
@@ -1167,20 +2049,157 @@ int MySequenceThread::svc(void) throw()
 }
 
 
-///////////////////////////////////////////////////////////////////////////////
-// CVS14M Action handlers
-///////////////////////////////////////////////////////////////////////////////
+BurstDrainThread::BurstDrainThread(CVS14M* pCam)
+	:camera_(pCam)
+	,stop_(true)
+{};
 
-int CVS14M::OnMaxExposure(MM::PropertyBase* pProp, MM::ActionType eAct)
+BurstDrainThread::~BurstDrainThread()
 {
-	if (eAct == MM::BeforeGet)
-	{
-		pProp->Set(exposureMaximum_);
-	}
-	else if (eAct == MM::AfterSet)
-	{
-		pProp->Get(exposureMaximum_);
-	}
+	Stop();
+};
+
+void BurstDrainThread::Start()
+{
+	MMThreadGuard g(this->stopLock_);
+	if (!stop_)
+		return;
+	stop_ = false;
+	activate();
+}
+
+/**
+* Stop and wait for the thread to exit. Frames still in the ring are left
+* there for the sequence thread to pass on.
+*/
+void BurstDrainThread::Stop()
+{
+	{
+		MMThreadGuard g(this->stopLock_);
+		if (stop_)
+			return;
+		stop_ = true;
+	}
+	wait();
+}
+
+bool BurstDrainThread::IsStopped()
+{
+	MMThreadGuard g(this->stopLock_);
+	return stop_;
+}
+
+int BurstDrainThread::svc(void) throw()
+{
+	try
+	{
+		while (!IsStopped())
+		{
+			if (!camera_->drainBurstFrame())
+				CDeviceUtils::SleepMs(default_idleMS);
+		}
+	}catch(...){
+		camera_->LogMessage("Exception in burst drain thread", false);
+	}
+	return 0;
+}
+
+
+TelemetryThread::TelemetryThread(CVS14M* pCam)
+	:camera_(pCam)
+	,samplePeriodMs_(default_samplePeriodMS)
+	,stop_(true)
+{
+};
+
+TelemetryThread::~TelemetryThread()
+{
+	Stop();
+};
+
+void TelemetryThread::Start()
+{
+	MMThreadGuard g(this->stopLock_);
+	if (!stop_)
+		return;
+	stop_ = false;
+	activate();
+}
+
+/**
+* Stop and wait for the thread to exit
+*/
+void TelemetryThread::Stop()
+{
+	{
+		MMThreadGuard g(this->stopLock_);
+		if (stop_)
+			return;
+		stop_ = true;
+	}
+	idleEvent_.Set();
+	wait();
+}
+
+bool TelemetryThread::IsStopped()
+{
+	MMThreadGuard g(this->stopLock_);
+	return stop_;
+}
+
+/**
+* Called by the sequence thread when it will not use the USB link for a while
+*/
+void TelemetryThread::SignalBusIdle()
+{
+	idleEvent_.Set();
+}
+
+int TelemetryThread::svc(void) throw()
+{
+	LowerCurrentThreadPriority();
+
+	double t0 = MonotonicClock::NowUs();
+	double lastSampleUs = t0 - samplePeriodMs_*1000;
+	try
+	{
+		while (!IsStopped())
+		{
+			bool busIdle = idleEvent_.Wait(samplePeriodMs_);
+			if (IsStopped())
+				break;
+
+			// During a sequence only the sequence thread knows when the bus is free
+			if (camera_->IsCapturing() && !busIdle)
+				continue;
+
+			double now = MonotonicClock::NowUs();
+			if (now - lastSampleUs < samplePeriodMs_*1000)
+				continue;
+
+			if (camera_->sampleTelemetry((now - t0)/1.0e6) == DEVICE_OK)
+				lastSampleUs = now;
+		}
+	}catch(...){
+		camera_->LogMessage("Exception in telemetry thread", false);
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CVS14M Action handlers
+///////////////////////////////////////////////////////////////////////////////
+
+int CVS14M::OnMaxExposure(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(exposureMaximum_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		pProp->Get(exposureMaximum_);
+	}
 	return DEVICE_OK;
 }
 
@@ -1494,18 +2513,51 @@ int CVS14M::OnTriggerDevice(MM::PropertyBase* pProp, MM::ActionType eAct)
 	return DEVICE_OK;
 }
 
-int CVS14M::OnCCDTemp(MM::PropertyBase* pProp, MM::ActionType eAct)
+int CVS14M::OnTriggerSource(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(gpioTrigger_ ? g_TriggerSource_GPIO : g_TriggerSource_Device);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if(IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+
+		std::string val;
+		pProp->Get(val);
+		return setGpioTrigger(val == g_TriggerSource_GPIO);
+	}
+	return DEVICE_OK;
+}
+
+int CVS14M::OnGpioTriggerLine(MM::PropertyBase* pProp, MM::ActionType eAct)
 {
 	if (eAct == MM::BeforeGet)
 	{
+		pProp->Set(gpioTriggerLine_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if(IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
 
-		GetCurrentTemperature();
+		pProp->Get(gpioTriggerLine_);
+		if (gpioTrigger_)
+			return setGpioTrigger(true);	// move output to the new line
+	}
+	return DEVICE_OK;
+}
+
+int CVS14M::OnCCDTemp(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
 		pProp->Set(ccdT_);
 
 	}
 	else if (eAct == MM::AfterSet)
 	{
-		GetCurrentTemperature();
 		TemperatureContol();
 		//if (ccdT_ < ambientTemp_){
 		//	
@@ -1555,6 +2607,8 @@ int CVS14M::OnFlipUD(MM::PropertyBase* pProp, MM::ActionType eAct)
       long tvalue = 0;
       pProp->Get(tvalue);
 		flipUD_ = (0==tvalue)?false:true;
+		MMThreadGuard g(imgPixelsLock_);
+		selectCorrection();
    }
    else if (eAct == MM::BeforeGet)
    {
@@ -1571,6 +2625,8 @@ int CVS14M::OnFlipLR(MM::PropertyBase* pProp, MM::ActionType eAct)
       long tvalue = 0;
       pProp->Get(tvalue);
 		flipLR_ = (0==tvalue)?false:true;
+		MMThreadGuard g(imgPixelsLock_);
+		selectCorrection();
    }
    else if (eAct == MM::BeforeGet)
    {
@@ -1920,156 +2976,1430 @@ int CVS14M::OnPreviewMode(MM::PropertyBase* pProp, MM::ActionType eAct)
    return DEVICE_OK;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// Private CVS14M methods
-///////////////////////////////////////////////////////////////////////////////
-
-/**
-* Sync internal image buffer size to the chosen property values.
-*/
-int CVS14M::ResizeImageBuffer()
+int CVS14M::OnJitterMean(MM::PropertyBase* pProp, MM::ActionType eAct)
 {
-	char buf[MM::MaxStrLength];
-	//int ret = GetProperty(MM::g_Keyword_Binning, buf);
-	//if (ret != DEVICE_OK)
-	//   return ret;
-	//binSizeX_ = atol(buf);
-
-	int ret = GetProperty(MM::g_Keyword_PixelType, buf);
-	if (ret != DEVICE_OK)
-		return ret;
-
-	std::string pixelType(buf);
-	int byteDepth = 0;
-
-	if (pixelType.compare(g_PixelType_8bit) == 0)
-	{
-		byteDepth = 1;
-	}
-	else if (pixelType.compare(g_PixelType_16bit) == 0)
-	{
-		byteDepth = 2;
-	}
-	else if ( pixelType.compare(g_PixelType_32bitRGB) == 0)
-	{
-		byteDepth = 4;
-	}
-	else if ( pixelType.compare(g_PixelType_32bit) == 0)
-	{
-		byteDepth = 4;
-	}
-	else if ( pixelType.compare(g_PixelType_64bitRGB) == 0)
+	if (eAct == MM::BeforeGet)
 	{
-		byteDepth = 8;
+		MMThreadGuard g(pacerLock_);
+		pProp->Set(pacingStats_.meanJitterUs);
 	}
 
-    if ((imageRotationAngle_ == 90) || (imageRotationAngle_ == 270))
-        img_.Resize(cameraCCDYSize_/binSizeY_, cameraCCDXSize_/binSizeX_, byteDepth);
-    else
-		//img_.Resize(roiW_/binSizeX_, roiH_/binSizeY_, byteDepth);
-		img_.Resize(roiW_, roiH_, byteDepth);
-
-
 	return DEVICE_OK;
 }
 
-void CVS14M::GenerateEmptyImage(ImgBuffer& img)
+int CVS14M::OnJitterStd(MM::PropertyBase* pProp, MM::ActionType eAct)
 {
-	MMThreadGuard g(imgPixelsLock_);
-	if (img.Height() == 0 || img.Width() == 0 || img.Depth() == 0)
-		return;
-	unsigned char* pBuf = const_cast<unsigned char*>(img.GetPixels());
-	memset(pBuf, 0, img.Height()*img.Width()*img.Depth());
-}
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(pacerLock_);
+		pProp->Set(pacingStats_.stdJitterUs);
+	}
 
-void CVS14M::TestResourceLocking(const bool recurse)
-{
-	if(recurse)
-		TestResourceLocking(false);
+	return DEVICE_OK;
 }
 
-void CVS14M::rotate90(int original_xsize, int original_ysize, unsigned short *in_arr, unsigned short *out_arr){
-
-	int xsize = original_ysize;
-	int ysize = original_xsize;	//swapped here for clairty...
-	for (int y = 0; y < ysize; ++y){
-		for (int x = 0, destx = xsize-1; x<xsize; ++x, --destx){
-			out_arr[y * xsize + destx] = in_arr[x * ysize + y];
-		}
+int CVS14M::OnJitterMax(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(pacerLock_);
+		pProp->Set(pacingStats_.maxJitterUs);
 	}
-}
 
-void CVS14M::rotate180(int original_xsize, int original_ysize, unsigned short *in_arr, unsigned short *out_arr){
-
-	for (int i = 0; i < original_xsize*original_ysize; ++i){
-		out_arr[original_xsize*original_ysize - 1 -i] = in_arr[i];
-	}
+	return DEVICE_OK;
 }
 
-void CVS14M::rotate270(int original_xsize, int original_ysize, unsigned short *in_arr, unsigned short *out_arr){
-
-	int xsize = original_ysize;
-	int ysize = original_xsize;	//swapped here for clairty...
-	for (int x = 0; x < xsize; ++x){
-		for (int y = 0, desty = ysize-1; y<ysize; ++y, --desty){
-			out_arr[x + desty*xsize] = in_arr[x * ysize + y];
-		}
+int CVS14M::OnLateFrames(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(pacerLock_);
+		pProp->Set(pacingStats_.lateFrames);
 	}
-}
-
-void CVS14M::mirrorY(int original_xsize, int original_ysize, unsigned short *in_arr, unsigned short *out_arr){
 
-	for (int x = 0; x < original_xsize; ++x){
-		for (int y = 0, desty = original_ysize - 1; y < original_ysize; ++y, --desty){
-			out_arr[desty * original_xsize + x] = in_arr[y * original_xsize + x];
-		}
-	}
+	return DEVICE_OK;
 }
 
-void CVS14M::mirrorX(int original_xsize, int original_ysize, unsigned short *in_arr, unsigned short *out_arr){
-
-	for (int y = 0; y < original_ysize; ++y){
-		for (int x = 0, destx = original_xsize - 1; x < original_xsize; ++x, --destx){
-			out_arr[y * original_xsize + destx] = in_arr[y * original_xsize + x];
-		}
+int CVS14M::OnSequenceFrameRate(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(pacerLock_);
+		pProp->Set(rateMeter_.GetStats().fps);
 	}
-}
 
+	return DEVICE_OK;
+}
 
-int TransposeProcessor::Initialize()
+int CVS14M::OnSequenceLatencyMean(MM::PropertyBase* pProp, MM::ActionType eAct)
 {
-
-
-	if( NULL != this->pTemp_)
+	if (eAct == MM::BeforeGet)
 	{
-		free(pTemp_);
-		pTemp_ = NULL;
-		this->tempSize_ = 0;
+		MMThreadGuard g(pacerLock_);
+		pProp->Set(rateMeter_.GetStats().meanLatencyUs/1000);
 	}
-	CPropertyAction* pAct = new CPropertyAction (this, &TransposeProcessor::OnInPlaceAlgorithm);
-	(void)CreateIntegerProperty("InPlaceAlgorithm", 0, false, pAct);
+
 	return DEVICE_OK;
 }
 
-// action interface
-// ----------------
-int TransposeProcessor::OnInPlaceAlgorithm(MM::PropertyBase* pProp, MM::ActionType eAct)
+int CVS14M::OnSequenceLatencyMax(MM::PropertyBase* pProp, MM::ActionType eAct)
 {
 	if (eAct == MM::BeforeGet)
 	{
-		pProp->Set(this->inPlace_?1L:0L);
+		MMThreadGuard g(pacerLock_);
+		pProp->Set(rateMeter_.GetStats().maxLatencyUs/1000);
 	}
-	else if (eAct == MM::AfterSet)
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnCCDTempReadout(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
 	{
-		long ltmp;
-		pProp->Get(ltmp);
-		inPlace_ = (0==ltmp?false:true);
+		pProp->Set((double) tempCenti_/100);
 	}
 
 	return DEVICE_OK;
 }
 
-
+int CVS14M::OnCoolerPower(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) coolerPower_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnCoolerSetpoint(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((double) coolerSetpointCenti_/100);
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Spread (max - min) of the CCD temperature over the history, oC
+*/
+int CVS14M::OnTemperatureDrift(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(telemetryLock_);
+		double tmin = 0, tmax = 0;
+		for (long i = 0; i < telemetryCount_; ++i)
+		{
+			double t = telemetryHistory_[i].temperature;
+			if (i == 0 || t < tmin) tmin = t;
+			if (i == 0 || t > tmax) tmax = t;
+		}
+		pProp->Set(tmax - tmin);
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* History as "seconds:temperature:cooler%" entries, oldest first
+*/
+int CVS14M::OnTemperatureHistory(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(telemetryLock_);
+		long n = (long) telemetryHistory_.size();
+		std::ostringstream os;
+		os.setf(std::ios::fixed);
+		for (long i = 0; i < telemetryCount_; ++i)
+		{
+			const TelemetrySample& s = telemetryHistory_[(telemetryHead_ - telemetryCount_ + i + n) % n];
+			os.precision(0);
+			os << s.timeS << ":";
+			os.precision(2);
+			os << s.temperature << ":" << s.coolerLevel << ";";
+		}
+		std::string hist = os.str();
+		if (hist.length() >= MM::MaxStrLength)
+			hist = hist.substr(hist.length() - MM::MaxStrLength + 1);	//keep the newest
+		pProp->Set(hist.c_str());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnDroppedFrames(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(gapDetector_.GetDropped());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnAccumulateFrames(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(accumulateFrames_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		long frames;
+		pProp->Get(frames);
+		if (frames > 1 && softBin32_ && binning_.IsActive())
+			return ERR_BINNING_ACCUMULATE;
+		accumulateFrames_ = frames;
+		return ResizeImageBuffer();
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnAccumulateVariance(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(accumulateVariance_ ? "Yes" : "No");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		std::string val;
+		pProp->Get(val);
+		accumulateVariance_ = (val == "Yes");
+		return ResizeImageBuffer();
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnDarkCorrection(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(correction_.IsDarkEnabled() ? "On" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		MMThreadGuard g(imgPixelsLock_);
+		correction_.EnableDark(val == "On");
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnFlatCorrection(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(correction_.IsFlatEnabled() ? "On" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		MMThreadGuard g(imgPixelsLock_);
+		correction_.EnableFlat(val == "On");
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnCorrectionFrames(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(correctionFrames_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		pProp->Get(correctionFrames_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnCorrectionDir(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(correctionDir_.c_str());
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		pProp->Get(correctionDir_);
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Capture the dark (shutter closed) or flat (uniform illumination) reference
+* for the current binning/ROI, or save, load or clear the references. The
+* dark is taken off the flat, so capture the dark first.
+*/
+int CVS14M::OnCorrectionCommand(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set("Idle");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		int ret = DEVICE_OK;
+		if (val == "Capture dark")
+			ret = captureReference(true);
+		else if (val == "Capture flat")
+			ret = captureReference(false);
+		else if (val == "Save references" || val == "Load references")
+		{
+			if (correctionDir_.empty())
+				return ERR_CORRECTION_FILE;
+			MMThreadGuard g(imgPixelsLock_);
+			bool ok = (val == "Save references") ? correction_.Save(correctionFile()) : correction_.Load(correctionFile());
+			if (!ok)
+				ret = ERR_CORRECTION_FILE;
+		}
+		else if (val == "Clear references")
+		{
+			MMThreadGuard g(imgPixelsLock_);
+			correction_.ClearDark();
+			correction_.ClearFlat();
+			correction_.ClearHotPixels();
+		}
+		pProp->Set("Idle");
+		return ret;
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnHotPixelCorrection(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(correction_.IsHotPixelEnabled() ? "On" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		MMThreadGuard g(imgPixelsLock_);
+		correction_.EnableHotPixels(val == "On");
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Takes effect with the next dark capture
+*/
+int CVS14M::OnHotPixelSigma(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(hotPixelSigma_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		pProp->Get(hotPixelSigma_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnHotPixelCount(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) correction_.GetHotPixelCount());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnFrameStatistics(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(statsEnabled_ ? "On" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		MMThreadGuard g(imgPixelsLock_);
+		statsEnabled_ = (val == "On");
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnFrameHistogram(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(histogramEnabled_ ? "On" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		MMThreadGuard g(imgPixelsLock_);
+		histogramEnabled_ = (val == "On");
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnAutoExposure(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(autoExposureEnabled_ ? "On" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		MMThreadGuard g(imgPixelsLock_);
+		autoExposureEnabled_ = (val == "On");
+		autoExposurePending_ = 0;
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnAutoExposureTarget(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(autoExposure_.GetTarget()*100);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		double target;
+		pProp->Get(target);
+		autoExposure_.SetTarget(target/100);
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnAutoExposurePercentile(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(autoExposure_.GetPercentile());
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		double percentile;
+		pProp->Get(percentile);
+		autoExposure_.SetPercentile(percentile);
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Fraction of each correction (in log exposure) held back: 0 jumps straight
+* to the estimate, 0.9 moves a tenth of the way per frame
+*/
+int CVS14M::OnAutoExposureDamping(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(autoExposure_.GetDamping());
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		double damping;
+		pProp->Get(damping);
+		autoExposure_.SetDamping(damping);
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnSoftwareBinX(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(softBinX_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		long bin;
+		pProp->Get(bin);
+		if (bin > 1 && softBin32_ && accumulateFrames_ > 1)
+			return ERR_BINNING_ACCUMULATE;
+		softBinX_ = bin;
+		return ResizeImageBuffer();
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnSoftwareBinY(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(softBinY_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		long bin;
+		pProp->Get(bin);
+		if (bin > 1 && softBin32_ && accumulateFrames_ > 1)
+			return ERR_BINNING_ACCUMULATE;
+		softBinY_ = bin;
+		return ResizeImageBuffer();
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* 16bit clips the sums at 65535; 32bit gives exact sums as float pixels
+*/
+int CVS14M::OnSoftwareBinDepth(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(softBin32_ ? "32bit" : "16bit");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		std::string val;
+		pProp->Get(val);
+		if (val == "32bit" && accumulateFrames_ > 1 && binning_.IsActive())
+			return ERR_BINNING_ACCUMULATE;
+		softBin32_ = (val == "32bit");
+		return ResizeImageBuffer();
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Burst frames go to the core after the sequence ends ("Drain after burst"),
+* or as fast as the core takes them while it runs ("Drain in background")
+*/
+int CVS14M::OnBurstMode(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		if (!burstEnabled_)
+			pProp->Set("Off");
+		else
+			pProp->Set(burstBackground_ ? "Drain in background" : "Drain after burst");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		std::string val;
+		pProp->Get(val);
+		burstEnabled_ = (val != "Off");
+		burstBackground_ = (val == "Drain in background");
+		if (!burstEnabled_)
+			burst_.Release();	// give the memory back
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnBurstCapacity(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(burstCapacity_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		pProp->Get(burstCapacity_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnBurstFramesHeld(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) burst_.Size());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnBurstHighWater(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) burst_.HighWater());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnBurstMemoryLocked(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(burst_.IsLocked() ? "Yes" : "No");
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* "Disk only" keeps sequence frames out of the core altogether, so nothing
+* will be seen (or saved) by the application while it runs
+*/
+int CVS14M::OnStreamToDisk(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		if (!streamEnabled_)
+			pProp->Set("Off");
+		else
+			pProp->Set(streamToCore_ ? "Disk and core" : "Disk only");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		std::string val;
+		pProp->Get(val);
+		streamEnabled_ = (val != "Off");
+		streamToCore_ = (val == "Disk and core");
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnStreamDir(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(streamDir_.c_str());
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		pProp->Get(streamDir_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnStreamBuffers(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(streamBuffers_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		pProp->Get(streamBuffers_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnStreamBufferSize(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(streamBufferMB_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		pProp->Get(streamBufferMB_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnStreamFile(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(stream_.GetRawPath().c_str());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnStreamFramesWritten(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) stream_.GetFramesWritten());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnStreamQueueDepth(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) stream_.GetQueueDepth());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnStreamQueueHighWater(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) stream_.GetMaxQueueDepth());
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Rate of the writes themselves, i.e. what the disk sustains, not the rate
+* at which the camera produces frames
+*/
+int CVS14M::OnStreamThroughput(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(stream_.GetThroughputMBps());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnStreamDirectIO(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(stream_.IsDirect() ? "Yes" : "No");
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Streamed 16-bit frames are coded with FrameCodec; the records in the raw
+* file are then FrameCodec::Decompress input
+*/
+int CVS14M::OnStreamCompression(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(streamCompress_ ? "Lossless" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		std::string val;
+		pProp->Get(val);
+		streamCompress_ = (val == "Lossless");
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnCompressionThreads(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(codecThreads_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		pProp->Get(codecThreads_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnStreamCompressionRatio(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		pProp->Set((streamPackedBytes_ > 0) ? streamRawBytes_/streamPackedBytes_ : 0.0);
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnCompressionBenchmark(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set("Idle");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		if (val.compare("Run") != 0)
+			return DEVICE_OK;
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+
+		MMThreadGuard g(imgPixelsLock_);
+		if (img_.Depth() != 2)
+		{
+			codecBenchmark_ = "needs 16-bit pixels";
+		}
+		else
+		{
+			codec_.SetThreads((unsigned int) codecThreads_);
+			FrameCodecBenchmark result = BenchmarkFrameCodec(codec_, (const unsigned short*) img_.GetPixels(),
+				img_.Width(), img_.Height(), 10);
+
+			std::ostringstream os;
+			os.setf(std::ios::fixed);
+			os.precision(2);
+			os << "ratio " << result.ratio;
+			os.precision(0);
+			os << ", compress " << result.compressMBps << " MB/s, decompress " << result.decompressMBps << " MB/s, "
+				<< codec_.GetThreads() << (CodecHasSimd() ? " SSE2" : "") << " thread(s), "
+				<< (result.lossless ? "lossless" : "MISMATCH") << " (" << img_.Width() << "x" << img_.Height() << ")";
+			codecBenchmark_ = os.str();
+		}
+		LogMessage("Compression benchmark: " + codecBenchmark_, false);
+		pProp->Set("Idle");
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnCompressionBenchmarkResult(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(codecBenchmark_.c_str());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnFrameMin(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		pProp->Set((long) stats_.GetMin());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnFrameMax(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		pProp->Set((long) stats_.GetMax());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnFrameMean(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		pProp->Set(stats_.GetMean());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnFrameStdDev(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		pProp->Set(stats_.GetStdDev());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnFrameSaturated(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		pProp->Set((long) stats_.GetSaturated());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnCorrectionStatus(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		std::ostringstream os;
+		os << "dark " << (correction_.HasDark() ? "captured" : "none")
+			<< ", flat " << (correction_.HasFlat() ? "captured" : "none")
+			<< ", " << correction_.GetHotPixelCount() << " hot pixels"
+			<< " (" << correction_.GetKey() << ")";
+		pProp->Set(os.str().c_str());
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnContinuousExposing(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+
+		long tvalue = 0;
+		pProp->Get(tvalue);
+		continuousAllowed_ = (0 != tvalue);
+	}
+	else if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(continuousAllowed_?1L:0L);
+	}
+
+	return DEVICE_OK;
+}
+
+int CVS14M::OnExposureSequenceMisses(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(exposureSequenceMisses_);
+	}
+
+	return DEVICE_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private CVS14M methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+* Sync internal image buffer size to the chosen property values.
+*/
+int CVS14M::ResizeImageBuffer()
+{
+	char buf[MM::MaxStrLength];
+	//int ret = GetProperty(MM::g_Keyword_Binning, buf);
+	//if (ret != DEVICE_OK)
+	//   return ret;
+	//binSizeX_ = atol(buf);
+
+	int ret = GetProperty(MM::g_Keyword_PixelType, buf);
+	if (ret != DEVICE_OK)
+		return ret;
+
+	std::string pixelType(buf);
+	int byteDepth = 0;
+
+	if (pixelType.compare(g_PixelType_8bit) == 0)
+	{
+		byteDepth = 1;
+	}
+	else if (pixelType.compare(g_PixelType_16bit) == 0)
+	{
+		byteDepth = 2;
+	}
+	else if ( pixelType.compare(g_PixelType_32bitRGB) == 0)
+	{
+		byteDepth = 4;
+	}
+	else if ( pixelType.compare(g_PixelType_32bit) == 0)
+	{
+		byteDepth = 4;
+	}
+	else if ( pixelType.compare(g_PixelType_64bitRGB) == 0)
+	{
+		byteDepth = 8;
+	}
+
+    if ((imageRotationAngle_ == 90) || (imageRotationAngle_ == 270))
+        img_.Resize(cameraCCDYSize_/binSizeY_, cameraCCDXSize_/binSizeX_, byteDepth);
+    else
+		//img_.Resize(roiW_/binSizeX_, roiH_/binSizeY_, byteDepth);
+		img_.Resize(roiW_, roiH_, byteDepth);
+
+	binning_.Configure(img_.Width(), img_.Height(), softBinX_, softBinY_);
+	binImg_.Resize(std::max(1u, binning_.GetOutputWidth()), std::max(1u, binning_.GetOutputHeight()), softBin32_ ? 4 : 2);
+
+	// 32-bit float output of the accumulator
+	if (accumulateFrames_ > 1)
+	{
+		accumImg_.Resize(GetImageWidth(), GetImageHeight(), 4);
+		varianceImg_.Resize(accumulateVariance_ ? GetImageWidth() : 1, accumulateVariance_ ? GetImageHeight() : 1, 4);
+		accumulator_.Start(GetImageWidth()*GetImageHeight(), accumulateFrames_, accumulateVariance_);
+	}
+	else
+		accumulator_.Start(0, 1, false);
+	accumReady_ = false;
+
+	selectCorrection();
+
+	return DEVICE_OK;
+}
+
+/**
+* Readout geometry the correction references belong to
+*/
+std::string CVS14M::correctionKey() const
+{
+	std::ostringstream os;
+	os << "bin" << binSizeX_ << "x" << binSizeY_ << "_roi" << roiX_ << "-" << roiY_ << "-"
+		<< img_.Width() << "x" << img_.Height() << "_rot" << imageRotationAngle_
+		<< (flipUD_ ? "_ud" : "") << (flipLR_ ? "_lr" : "");
+	return os.str();
+}
+
+std::string CVS14M::correctionFile() const
+{
+	return correctionDir_ + "/VS14M_" + correctionKey() + ".ffc";
+}
+
+/**
+* Switch the correction to the references of the current geometry, loading
+* them from CorrectionReferenceDir if none are held yet
+*/
+void CVS14M::selectCorrection()
+{
+	correction_.Select(correctionKey(), img_.Width(), img_.Height());
+	if (!correctionDir_.empty() && !correction_.HasDark() && !correction_.HasFlat())
+		correction_.Load(correctionFile());
+}
+
+/**
+* Average CorrectionReferenceFrames uncorrected frames into the dark or the
+* flat reference for the current geometry. The dark also gives the hot pixels.
+*/
+int CVS14M::captureReference(bool dark)
+{
+	if (IsCapturing())
+		return DEVICE_CAMERA_BUSY_ACQUIRING;
+	if (img_.Depth() != 2)
+		return ERR_CORRECTION_PIXELTYPE;
+
+	capturingReference_ = true;
+	correction_.BeginReference(correctionFrames_);
+	int ret = DEVICE_OK;
+	for (long i = 0; i < correctionFrames_ && ret == DEVICE_OK; i++)
+	{
+		ret = snapFrame();
+		if (ret == DEVICE_OK)
+		{
+			readFrame();
+			correction_.AddReference((const unsigned short*) img_.GetPixels());
+		}
+	}
+	capturingReference_ = false;
+	if (ret != DEVICE_OK)
+		return ret;
+
+	if (dark)
+	{
+		correction_.SetDarkFromReference();
+		correction_.DetectHotPixels(hotPixelSigma_);
+		std::ostringstream os;
+		os << correction_.GetHotPixelCount() << " hot pixels above " << hotPixelSigma_ << " sigma";
+		LogMessage(os.str(), false);
+	}
+	else
+		correction_.SetFlatFromReference();
+	return DEVICE_OK;
+}
+
+/**
+* Take the statistics of img_, copying src into it on the way unless src
+* is null
+*/
+void CVS14M::scanFrame(const unsigned char* src)
+{
+	unsigned char* pBuf = const_cast<unsigned char*>(img_.GetPixelsRW());
+	size_t n = img_.Width()*img_.Height();
+	stats_.SetBitDepth(bitDepth_);
+	stats_.EnableHistogram(histogramEnabled_ || autoExposureEnabled_);
+	if (img_.Depth() == 2)
+		stats_.Process((const unsigned short*) (src ? src : pBuf), src ? (unsigned short*) pBuf : 0, n);
+	else if (img_.Depth() == 1)
+		stats_.Process(src ? src : pBuf, src ? pBuf : 0, n);
+	else if (src)
+		memcpy(pBuf, src, n*img_.Depth());
+	frameScanned_ = true;
+}
+
+void CVS14M::putFrameStatistics(Metadata& md)
+{
+	md.put("FrameMin", CDeviceUtils::ConvertToString((long) stats_.GetMin()));
+	md.put("FrameMax", CDeviceUtils::ConvertToString((long) stats_.GetMax()));
+	md.put("FrameSum", CDeviceUtils::ConvertToString(stats_.GetSum()));
+	md.put("FrameSumSq", CDeviceUtils::ConvertToString(stats_.GetSumSq()));
+	md.put("FrameMean", CDeviceUtils::ConvertToString(stats_.GetMean()));
+	md.put("FrameStdDev", CDeviceUtils::ConvertToString(stats_.GetStdDev()));
+	md.put("FrameSaturatedPixels", CDeviceUtils::ConvertToString((long) stats_.GetSaturated()));
+	if (histogramEnabled_)
+		md.put("FrameHistogram", stats_.HistogramToString());
+}
+
+/**
+* Work out the exposure for the next frame from the histogram of the one
+* just read. It is set by applyAutoExposure, outside the image lock.
+*/
+void CVS14M::updateAutoExposure(const std::vector<unsigned int>& histogram)
+{
+	if (sequenceRunning_ || hwSequence_ || continuousSequence_)
+		return;		// exposure is not ours to choose
+	autoExposure_.SetLimits(0.01, exposureMaximum_);
+	double next = autoExposure_.Update(histogram, frameExposure_);
+	if (next != frameExposure_)
+		autoExposurePending_ = next;
+}
+
+/**
+* Software binning applies to 16-bit frames only
+*/
+bool CVS14M::softBinning() const
+{
+	return binning_.IsActive() && img_.Depth() == 2;
+}
+
+/**
+* Bin the frame in img_ into binImg_
+*/
+const unsigned char* CVS14M::binFrame()
+{
+	const unsigned short* src = (const unsigned short*) img_.GetPixels();
+	if (softBin32_)
+		binning_.Bin(src, (float*) binImg_.GetPixelsRW());
+	else
+		binning_.Bin(src, (unsigned short*) binImg_.GetPixelsRW());
+	return binImg_.GetPixels();
+}
+
+/**
+* Set up the burst ring for a new sequence. When draining after the burst the
+* ring has to hold the whole sequence: a continuous sequence is cut short at
+* the ring capacity, and a longer finite one is refused up front.
+*/
+int CVS14M::startBurst(long& numImages)
+{
+	burstActive_ = false;
+	if (!burstEnabled_)
+		return DEVICE_OK;
+
+	if (!burstBackground_)
+	{
+		long images = burstCapacity_ / (long) GetNumberOfChannels();
+		if (numImages == LONG_MAX)
+			numImages = images;
+		else if (numImages > images)
+			return ERR_BURST_FULL;
+	}
+
+	if (!burst_.Allocate((unsigned int) burstCapacity_, GetImageBufferSize()))
+		return ERR_BURST_MEMORY;
+	if (!burst_.IsLocked())
+		LogMessage("Burst ring could not be locked in memory, frames may be paged out", true);
+	burstActive_ = true;
+	return DEVICE_OK;
+}
+
+/**
+* Pass the oldest frame in the burst ring to the core. Returns false if there
+* was nothing to pass on, or if the core buffer is full and the frame has to
+* wait. Outside live mode the frame is never dropped.
+*/
+bool CVS14M::drainBurstFrame()
+{
+	const BurstFrame* f = burst_.Front();
+	if (f == 0)
+		return false;
+
+	MM::Core* core = GetCoreCallback();
+	int ret = core->InsertImage(this, f->pixels, f->width, f->height, f->bytesPerPixel, f->metadata.c_str());
+	if (ret == DEVICE_BUFFER_OVERFLOW)
+	{
+		if (stopOnOverflow_)
+			return false;
+		// live mode: as insertIntoCore, reset the buffer rather than wait
+		core->ClearImageBuffer(this);
+		ret = core->InsertImage(this, f->pixels, f->width, f->height, f->bytesPerPixel, f->metadata.c_str(), false);
+	}
+	if (ret != DEVICE_OK)
+		LogMessage("Burst frame rejected by the core, error " + boost::lexical_cast<std::string>(ret), false);
+	burst_.Pop();
+	return true;
+}
+
+/**
+* Called on the sequence thread as it finishes: stop the background drain and
+* pass on everything left in the ring. If the core buffer stays full for 10 s
+* the rest is given up, so a client that has stopped reading cannot hang us.
+*/
+void CVS14M::finishBurst()
+{
+	if (!burstActive_)
+		return;
+	burstDrain_->Stop();
+
+	const double timeoutUs = 10.0e6;
+	double lastProgressUs = MonotonicClock::NowUs();
+	while (burst_.Size() > 0)
+	{
+		if (drainBurstFrame())
+			lastProgressUs = MonotonicClock::NowUs();
+		else if (MonotonicClock::NowUs() - lastProgressUs > timeoutUs)
+		{
+			LogMessage("Core buffer stayed full, " + boost::lexical_cast<std::string>(burst_.Size()) + " burst frames discarded", false);
+			break;
+		}
+		else
+			CDeviceUtils::SleepMs(1);
+	}
+	burstActive_ = false;
+}
+
+/**
+* Base name (no extension) of the files for a new stream
+*/
+std::string CVS14M::streamFile()
+{
+	char stamp[32];
+	time_t now = time(0);
+	strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+	char count[8];
+	sprintf(count, "_%03ld", ++streamCount_ % 1000);
+	return streamDir_ + "/VS14M_" + stamp + count;
+}
+
+/**
+* Open the stream files for a new sequence, preallocated for numImages
+*/
+int CVS14M::startStream(long numImages)
+{
+	finishStream();
+	if (!streamEnabled_)
+		return DEVICE_OK;
+	if (streamDir_.empty())
+		return ERR_STREAM_FILE;
+
+	unsigned long frames = (numImages == LONG_MAX) ? 0 : (unsigned long) numImages*GetNumberOfChannels();
+	stream_.SetBuffers((unsigned int) streamBuffers_, (size_t) streamBufferMB_ << 20);
+	streamPacked_ = streamCompress_ && GetImageBytesPerPixel() == 2;
+	if (streamCompress_ && !streamPacked_)
+		LogMessage("Stream to disk: compression needs 16-bit pixels, writing uncompressed", true);
+	stream_.SetCompression(streamPacked_ ? "FC16" : "none");
+	if (streamPacked_)
+	{
+		codec_.SetThreads((unsigned int) codecThreads_);
+		packed_.resize(FrameCodec::MaxCompressedBytes(GetImageWidth(), GetImageHeight()));
+	}
+	streamRawBytes_ = 0;
+	streamPackedBytes_ = 0;
+	if (!stream_.Open(streamFile(), GetImageWidth(), GetImageHeight(), GetImageBytesPerPixel(), frames))
+	{
+		LogMessage("Stream to disk: " + stream_.GetError(), false);
+		return ERR_STREAM_FILE;
+	}
+	if (!stream_.IsDirect())
+		LogMessage("Stream to disk: unbuffered I/O not available, writing through the file cache", true);
+	streamActive_ = true;
+	return DEVICE_OK;
+}
+
+/**
+* Called on the sequence thread as it finishes: wait for the I/O thread to
+* write out what is queued and close the files
+*/
+void CVS14M::finishStream()
+{
+	if (!streamActive_)
+		return;
+	streamActive_ = false;
+	if (!stream_.Close())
+		LogMessage("Stream to disk: " + stream_.GetError(), false);
+	else
+		LogMessage("Streamed " + boost::lexical_cast<std::string>(stream_.GetFramesWritten()) + " frames to " + stream_.GetRawPath(), true);
+}
+
+/**
+* Called on the sequence thread as it finishes, however the sequence ended:
+* put the camera back in the mode used for snaps
+*/
+void CVS14M::finishSequenceModes()
+{
+	if (hwSequence_)
+	{
+		// put the overlapped exposure time back to the Exposure property
+		hwSequence_ = false;
+		if (overlapExposure_)
+		{
+			MMThreadGuard bus(busLock_);
+			ArtemisSetOverlappedExposureTime(hCam_, (float) GetExposure()/1000);
+		}
+	}
+
+	if (continuousSequence_)
+	{
+		continuousSequence_ = false;
+		if (!waitImageReady(GetExposure() + 5000))	//let the last read finish
+		{
+			LogMessage("Last continuous read did not finish, aborting it");
+			MMThreadGuard bus(busLock_);
+			ArtemisAbortExposure(hCam_);
+		}
+		MMThreadGuard bus(busLock_);
+		ArtemisSetContinuousExposingMode(hCam_, overlapExposure_);
+	}
+}
+
+void CVS14M::applyAutoExposure()
+{
+	if (autoExposurePending_ <= 0)
+		return;
+	double exp = autoExposurePending_;
+	autoExposurePending_ = 0;
+	SetExposure(exp);
+}
+
+void CVS14M::GenerateEmptyImage(ImgBuffer& img)
+{
+	MMThreadGuard g(imgPixelsLock_);
+	if (img.Height() == 0 || img.Width() == 0 || img.Depth() == 0)
+		return;
+	unsigned char* pBuf = const_cast<unsigned char*>(img.GetPixels());
+	memset(pBuf, 0, img.Height()*img.Width()*img.Depth());
+}
+
+void CVS14M::TestResourceLocking(const bool recurse)
+{
+	if(recurse)
+		TestResourceLocking(false);
+}
+
+void CVS14M::rotate90(int original_xsize, int original_ysize, unsigned short *in_arr, unsigned short *out_arr){
+
+	int xsize = original_ysize;
+	int ysize = original_xsize;	//swapped here for clairty...
+	for (int y = 0; y < ysize; ++y){
+		for (int x = 0, destx = xsize-1; x<xsize; ++x, --destx){
+			out_arr[y * xsize + destx] = in_arr[x * ysize + y];
+		}
+	}
+}
+
+void CVS14M::rotate180(int original_xsize, int original_ysize, unsigned short *in_arr, unsigned short *out_arr){
+
+	for (int i = 0; i < original_xsize*original_ysize; ++i){
+		out_arr[original_xsize*original_ysize - 1 -i] = in_arr[i];
+	}
+}
+
+void CVS14M::rotate270(int original_xsize, int original_ysize, unsigned short *in_arr, unsigned short *out_arr){
+
+	int xsize = original_ysize;
+	int ysize = original_xsize;	//swapped here for clairty...
+	for (int x = 0; x < xsize; ++x){
+		for (int y = 0, desty = ysize-1; y<ysize; ++y, --desty){
+			out_arr[x + desty*xsize] = in_arr[x * ysize + y];
+		}
+	}
+}
+
+void CVS14M::mirrorY(int original_xsize, int original_ysize, unsigned short *in_arr, unsigned short *out_arr){
+
+	for (int x = 0; x < original_xsize; ++x){
+		for (int y = 0, desty = original_ysize - 1; y < original_ysize; ++y, --desty){
+			out_arr[desty * original_xsize + x] = in_arr[y * original_xsize + x];
+		}
+	}
+}
+
+void CVS14M::mirrorX(int original_xsize, int original_ysize, unsigned short *in_arr, unsigned short *out_arr){
+
+	for (int y = 0; y < original_ysize; ++y){
+		for (int x = 0, destx = original_xsize - 1; x < original_xsize; ++x, --destx){
+			out_arr[y * original_xsize + destx] = in_arr[y * original_xsize + x];
+		}
+	}
+}
+
+
+int TransposeProcessor::Initialize()
+{
+
+
+	if( NULL != this->pTemp_)
+	{
+		free(pTemp_);
+		pTemp_ = NULL;
+		this->tempSize_ = 0;
+	}
+	CPropertyAction* pAct = new CPropertyAction (this, &TransposeProcessor::OnInPlaceAlgorithm);
+	(void)CreateIntegerProperty("InPlaceAlgorithm", 0, false, pAct);
+	return DEVICE_OK;
+}
+
+// action interface
+// ----------------
+int TransposeProcessor::OnInPlaceAlgorithm(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(this->inPlace_?1L:0L);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		long ltmp;
+		pProp->Get(ltmp);
+		inPlace_ = (0==ltmp?false:true);
+	}
+
+	return DEVICE_OK;
+}
+
+
 int TransposeProcessor::Process(unsigned char *pBuffer, unsigned int width, unsigned int height, unsigned int byteDepth)
 {
 	int ret = DEVICE_OK;
@@ -2341,14 +4671,49 @@ int CVS14M::GetCurrentTemperature(){
 	if (ret != DEVICE_OK)
 		return ret;
 	
-	ret = SetProperty("CCDTemperature Readout", boost::lexical_cast<std::string>(currentTemp_).c_str());
-	LogMessage("Getting current temp", false);
+	AtomicExchange(&tempCenti_, dummyTemp);
+
+	return DEVICE_OK;
+}
+
+/**
+* Read temperature and cooler state, publish them for the property handlers
+* and append them to the history. Called from the telemetry thread.
+*/
+int CVS14M::sampleTelemetry(double timeS){
+
+	int temp, flags, level, minlvl, maxlvl, setpoint;
+	int ret;
+	{
+		MMThreadGuard bus(busLock_);
+		ret = ArtemisTemperatureSensorInfo(hCam_, 1, &temp);
+		if (ret == ARTEMIS_OK)
+			ret = ArtemisCoolingInfo(hCam_, &flags, &level, &minlvl, &maxlvl, &setpoint);
+	}
+	if (ret != ARTEMIS_OK)
+		return DEVICE_ERR;
+
+	int power = (maxlvl > minlvl) ? (100*(level - minlvl))/(maxlvl - minlvl) : 0;
+	AtomicExchange(&tempCenti_, temp);
+	AtomicExchange(&coolerPower_, power);
+	AtomicExchange(&coolerSetpointCenti_, setpoint);
+
+	MMThreadGuard g(telemetryLock_);
+	TelemetrySample& s = telemetryHistory_[telemetryHead_];
+	s.timeS = timeS;
+	s.temperature = ((float) temp)/100;
+	s.coolerLevel = power;
+	s.setpoint = setpoint;
+	telemetryHead_ = (telemetryHead_ + 1) % (long) telemetryHistory_.size();
+	if (telemetryCount_ < (long) telemetryHistory_.size())
+		++telemetryCount_;
 
 	return DEVICE_OK;
 }
 
 int CVS14M::TemperatureContol(){
 	
+	MMThreadGuard bus(busLock_);
 	if (ccdT_ < ambientTemp_){
 			
 			if (ccdT_ < (ambientTemp_ - 35))
@@ -2444,6 +4809,67 @@ int CVS14M::setPrechargeMode(int mode)
 	return camErr;
 }
 
+/**
+* Look up the trigger device once at the start of a sequence so that the
+* per-frame trigger doesn't go through the core's device lookup.
+*/
+int CVS14M::resolveTriggerDevice()
+{
+	triggerDev_ = 0;
+	if (gpioTrigger_ || triggerDevice_.length() == 0)
+		return DEVICE_OK;
+
+	triggerDev_ = GetDevice(triggerDevice_.c_str());
+	if (triggerDev_ == 0)
+	{
+		LogMessage("Trigger device " + triggerDevice_ + " not found");
+		return ERR_NO_TRIGGER_DEVICE;
+	}
+	return DEVICE_OK;
+}
+
+/**
+* Configure the selected GPIO line as an output held low (all other lines
+* left as inputs), or release all lines back to inputs.
+*/
+int CVS14M::setGpioTrigger(bool enable)
+{
+	int allInputs = (1 << gpioLineCount_) - 1;	//nth bit set -> nth line is an input
+	int camErr;
+
+	if (enable)
+	{
+		ArtemisTriggeredExposure(hCam_, false);	//camera starts exposure, we fire the intensifier
+		camErr = ArtemisSetGpioValues(hCam_, 0);
+		if (camErr == ARTEMIS_OK)
+			camErr = ArtemisSetGpioDirection(hCam_, allInputs & ~(1 << gpioTriggerLine_));
+	}
+	else
+		camErr = ArtemisSetGpioDirection(hCam_, allInputs);
+
+	if (camErr != ARTEMIS_OK)
+	{
+		LogMessage("Error configuring camera GPIO trigger line");
+		gpioTrigger_ = false;
+		return DEVICE_ERR;
+	}
+
+	gpioTrigger_ = enable;
+	return DEVICE_OK;
+}
+
+/**
+* Pulse the GPIO trigger line high then low.
+*/
+int CVS14M::fireGpioTrigger()
+{
+	int camErr = ArtemisSetGpioValues(hCam_, 1 << gpioTriggerLine_);
+	if (camErr == ARTEMIS_OK)
+		camErr = ArtemisSetGpioValues(hCam_, 0);
+
+	return (camErr == ARTEMIS_OK) ? DEVICE_OK : DEVICE_ERR;
+}
+
 int CVS14M::setArtemisProcessing(bool linearise, bool VBE)
 {
 
@@ -29,7 +29,18 @@
 #include <map>
 #include <algorithm>
 //#include "../../3rdparty/ArtemisVS14M/ArtemisSciAPI.h"
-#include "C:\\Users\\dk1109\\repositories\\umanager\\micromanager\\DeviceAdapters\\Artermis\\ArtemisHscAPI.h"
+#include "ArtemisHscAPI.h"
+#include "../CameraUtilities/FramePacer.h"
+#include "../CameraUtilities/FrameGapDetector.h"
+#include "../CameraUtilities/FrameAccumulator.h"
+#include "../CameraUtilities/FrameCorrection.h"
+#include "../CameraUtilities/FrameStatistics.h"
+#include "../CameraUtilities/AutoExposure.h"
+#include "../CameraUtilities/SoftwareBinning.h"
+#include "../CameraUtilities/BurstBuffer.h"
+#include "../CameraUtilities/StreamWriter.h"
+#include "../CameraUtilities/FrameCodec.h"
+#include "../CameraUtilities/PlatformSync.h"
 
 //////////////////////////////////////////////////////////////////////////////
 // Error codes
@@ -40,6 +51,17 @@
 #define ERR_SEQUENCE_INACTIVE    105
 #define ERR_STAGE_MOVING         106
 #define HUB_NOT_AVAILABLE        107
+#define ERR_NO_TRIGGER_DEVICE    108
+#define ERR_CAMERA_NOT_FOUND     109
+#define ERR_CORRECTION_PIXELTYPE 110
+#define ERR_CORRECTION_FILE      111
+#define ERR_BINNING_ACCUMULATE   112
+#define ERR_BURST_FULL           113
+#define ERR_BURST_MEMORY         114
+#define ERR_STREAM_FILE          115
+#define ERR_ARTEMIS_LIBRARY      116
+#define ERR_SYNTHETIC_CONFIG     117
+#define ERR_CONTINUOUS_EXPOSING  118
 
 const char* NoHubError = "Parent Hub not defined.";
 
@@ -50,6 +72,17 @@ const char* NoHubError = "Parent Hub not defined.";
 //////////////////////////////////////////////////////////////////////////////
 
 class MySequenceThread;
+class BurstDrainThread;
+class TelemetryThread;
+
+// One cooler/temperature reading, kept in a ring buffer for drift diagnostics
+struct TelemetrySample
+{
+	double timeS;		// seconds since the telemetry thread started
+	float temperature;	// CCD temperature, oC
+	int coolerLevel;	// cooler power as a percentage of maximum
+	int setpoint;		// cooler setpoint, oC*100
+};
 
 class CVS14M : public CCameraBase<CVS14M>  
 {
@@ -68,6 +101,9 @@ public:
 	// ------------
 	int SnapImage();
 	const unsigned char* GetImageBuffer();
+	const unsigned char* GetImageBuffer(unsigned channelNr);
+	unsigned GetNumberOfChannels() const;
+	int GetChannelName(unsigned channel, char* name);
 	unsigned GetImageWidth() const;
 	unsigned GetImageHeight() const;
 	unsigned GetImageBytesPerPixel() const;
@@ -110,6 +146,8 @@ public:
 	int OnCameraCCDXSize(MM::PropertyBase* , MM::ActionType );
 	int OnCameraCCDYSize(MM::PropertyBase* , MM::ActionType );
 	int OnTriggerDevice(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnTriggerSource(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnGpioTriggerLine(MM::PropertyBase* pProp, MM::ActionType eAct);
 	int OnCCDTemp(MM::PropertyBase* pProp, MM::ActionType eAct);
 	int OnIsSequenceable(MM::PropertyBase* pProp, MM::ActionType eAct);
 	int OnFlipUD(MM::PropertyBase* pProp, MM::ActionType eAct);
@@ -127,6 +165,66 @@ public:
 	int OnArtemisVenetian(MM::PropertyBase* pProp, MM::ActionType eAct);
 	int OnOverlappedExposure(MM::PropertyBase* pProp, MM::ActionType eAct);
 	int OnPreviewMode(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnJitterMean(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnJitterStd(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnJitterMax(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnLateFrames(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnSequenceFrameRate(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnSequenceLatencyMean(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnSequenceLatencyMax(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnExposureSequenceMisses(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnContinuousExposing(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnDroppedFrames(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAccumulateFrames(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAccumulateVariance(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnDarkCorrection(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFlatCorrection(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCorrectionFrames(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCorrectionDir(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCorrectionCommand(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCorrectionStatus(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnHotPixelCorrection(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnHotPixelSigma(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnHotPixelCount(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameStatistics(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameHistogram(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameMin(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameMax(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameMean(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameStdDev(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameSaturated(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAutoExposure(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAutoExposureTarget(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAutoExposurePercentile(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAutoExposureDamping(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnSoftwareBinX(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnSoftwareBinY(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnSoftwareBinDepth(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnBurstMode(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnBurstCapacity(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnBurstFramesHeld(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnBurstHighWater(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnBurstMemoryLocked(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamToDisk(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamDir(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamBuffers(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamBufferSize(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamFile(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamFramesWritten(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamQueueDepth(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamQueueHighWater(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamThroughput(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamDirectIO(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamCompression(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCompressionThreads(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamCompressionRatio(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCompressionBenchmark(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCompressionBenchmarkResult(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCCDTempReadout(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCoolerPower(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCoolerSetpoint(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnTemperatureDrift(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnTemperatureHistory(MM::PropertyBase* pProp, MM::ActionType eAct);
 
 private:
 	int SetAllowedBinning();
@@ -134,16 +232,42 @@ private:
 	void TestResourceLocking(const bool);
 	void GenerateEmptyImage(ImgBuffer& img);
 	int ResizeImageBuffer();
+	int snapFrame();
+	const unsigned char* readFrame();
+	int runSequenceFrame();
+	void accumulateFrame(const unsigned char* pixels);
+	int insertIntoCore(const unsigned char* pI, Metadata& md);
+	std::string correctionKey() const;
+	std::string correctionFile() const;
+	void selectCorrection();
+	int captureReference(bool dark);
+	void scanFrame(const unsigned char* src);
+	void putFrameStatistics(Metadata& md);
+	void updateAutoExposure(const std::vector<unsigned int>& histogram);
+	void applyAutoExposure();
+	bool softBinning() const;
+	const unsigned char* binFrame();
+	int startBurst(long& numImages);
+	bool drainBurstFrame();
+	void finishBurst();
+	std::string streamFile();
+	int startStream(long numImages);
+	void finishStream();
+	void finishSequenceModes();
 
 	int GetCurrentTemperature();
+	int sampleTelemetry(double timeS);
 	int TemperatureContol();
-	double CVS14M::roundUp(double numToRound, double toMultipleOf);
+	double roundUp(double numToRound, double toMultipleOf);
 	int setPriority(bool highpriority);
 	int findFactors(int input, std::vector<int> factors);
 	int toggleAsymmBinning();
 	bool isCoolingPresent(ArtemisHandle hCam);
 	int setPrechargeMode(int mode);
 	int setArtemisProcessing(bool linearise, bool VBE);
+	int resolveTriggerDevice();
+	int setGpioTrigger(bool enable);
+	int fireGpioTrigger();
 
 	int reportCamErr(int err);
 
@@ -173,7 +297,92 @@ private:
 	bool sequenceRunning_;
 	unsigned long sequenceIndex_;
 	double GetSequenceExposure();
+	void armNextSequenceExposure();
+	int startContinuousExposing();
+	double lastExposureStartMs();
+	bool waitImageReady(double timeoutMs);
 	std::vector<double> exposureSequence_;
+	bool canOverlap_;
+	bool hwSequence_;			// exposure sequence driven by overlapped exposures
+	double nextSequenceExposure_;	// exposure (ms) armed on the camera for the next frame
+	double armedExposure_;
+	double frameExposure_;		// exposure (ms) of the frame being read out
+	bool frameExposureValid_;
+	long exposureSequenceMisses_;
+	bool continuousSupported_;
+	bool continuousAllowed_;
+	bool continuousSequence_;	// camera free-running, thread only harvests frames
+	double frameStartMs_;		// camera's start time of the frame in img_, ms since midnight
+	double startTimeBaseMs_;	// unwrapping of frameStartMs_ at midnight
+	double lastStartMs_;		// unwrapped start of the previous frame
+	FrameGapDetector gapDetector_;
+
+	// Frame accumulation: AccumulateFrames exposures are summed in 32-bit
+	// integers and delivered as one 32-bit float frame, with a variance
+	// channel if asked for
+	long accumulateFrames_;
+	bool accumulateVariance_;
+	FrameAccumulator accumulator_;
+	ImgBuffer accumImg_;
+	ImgBuffer varianceImg_;
+	bool accumReady_;			// accumImg_ holds a completed sum
+
+	// Dark/flat correction of 16-bit frames, references per readout geometry
+	FrameCorrection correction_;
+	long correctionFrames_;		// frames averaged into a reference
+	double hotPixelSigma_;		// hot pixel threshold, standard deviations above the dark mean
+	std::string correctionDir_;	// where references are saved; empty for none
+	bool capturingReference_;	// bypass the correction while capturing
+
+	// Statistics of each frame read out, taken while it is copied into img_
+	FrameStatistics stats_;
+	bool statsEnabled_;
+	bool histogramEnabled_;
+	bool frameScanned_;			// stats_ already describes the frame in img_
+
+	// Autoexposure from the statistics of each frame
+	AutoExposure autoExposure_;
+	bool autoExposureEnabled_;
+	double autoExposurePending_;	// exposure (ms) to set before the next frame, 0 for none
+	std::vector<unsigned int> aeHistogram_;	// pooled over the exposures of an accumulated frame
+
+	// Software binning of 16-bit frames, after any binning done by the camera.
+	// The image (and ROI) seen by the core is the binned one.
+	SoftwareBinning binning_;
+	long softBinX_;
+	long softBinY_;
+	bool softBin32_;			// exact 32-bit float sums rather than clipped 16-bit
+	ImgBuffer binImg_;
+
+	// Burst capture: sequence frames are parked in a preallocated ring in RAM
+	// and passed to the core after the burst, or by BurstDrainThread
+	BurstBuffer burst_;
+	bool burstEnabled_;
+	bool burstBackground_;		// drain while the burst runs rather than after it
+	long burstCapacity_;		// frames
+	bool burstActive_;			// the running sequence is writing to burst_
+
+	// Stream to disk: sequence frames are written to StreamDir by the
+	// StreamWriter I/O thread, instead of or as well as going to the core
+	StreamWriter stream_;
+	bool streamEnabled_;
+	bool streamToCore_;
+	std::string streamDir_;
+	long streamBuffers_;
+	long streamBufferMB_;
+	long streamCount_;			// streams written since the adapter was loaded
+	bool streamActive_;			// the running sequence is writing to stream_
+
+	// Lossless compression of streamed 16-bit frames
+	FrameCodec codec_;
+	bool streamCompress_;
+	bool streamPacked_;			// the running stream is compressed
+	long codecThreads_;			// 0 for one per processor
+	std::vector<unsigned char> packed_;
+	double streamRawBytes_;
+	double streamPackedBytes_;
+	std::string codecBenchmark_;
+
 	long imageCounter_;
 	long binSizeX_;
 	long binSizeY_;
@@ -181,8 +390,14 @@ private:
 	long cameraCCDYSize_;
 	double ccdT_;
 	std::string triggerDevice_;
+	MM::Device* triggerDev_;	// resolved once per sequence
+	bool gpioTrigger_;
+	long gpioTriggerLine_;
+	int gpioLineCount_;
 
 	ArtemisHandle hCam_;
+	bool dllLoaded_;
+	std::string artemisLibrary_;	// library this instance holds, if dllLoaded_
 	float currentTemp_;
 	float ambientTemp_;
 
@@ -203,10 +418,32 @@ private:
 	bool overlapExposure_;
 	bool previewMode_;
 
+	FramePacer pacer_;
+	FramePacingStats pacingStats_;
+	MMThreadLock pacerLock_;	// also guards rateMeter_
+	FrameRateMeter rateMeter_;
+	double frameReadyUs_;		// when the frame in img_ was ready at the camera
+
+	// Telemetry: written by the telemetry thread, read by property handlers.
+	// Values are published with atomic exchanges so a reader never sees a
+	// torn update and never has to wait for the USB link.
+	volatile long tempCenti_;			// CCD temperature, oC*100
+	volatile long coolerPower_;			// percent
+	volatile long coolerSetpointCenti_;	// oC*100
+	std::vector<TelemetrySample> telemetryHistory_;
+	long telemetryHead_;
+	long telemetryCount_;
+	MMThreadLock telemetryLock_;		// guards the history ring buffer
+	MMThreadLock busLock_;				// held while talking to the camera over USB
+
 	MMThreadLock imgPixelsLock_;
 	friend class MySequenceThread;
+	friend class BurstDrainThread;
+	friend class TelemetryThread;
 	int nComponents_;
 	MySequenceThread * thd_;
+	BurstDrainThread * burstDrain_;
+	TelemetryThread * telemetry_;
 };
 
 class MySequenceThread : public MMDeviceThreadBase
@@ -243,6 +480,52 @@ private:
 	MMThreadLock suspendLock_;                                                
 }; 
 
+//////////////////////////////////////////////////////////////////////////////
+// TelemetryThread class
+// Low priority thread reading the CCD temperature and cooler state. While a
+// sequence is running it only samples when the sequence thread reports that
+// the USB link is idle; otherwise it samples every samplePeriodMs.
+//////////////////////////////////////////////////////////////////////////////
+class TelemetryThread : public MMDeviceThreadBase
+{
+	enum { default_samplePeriodMS = 1000 };
+public:
+	TelemetryThread(CVS14M* pCam);
+	~TelemetryThread();
+	void Start();
+	void Stop();
+	bool IsStopped();
+	void SignalBusIdle();
+private:
+	int svc(void) throw();
+	CVS14M* camera_;
+	AutoResetEvent idleEvent_;
+	long samplePeriodMs_;
+	bool stop_;
+	MMThreadLock stopLock_;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// BurstDrainThread class
+// Passes frames from the burst ring to the core while the burst is still
+// running, when BurstMode is "Drain in background".
+//////////////////////////////////////////////////////////////////////////////
+class BurstDrainThread : public MMDeviceThreadBase
+{
+	enum { default_idleMS = 2 };
+public:
+	BurstDrainThread(CVS14M* pCam);
+	~BurstDrainThread();
+	void Start();
+	void Stop();
+	bool IsStopped();
+private:
+	int svc(void) throw();
+	CVS14M* camera_;
+	bool stop_;
+	MMThreadLock stopLock_;
+};
+
 
 
 //////////////////////////////////////////////////////////////////////////////
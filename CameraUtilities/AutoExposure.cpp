@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          AutoExposure.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Closed-loop exposure control from frame histograms
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "AutoExposure.h"
+#include <math.h>
+
+static const double k_saturatedStep = 0.25;	// exposure factor when the percentile is clipped
+static const double k_maxStep = 32;			// largest factor in one frame
+static const double k_deadband = 0.05;		// relative change not worth making
+
+AutoExposure::AutoExposure() :
+	target_(0.7),
+	percentile_(99),
+	damping_(0.5),
+	minMs_(0.01),
+	maxMs_(10000),
+	level_(0)
+{
+}
+
+double AutoExposure::Update(const std::vector<unsigned int>& histogram, double exposureMs)
+{
+	double total = 0;
+	for (size_t i = 0; i < histogram.size(); ++i)
+		total += histogram[i];
+	if (total == 0 || exposureMs <= 0)
+		return exposureMs;
+
+	// first bin reaching the percentile
+	double wanted = total*percentile_/100;
+	double cumulative = 0;
+	size_t bin = 0;
+	for (; bin + 1 < histogram.size(); ++bin)
+	{
+		cumulative += histogram[bin];
+		if (cumulative >= wanted)
+			break;
+	}
+	level_ = (bin + 0.5)/histogram.size();
+
+	double step;
+	if (bin + 1 >= histogram.size())
+		step = k_saturatedStep;
+	else
+	{
+		double ratio = target_/level_;
+		if (ratio > k_maxStep)
+			ratio = k_maxStep;
+		else if (ratio < 1/k_maxStep)
+			ratio = 1/k_maxStep;
+		step = exp((1 - damping_)*log(ratio));
+	}
+	if (fabs(step - 1) < k_deadband)
+		return exposureMs;
+
+	double next = exposureMs*step;
+	if (next < minMs_)
+		next = minMs_;
+	if (next > maxMs_)
+		next = maxMs_;
+	return next;
+}
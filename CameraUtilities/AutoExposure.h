@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          AutoExposure.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Closed-loop exposure control from frame histograms
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+#ifndef _AUTOEXPOSURE_H_
+#define _AUTOEXPOSURE_H_
+
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// AutoExposure
+// Chooses the next exposure so that a given percentile of the frame lands
+// at a target fraction of full scale. The level is read from the 256-bin
+// histogram of a frame (FrameStatistics) and the correction is made in log
+// exposure, so brightness changes of orders of magnitude take a few frames
+// whatever the starting point:
+//     next = exposure * (target/level)^(1 - damping)
+// A frame saturated at the percentile gives no level to aim from, so the
+// exposure is then cut by a fixed factor, undamped. Changes within a few
+// percent are ignored to stop the loop hunting on noise.
+//////////////////////////////////////////////////////////////////////////////
+class AutoExposure
+{
+public:
+	AutoExposure();
+	~AutoExposure() {};
+
+	void SetTarget(double fraction) {target_ = fraction;}
+	void SetPercentile(double percent) {percentile_ = percent;}
+	void SetDamping(double damping) {damping_ = damping;}
+	void SetLimits(double minMs, double maxMs) {minMs_ = minMs; maxMs_ = maxMs;}
+	double GetTarget() const {return target_;}
+	double GetPercentile() const {return percentile_;}
+	double GetDamping() const {return damping_;}
+
+	// Exposure (ms) for the next frame, from the histogram of a frame taken
+	// with exposureMs
+	double Update(const std::vector<unsigned int>& histogram, double exposureMs);
+
+	// Percentile level of the last frame given to Update, fraction of full scale
+	double GetLevel() const {return level_;}
+
+private:
+	double target_;
+	double percentile_;
+	double damping_;
+	double minMs_;
+	double maxMs_;
+	double level_;
+};
+
+#endif //_AUTOEXPOSURE_H_
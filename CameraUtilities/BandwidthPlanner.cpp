@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          BandwidthPlanner.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Sharing of isochronous bus bandwidth between cameras
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "BandwidthPlanner.h"
+#include <math.h>
+
+// IEEE 1394 isochronous cycles per second
+static const double k_cyclesPerSecond = 8000;
+
+// All cameras in the process share the one bus, so there is one planner.
+// First used from a device constructor; the core creates devices on a
+// single thread, so the lazy construction is not raced.
+BandwidthPlanner& BandwidthPlanner::Instance()
+{
+	static BandwidthPlanner planner;
+	return planner;
+}
+
+BandwidthPlanner::BandwidthPlanner() :
+	nextId_(1),
+	generation_(0)
+{
+#ifdef WIN32
+	InitializeCriticalSection(&lock_);
+#else
+	pthread_mutex_init(&lock_, 0);
+#endif
+}
+
+BandwidthPlanner::~BandwidthPlanner()
+{
+#ifdef WIN32
+	DeleteCriticalSection(&lock_);
+#else
+	pthread_mutex_destroy(&lock_);
+#endif
+}
+
+void BandwidthPlanner::lock()
+{
+#ifdef WIN32
+	EnterCriticalSection(&lock_);
+#else
+	pthread_mutex_lock(&lock_);
+#endif
+}
+
+void BandwidthPlanner::unlock()
+{
+#ifdef WIN32
+	LeaveCriticalSection(&lock_);
+#else
+	pthread_mutex_unlock(&lock_);
+#endif
+}
+
+int BandwidthPlanner::Register()
+{
+	lock();
+	int id = nextId_++;
+	clients_[id] = Client();
+	unlock();
+	return id;
+}
+
+void BandwidthPlanner::Unregister(int id)
+{
+	lock();
+	if (clients_.erase(id) > 0)
+		++generation_;
+	unlock();
+}
+
+void BandwidthPlanner::SetRequest(int id, unsigned int requestBytes, unsigned int unitBytes, unsigned int maxBytes)
+{
+	lock();
+	Client& c = clients_[id];
+	if (c.request != requestBytes || c.unit != unitBytes || c.max != maxBytes)
+		++generation_;
+	c.request = requestBytes;
+	c.unit = unitBytes;
+	c.max = maxBytes;
+	unlock();
+}
+
+unsigned long BandwidthPlanner::GetGeneration()
+{
+	lock();
+	unsigned long generation = generation_;
+	unlock();
+	return generation;
+}
+
+unsigned int BandwidthPlanner::GetAllotment(int id)
+{
+	lock();
+	std::map<int, Client>::const_iterator me = clients_.find(id);
+	if (me == clients_.end() || me->second.request == 0)
+	{
+		unlock();
+		return 0;
+	}
+
+	unsigned int budget = 0;
+	double total = 0;
+	std::map<int, Client>::const_iterator it;
+	for (it = clients_.begin(); it != clients_.end(); ++it)
+	{
+		total += it->second.request;
+		if (it->second.max > budget)
+			budget = it->second.max;
+	}
+
+	const Client& c = me->second;
+	unsigned int bytes = c.request;
+	if (total > budget)
+	{
+		// Round the proportional share down, so the sum stays within budget
+		double share = c.request * budget / total;
+		unsigned int unit = (c.unit > 0) ? c.unit : 1;
+		bytes = (unsigned int) (share / unit) * unit;
+		if (bytes < unit)
+			bytes = unit;
+	}
+	unlock();
+	return bytes;
+}
+
+unsigned int BandwidthPlanner::BytesPerPacketFor(double fps, double bytesPerFrame, unsigned int unitBytes, unsigned int maxBytes)
+{
+	if (fps <= 0 || bytesPerFrame <= 0)
+		return maxBytes;
+
+	if (unitBytes == 0)
+		unitBytes = 1;
+
+	// A frame occupies a whole number of cycles
+	double packetsPerFrame = floor(k_cyclesPerSecond / fps);
+	if (packetsPerFrame < 1)
+		return maxBytes;
+	double bytes = ceil(bytesPerFrame / packetsPerFrame / unitBytes) * unitBytes;
+	if (bytes > maxBytes)
+		return maxBytes;
+	return (unsigned int) bytes;
+}
+
+double BandwidthPlanner::FrameRateFor(unsigned int bytesPerPacket, double bytesPerFrame)
+{
+	if (bytesPerPacket == 0 || bytesPerFrame <= 0)
+		return 0;
+	return k_cyclesPerSecond / ceil(bytesPerFrame / bytesPerPacket);
+}
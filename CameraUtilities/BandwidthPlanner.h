@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          BandwidthPlanner.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Sharing of isochronous bus bandwidth between cameras
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+#ifndef _BANDWIDTHPLANNER_H_
+#define _BANDWIDTHPLANNER_H_
+
+#include <map>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// BandwidthPlanner
+// Shares the isochronous bandwidth of an IEEE 1394 bus between the cameras
+// open in this process. Each camera asks for the bytes per packet it needs
+// to reach its target frame rate; if the requests add up to more than the
+// bus can carry per 125us cycle, every camera is scaled back in proportion.
+// Packet sizes are always whole multiples of the camera's unit size.
+//
+// One planner stands for one bus. The budget is the largest maximum packet
+// size any of the cameras reports, i.e. the whole cycle at their bus speed.
+//////////////////////////////////////////////////////////////////////////////
+class BandwidthPlanner
+{
+public:
+	static BandwidthPlanner& Instance();
+
+	int Register();
+	void Unregister(int id);
+
+	// Ask for requestBytes per packet; the camera accepts multiples of
+	// unitBytes up to maxBytes
+	void SetRequest(int id, unsigned int requestBytes, unsigned int unitBytes, unsigned int maxBytes);
+
+	// Bytes per packet this camera may use, 0 if it has made no request
+	unsigned int GetAllotment(int id);
+
+	// Changes whenever a request changes or a camera leaves, i.e. whenever
+	// the allotments may have moved. A camera which last planned at an
+	// older generation should ask for its allotment again.
+	unsigned long GetGeneration();
+
+	// Packet size needed to carry bytesPerFrame at fps (0 = as fast as
+	// possible, i.e. maxBytes), rounded up to a whole unit
+	static unsigned int BytesPerPacketFor(double fps, double bytesPerFrame, unsigned int unitBytes, unsigned int maxBytes);
+
+	// Frame rate the bus allows for a frame of bytesPerFrame
+	static double FrameRateFor(unsigned int bytesPerPacket, double bytesPerFrame);
+
+private:
+	BandwidthPlanner();
+	~BandwidthPlanner();
+
+	void lock();
+	void unlock();
+
+	struct Client
+	{
+		unsigned int request;
+		unsigned int unit;
+		unsigned int max;
+		Client() : request(0), unit(0), max(0) {}
+	};
+
+	std::map<int, Client> clients_;
+	int nextId_;
+	unsigned long generation_;
+
+#ifdef WIN32
+	CRITICAL_SECTION lock_;
+#else
+	pthread_mutex_t lock_;
+#endif
+};
+
+#endif //_BANDWIDTHPLANNER_H_
@@ -0,0 +1,213 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          BurstBuffer.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Preallocated, page-locked frame ring for burst capture to RAM
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#include "BurstBuffer.h"
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#define BURSTBUFFER_BARRIER() MemoryBarrier()
+#else
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#define BURSTBUFFER_BARRIER() __sync_synchronize()
+#endif
+
+namespace
+{
+	// Room for the serialized metadata of a typical frame, so that Push()
+	// does not normally have to allocate
+	const size_t metadataReserve = 4096;
+
+	size_t pageSize()
+	{
+#ifdef WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+#else
+		long size = sysconf(_SC_PAGESIZE);
+		return (size > 0) ? (size_t) size : 4096;
+#endif
+	}
+
+	unsigned char* allocatePages(size_t bytes)
+	{
+#ifdef WIN32
+		return (unsigned char*) VirtualAlloc(NULL, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+		void* p = 0;
+		if (posix_memalign(&p, pageSize(), bytes) != 0)
+			return 0;
+		return (unsigned char*) p;
+#endif
+	}
+
+	void freePages(unsigned char* p, size_t bytes, bool locked)
+	{
+#ifdef WIN32
+		if (locked)
+			VirtualUnlock(p, bytes);
+		VirtualFree(p, 0, MEM_RELEASE);
+#else
+		if (locked)
+			munlock(p, bytes);
+		free(p);
+#endif
+	}
+
+	bool lockPages(unsigned char* p, size_t bytes)
+	{
+#ifdef WIN32
+		// VirtualLock is limited by the minimum working set, which by default
+		// is far smaller than a burst; grow it by the size of the block first
+		HANDLE process = GetCurrentProcess();
+		SIZE_T minWs, maxWs;
+		if (GetProcessWorkingSetSize(process, &minWs, &maxWs))
+			SetProcessWorkingSetSize(process, minWs + bytes, maxWs + bytes);
+		return VirtualLock(p, bytes) != 0;
+#else
+		return mlock(p, bytes) == 0;
+#endif
+	}
+}
+
+BurstBuffer::BurstBuffer() :
+	block_(0),
+	blockBytes_(0),
+	frameBytes_(0),
+	locked_(false),
+	head_(0),
+	tail_(0),
+	highWater_(0)
+{
+}
+
+BurstBuffer::~BurstBuffer()
+{
+	Release();
+}
+
+bool BurstBuffer::Allocate(unsigned int capacity, size_t frameBytes)
+{
+	if (capacity < 1)
+		capacity = 1;
+	size_t page = pageSize();
+	size_t pitch = ((frameBytes + page - 1)/page)*page;
+	if (pitch == 0)
+		pitch = page;
+
+	if (block_ != 0 && capacity == slots_.size() && pitch == frameBytes_)
+	{
+		Reset();
+		return true;
+	}
+
+	Release();
+	if (capacity > ((size_t) -1)/pitch)
+		return false;
+	size_t bytes = pitch*capacity;
+	block_ = allocatePages(bytes);
+	if (block_ == 0)
+		return false;
+	blockBytes_ = bytes;
+	frameBytes_ = pitch;
+
+	// Touch every page now rather than during the burst; if the lock fails
+	// the pages are at least resident until the OS decides otherwise
+	locked_ = lockPages(block_, bytes);
+	memset(block_, 0, bytes);
+
+	slots_.resize(capacity);
+	for (unsigned int i = 0; i < capacity; ++i)
+	{
+		slots_[i].pixels = block_ + (size_t) i*pitch;
+		slots_[i].metadata.reserve(metadataReserve);
+	}
+	Reset();
+	return true;
+}
+
+void BurstBuffer::Release()
+{
+	if (block_ != 0)
+		freePages(block_, blockBytes_, locked_);
+	block_ = 0;
+	blockBytes_ = 0;
+	frameBytes_ = 0;
+	locked_ = false;
+	slots_.clear();
+	Reset();
+}
+
+void BurstBuffer::Reset()
+{
+	head_ = 0;
+	tail_ = 0;
+	highWater_ = 0;
+}
+
+bool BurstBuffer::Push(const unsigned char* pixels, unsigned int width, unsigned int height,
+	unsigned int bytesPerPixel, const std::string& metadata)
+{
+	size_t bytes = (size_t) width*height*bytesPerPixel;
+	if (slots_.empty() || bytes > frameBytes_ || head_ - tail_ >= slots_.size())
+		return false;
+
+	BurstFrame& slot = slots_[head_ % slots_.size()];
+	memcpy(slot.pixels, pixels, bytes);
+	slot.width = width;
+	slot.height = height;
+	slot.bytesPerPixel = bytesPerPixel;
+	slot.metadata.assign(metadata);
+
+	// slot contents must be visible before the consumer can see the new head
+	BURSTBUFFER_BARRIER();
+	head_ = head_ + 1;
+
+	unsigned int size = (unsigned int) (head_ - tail_);
+	if (size > highWater_)
+		highWater_ = size;
+	return true;
+}
+
+const BurstFrame* BurstBuffer::Front()
+{
+	if (head_ == tail_)
+		return 0;
+	// don't read the slot before we have seen the head that published it
+	BURSTBUFFER_BARRIER();
+	return &slots_[tail_ % slots_.size()];
+}
+
+void BurstBuffer::Pop()
+{
+	// finish reading the slot before handing it back to the producer
+	BURSTBUFFER_BARRIER();
+	tail_ = tail_ + 1;
+}
+
+unsigned int BurstBuffer::Size() const
+{
+	return (unsigned int) (head_ - tail_);
+}
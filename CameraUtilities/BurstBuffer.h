@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          BurstBuffer.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Preallocated, page-locked frame ring for burst capture to RAM
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#pragma once
+#ifndef _BURSTBUFFER_H_
+#define _BURSTBUFFER_H_
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// BurstFrame
+// One slot of a BurstBuffer: a fixed window into the ring's pixel block and
+// the serialized metadata of the frame it holds.
+//////////////////////////////////////////////////////////////////////////////
+struct BurstFrame
+{
+	unsigned char* pixels;
+	unsigned int width;
+	unsigned int height;
+	unsigned int bytesPerPixel;
+	std::string metadata;
+
+	BurstFrame() : pixels(0), width(0), height(0), bytesPerPixel(0) {}
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// BurstBuffer
+// Fixed capacity ring of finished frames held in RAM until they can be
+// handed on. All pixel storage is one block allocated up front and, where
+// the OS allows, locked in physical memory so that a burst never waits on a
+// page fault. One producer (the sequence thread) and one consumer (a drain
+// thread, or the sequence thread once the burst is over) share it without
+// locks, in the same way as FrameQueue. Allocate(), Release() and Reset()
+// must only be called while neither side is running.
+//////////////////////////////////////////////////////////////////////////////
+class BurstBuffer
+{
+public:
+	BurstBuffer();
+	~BurstBuffer();
+
+	// Returns false if the memory could not be allocated; failing to lock it
+	// is not an error, see IsLocked(). Keeps the current block if it already
+	// has this shape.
+	bool Allocate(unsigned int capacity, size_t frameBytes);
+	void Release();
+	void Reset();
+
+	// Producer: copy a frame in. Returns false, leaving the ring unchanged,
+	// if it is full or the frame is larger than a slot.
+	bool Push(const unsigned char* pixels, unsigned int width, unsigned int height,
+		unsigned int bytesPerPixel, const std::string& metadata);
+
+	// Consumer: oldest frame (NULL if empty); release it with Pop() once it
+	// has been handed on.
+	const BurstFrame* Front();
+	void Pop();
+
+	unsigned int Size() const;
+	unsigned int Capacity() const {return (unsigned int) slots_.size();}
+	unsigned int HighWater() const {return highWater_;}
+	size_t GetFrameBytes() const {return frameBytes_;}
+	size_t GetAllocatedBytes() const {return blockBytes_;}
+	bool IsLocked() const {return locked_;}
+
+private:
+	BurstBuffer(const BurstBuffer&);
+	BurstBuffer& operator=(const BurstBuffer&);
+
+	unsigned char* block_;
+	size_t blockBytes_;
+	size_t frameBytes_;			// slot pitch, a whole number of pages
+	bool locked_;
+	std::vector<BurstFrame> slots_;
+	volatile unsigned long head_;	// frames pushed, written by the producer only
+	volatile unsigned long tail_;	// frames popped, written by the consumer only
+	volatile unsigned int highWater_;
+};
+
+#endif //_BURSTBUFFER_H_
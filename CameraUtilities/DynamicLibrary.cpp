@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          DynamicLibrary.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Portable loading of vendor SDK libraries
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#include "DynamicLibrary.h"
+#include <map>
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+struct DynamicLibraryHandle
+{
+	void* os;	//HMODULE or dlopen handle
+	const DynamicLibrary::VirtualSymbol* table;
+};
+
+namespace
+{
+	typedef std::map<std::string, const DynamicLibrary::VirtualSymbol*> VirtualMap;
+
+	// Registration happens while loading the library, under the caller's
+	// lock, so the registry itself is not locked
+	VirtualMap& virtualLibraries()
+	{
+		static VirtualMap libraries;
+		return libraries;
+	}
+
+	std::string lastError;
+}
+
+void DynamicLibrary::RegisterVirtual(const char* name, const VirtualSymbol* table)
+{
+	virtualLibraries()[name] = table;
+}
+
+DynamicLibrary::Handle DynamicLibrary::Open(const char* name)
+{
+	if (name == 0 || name[0] == 0)
+	{
+		lastError = "No library name given";
+		return 0;
+	}
+
+	VirtualMap::const_iterator it = virtualLibraries().find(name);
+	if (it != virtualLibraries().end())
+	{
+		Handle library = new DynamicLibraryHandle;
+		library->os = 0;
+		library->table = it->second;
+		return library;
+	}
+
+#ifdef WIN32
+	void* os = (void*) LoadLibraryA(name);
+	if (os == 0)
+	{
+		lastError = std::string("Could not load ") + name;
+		return 0;
+	}
+#else
+	void* os = dlopen(name, RTLD_NOW | RTLD_LOCAL);
+	if (os == 0)
+	{
+		const char* err = dlerror();
+		lastError = err ? err : std::string("Could not load ") + name;
+		return 0;
+	}
+#endif
+
+	Handle library = new DynamicLibraryHandle;
+	library->os = os;
+	library->table = 0;
+	return library;
+}
+
+void DynamicLibrary::Close(Handle library)
+{
+	if (library == 0)
+		return;
+	if (library->os != 0)
+	{
+#ifdef WIN32
+		FreeLibrary((HMODULE) library->os);
+#else
+		dlclose(library->os);
+#endif
+	}
+	delete library;
+}
+
+DynamicLibrary::Symbol DynamicLibrary::GetSymbol(Handle library, const char* name)
+{
+	if (library == 0)
+		return 0;
+
+	if (library->table != 0)
+	{
+		for (const VirtualSymbol* s = library->table; s->name != 0; ++s)
+		{
+			if (strcmp(s->name, name) == 0)
+				return s->function;
+		}
+		return 0;
+	}
+
+#ifdef WIN32
+	return (Symbol) GetProcAddress((HMODULE) library->os, name);
+#else
+	return (Symbol) dlsym(library->os, name);
+#endif
+}
+
+bool DynamicLibrary::IsVirtual(Handle library)
+{
+	return library != 0 && library->table != 0;
+}
+
+std::string DynamicLibrary::GetLastError()
+{
+	return lastError;
+}
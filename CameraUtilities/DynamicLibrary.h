@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          DynamicLibrary.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Portable loading of vendor SDK libraries
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#pragma once
+#ifndef _DYNAMICLIBRARY_H_
+#define _DYNAMICLIBRARY_H_
+
+#include <string>
+
+// Calling convention of the vendor SDK entry points. The Windows SDKs export
+// __stdcall functions; elsewhere there is only the one convention.
+#ifdef WIN32
+#define DYNLIB_STDCALL __stdcall
+#else
+#define DYNLIB_STDCALL
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// DynamicLibrary
+// LoadLibrary/GetProcAddress on Windows and dlopen/dlsym elsewhere, behind
+// one interface so that the SDK wrappers are not tied to windows.h.
+//
+// A "virtual" library is a table of functions compiled into the adapter and
+// registered under a name. Open() looks such names up before going to the
+// OS loader, so a simulated backend can stand in for a vendor DLL without
+// the wrapper knowing the difference.
+//////////////////////////////////////////////////////////////////////////////
+class DynamicLibrary
+{
+public:
+	typedef struct DynamicLibraryHandle* Handle;
+	typedef void (*Symbol)();
+
+	struct VirtualSymbol
+	{
+		const char* name;
+		Symbol function;
+	};
+
+	// Register a table of entry points, terminated by {0, 0}, under a name.
+	// The table must outlive every handle opened from it.
+	static void RegisterVirtual(const char* name, const VirtualSymbol* table);
+
+	// Returns 0 on failure; GetLastError() then says why
+	static Handle Open(const char* name);
+	static void Close(Handle library);
+	static Symbol GetSymbol(Handle library, const char* name);
+	static bool IsVirtual(Handle library);
+
+	static std::string GetLastError();
+};
+
+#endif //_DYNAMICLIBRARY_H_
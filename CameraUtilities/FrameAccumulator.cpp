@@ -0,0 +1,194 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameAccumulator.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Summing of consecutive frames into a 32-bit accumulator
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "FrameAccumulator.h"
+#include <string.h>
+
+// SSE2: MSVC always compiles the kernels and checks the CPU at run time
+// (x86 builds may run on anything); gcc/clang when the target has it.
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define ACCUMULATE_SSE2
+#define ACCUMULATE_RUNTIME_CHECK
+#include <intrin.h>
+#include <emmintrin.h>
+#elif defined(__SSE2__)
+#define ACCUMULATE_SSE2
+#include <emmintrin.h>
+#endif
+
+bool AccumulateHasSimd()
+{
+#if defined(ACCUMULATE_RUNTIME_CHECK)
+	static int hasSse2 = -1;
+	if (hasSse2 < 0)
+	{
+		int info[4];
+		__cpuid(info, 1);
+		hasSse2 = (info[3] & (1 << 26)) ? 1 : 0;
+	}
+	return hasSse2 != 0;
+#elif defined(ACCUMULATE_SSE2)
+	return true;
+#else
+	return false;
+#endif
+}
+
+#ifdef ACCUMULATE_SSE2
+
+// Widen 8 16-bit pixels to two sets of 4 32-bit lanes and add
+static size_t addU16Sse2(unsigned int* sum, const unsigned short* frame, size_t n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t blocks = n/8;
+	for (size_t i = 0; i < blocks; ++i, frame += 8, sum += 8)
+	{
+		__m128i in = _mm_loadu_si128((const __m128i*) frame);
+		__m128i lo = _mm_loadu_si128((const __m128i*) sum);
+		__m128i hi = _mm_loadu_si128((const __m128i*) (sum + 4));
+		lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(in, zero));
+		hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(in, zero));
+		_mm_storeu_si128((__m128i*) sum, lo);
+		_mm_storeu_si128((__m128i*) (sum + 4), hi);
+	}
+	return blocks*8;
+}
+
+// 16 8-bit pixels: widen to 16 bits, then to 32
+static size_t addU8Sse2(unsigned int* sum, const unsigned char* frame, size_t n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t blocks = n/16;
+	for (size_t i = 0; i < blocks; ++i, frame += 16, sum += 16)
+	{
+		__m128i in = _mm_loadu_si128((const __m128i*) frame);
+		__m128i w[2];
+		w[0] = _mm_unpacklo_epi8(in, zero);
+		w[1] = _mm_unpackhi_epi8(in, zero);
+		for (int k = 0; k < 2; ++k)
+		{
+			unsigned int* s = sum + 8*k;
+			__m128i lo = _mm_loadu_si128((const __m128i*) s);
+			__m128i hi = _mm_loadu_si128((const __m128i*) (s + 4));
+			_mm_storeu_si128((__m128i*) s, _mm_add_epi32(lo, _mm_unpacklo_epi16(w[k], zero)));
+			_mm_storeu_si128((__m128i*) (s + 4), _mm_add_epi32(hi, _mm_unpackhi_epi16(w[k], zero)));
+		}
+	}
+	return blocks*16;
+}
+
+#endif
+
+FrameAccumulator::FrameAccumulator() :
+	nPixels_(0),
+	frames_(1),
+	count_(0),
+	variance_(false)
+{
+}
+
+void FrameAccumulator::Start(size_t nPixels, unsigned int frames, bool variance)
+{
+	nPixels_ = nPixels;
+	frames_ = (frames > 0) ? frames : 1;
+	variance_ = variance;
+	sum_.resize(nPixels_);
+	sumSq_.resize(variance_ ? nPixels_ : 0);
+	Restart();
+}
+
+void FrameAccumulator::Restart()
+{
+	if (nPixels_ > 0)
+	{
+		memset(&sum_[0], 0, nPixels_*sizeof(unsigned int));
+		if (variance_)
+			memset(&sumSq_[0], 0, nPixels_*sizeof(double));
+	}
+	count_ = 0;
+}
+
+void FrameAccumulator::beginFrame()
+{
+	if (count_ >= frames_)
+		Restart();
+}
+
+bool FrameAccumulator::Add(const unsigned short* frame)
+{
+	beginFrame();
+	unsigned int* sum = (nPixels_ > 0) ? &sum_[0] : 0;
+	size_t done = 0;
+#ifdef ACCUMULATE_SSE2
+	if (AccumulateHasSimd())
+		done = addU16Sse2(sum, frame, nPixels_);
+#endif
+	for (size_t i = done; i < nPixels_; ++i)
+		sum[i] += frame[i];
+	if (variance_)
+	{
+		for (size_t i = 0; i < nPixels_; ++i)
+			sumSq_[i] += (double) frame[i]*frame[i];
+	}
+	return ++count_ >= frames_;
+}
+
+bool FrameAccumulator::Add(const unsigned char* frame)
+{
+	beginFrame();
+	unsigned int* sum = (nPixels_ > 0) ? &sum_[0] : 0;
+	size_t done = 0;
+#ifdef ACCUMULATE_SSE2
+	if (AccumulateHasSimd())
+		done = addU8Sse2(sum, frame, nPixels_);
+#endif
+	for (size_t i = done; i < nPixels_; ++i)
+		sum[i] += frame[i];
+	if (variance_)
+	{
+		for (size_t i = 0; i < nPixels_; ++i)
+			sumSq_[i] += (double) frame[i]*frame[i];
+	}
+	return ++count_ >= frames_;
+}
+
+void FrameAccumulator::SumToFloat(float* out) const
+{
+	for (size_t i = 0; i < nPixels_; ++i)
+		out[i] = (float) sum_[i];
+}
+
+void FrameAccumulator::VarianceToFloat(float* out) const
+{
+	if (!variance_ || count_ < 2)
+	{
+		memset(out, 0, nPixels_*sizeof(float));
+		return;
+	}
+
+	double n = count_;
+	for (size_t i = 0; i < nPixels_; ++i)
+	{
+		double s = sum_[i];
+		double v = (sumSq_[i] - s*s/n)/(n - 1);
+		out[i] = (float) ((v > 0) ? v : 0);
+	}
+}
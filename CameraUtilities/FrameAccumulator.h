@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameAccumulator.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Summing of consecutive frames into a 32-bit accumulator
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+#ifndef _FRAMEACCUMULATOR_H_
+#define _FRAMEACCUMULATOR_H_
+
+#include <vector>
+#include <cstddef>
+
+//////////////////////////////////////////////////////////////////////////////
+// FrameAccumulator
+// Sums a fixed number of consecutive 8 or 16-bit frames per pixel, so that
+// a photon-starved sequence can be delivered as one frame per N exposures.
+// The sum is kept as 32-bit integers and added with SSE2 where available;
+// it is converted to float only once complete, for the 32-bit float image
+// the core takes. Optionally the per-pixel sum of squares
+// is kept as well, for a variance image.
+//////////////////////////////////////////////////////////////////////////////
+class FrameAccumulator
+{
+public:
+	// Most 16-bit frames whose sum SumToFloat still gives exactly:
+	// 256*65535 < 2^24, the last integer a float holds without rounding
+	static const unsigned int MaxExactFrames = 256;
+
+	FrameAccumulator();
+	~FrameAccumulator() {};
+
+	// Size for frames of nPixels and sum `frames` of them
+	void Start(size_t nPixels, unsigned int frames, bool variance);
+
+	// Empty the sums, keeping the size and frame count
+	void Restart();
+
+	// Add a frame. Returns true once the requested number has been summed;
+	// the next Add after that starts a new sum.
+	bool Add(const unsigned short* frame);
+	bool Add(const unsigned char* frame);
+
+	bool IsComplete() const {return count_ >= frames_;}
+	unsigned int GetCount() const {return count_;}
+	unsigned int GetFrames() const {return frames_;}
+	bool HasVariance() const {return variance_;}
+	const unsigned int* GetSum() const {return sum_.empty() ? 0 : &sum_[0];}
+
+	// The sum as 32-bit float, exact while it stays below 2^24 (see
+	// MaxExactFrames)
+	void SumToFloat(float* out) const;
+
+	// Per-pixel sample variance over the summed frames (0 for a single frame)
+	void VarianceToFloat(float* out) const;
+
+private:
+	void beginFrame();
+
+	std::vector<unsigned int> sum_;
+	std::vector<double> sumSq_;
+	size_t nPixels_;
+	unsigned int frames_;
+	unsigned int count_;
+	bool variance_;
+};
+
+// True if FrameAccumulator uses the SSE2 kernels on this machine
+bool AccumulateHasSimd();
+
+#endif //_FRAMEACCUMULATOR_H_
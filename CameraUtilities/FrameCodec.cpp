@@ -0,0 +1,654 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameCodec.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Lossless compression of 16-bit frames for streaming
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#include "FrameCodec.h"
+#include "FrameAccumulator.h"
+#include "FramePacer.h"
+#include <string.h>
+
+#ifdef WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define CODEC_SSE2
+#include <emmintrin.h>
+#elif defined(__SSE2__)
+#define CODEC_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	const unsigned int blockValues = 32;
+	const size_t headerBytes = 20;
+	const size_t maxBlockBytes = 1 + 2*blockValues;
+
+	size_t maxStripeBytes(size_t pixels)
+	{
+		return ((pixels + blockValues - 1)/blockValues)*maxBlockBytes;
+	}
+
+	inline unsigned short zigzag(int diff)
+	{
+		short r = (short) diff;
+		return (unsigned short) ((r << 1) ^ (r >> 15));
+	}
+
+	inline unsigned short unzigzag(unsigned short z)
+	{
+		return (unsigned short) ((z >> 1) ^ (-(int) (z & 1)));
+	}
+
+	void putU32(unsigned char* p, unsigned int v)
+	{
+		p[0] = (unsigned char) v;
+		p[1] = (unsigned char) (v >> 8);
+		p[2] = (unsigned char) (v >> 16);
+		p[3] = (unsigned char) (v >> 24);
+	}
+
+	unsigned int getU32(const unsigned char* p)
+	{
+		return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+	}
+
+#ifdef CODEC_SSE2
+	// Residuals of columns 1.. of a row, 8 at a time; predicted from the left
+	// neighbour, or from the rounded average of left and up if up is given.
+	// Returns the first column left for the scalar loop.
+	unsigned int residualRowSse2(unsigned short* res, const unsigned short* row, const unsigned short* up, unsigned int width)
+	{
+		unsigned int x = 1;
+		for (; x + 8 <= width; x += 8)
+		{
+			__m128i cur = _mm_loadu_si128((const __m128i*) (row + x));
+			__m128i pred = _mm_loadu_si128((const __m128i*) (row + x - 1));
+			if (up != 0)
+				pred = _mm_avg_epu16(pred, _mm_loadu_si128((const __m128i*) (up + x)));
+			__m128i r = _mm_sub_epi16(cur, pred);
+			__m128i z = _mm_xor_si128(_mm_slli_epi16(r, 1), _mm_srai_epi16(r, 15));
+			_mm_storeu_si128((__m128i*) (res + x), z);
+		}
+		return x;
+	}
+#endif
+
+	void residualRow(unsigned short* res, const unsigned short* row, const unsigned short* up, unsigned int width)
+	{
+		res[0] = zigzag(row[0] - (up ? up[0] : 0));
+		unsigned int x = 1;
+#ifdef CODEC_SSE2
+		if (AccumulateHasSimd())
+			x = residualRowSse2(res, row, up, width);
+#endif
+		if (up != 0)
+		{
+			for (; x < width; ++x)
+				res[x] = zigzag(row[x] - ((row[x - 1] + up[x] + 1) >> 1));
+		}
+		else
+		{
+			for (; x < width; ++x)
+				res[x] = zigzag(row[x] - row[x - 1]);
+		}
+	}
+
+	// Pack 32 values at the width of the largest
+	unsigned char* packBlock(unsigned char* out, const unsigned short* v)
+	{
+		unsigned int all = 0;
+		for (unsigned int i = 0; i < blockValues; ++i)
+			all |= v[i];
+		unsigned int bits = 0;
+		while (bits < 16 && (all >> bits) != 0)
+			++bits;
+
+		*out++ = (unsigned char) bits;
+		if (bits == 0)
+			return out;
+		if (bits == 16)
+		{
+			memcpy(out, v, 2*blockValues);	//little-endian host
+			return out + 2*blockValues;
+		}
+
+		unsigned long long acc = 0;
+		unsigned int n = 0;
+		for (unsigned int i = 0; i < blockValues; ++i)
+		{
+			acc |= (unsigned long long) v[i] << n;
+			n += bits;
+			if (n >= 32)
+			{
+				putU32(out, (unsigned int) acc);
+				out += 4;
+				acc >>= 32;
+				n -= 32;
+			}
+		}
+		return out;
+	}
+
+	// Returns NULL if the block runs past end
+	const unsigned char* unpackBlock(const unsigned char* in, const unsigned char* end, unsigned short* v)
+	{
+		if (in >= end)
+			return 0;
+		unsigned int bits = *in++;
+		if (bits > 16 || (size_t) (end - in) < 4*bits)
+			return 0;
+		if (bits == 0)
+		{
+			memset(v, 0, 2*blockValues);
+			return in;
+		}
+		if (bits == 16)
+		{
+			memcpy(v, in, 2*blockValues);
+			return in + 2*blockValues;
+		}
+
+		unsigned long long acc = 0;
+		unsigned int n = 0;
+		unsigned int mask = (1u << bits) - 1;
+		for (unsigned int i = 0; i < blockValues; ++i)
+		{
+			if (n < bits)
+			{
+				acc |= (unsigned long long) getU32(in) << n;
+				in += 4;
+				n += 32;
+			}
+			v[i] = (unsigned short) (acc & mask);
+			acc >>= bits;
+			n -= bits;
+		}
+		return in;
+	}
+
+	unsigned int processorCount()
+	{
+#ifdef WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwNumberOfProcessors;
+#else
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		return (n > 0) ? (unsigned int) n : 1;
+#endif
+	}
+}
+
+bool CodecHasSimd()
+{
+#ifdef CODEC_SSE2
+	return AccumulateHasSimd();
+#else
+	return false;
+#endif
+}
+
+FrameCodec::FrameCodec() :
+	compress_(true),
+	srcPixels_(0),
+	dstPixels_(0),
+	srcBytes_(0),
+	width_(0),
+	height_(0),
+	stripes_(0),
+	failed_(false),
+	nextStripe_(0),
+	stripesDone_(0),
+	busy_(0),
+	generation_(0),
+	quit_(false)
+{
+#ifdef WIN32
+	InitializeCriticalSection(&lock_);
+	InitializeConditionVariable(&jobCond_);
+	InitializeConditionVariable(&doneCond_);
+#else
+	pthread_mutex_init(&lock_, 0);
+	pthread_cond_init(&jobCond_, 0);
+	pthread_cond_init(&doneCond_, 0);
+#endif
+}
+
+FrameCodec::~FrameCodec()
+{
+	stopWorkers();
+#ifdef WIN32
+	DeleteCriticalSection(&lock_);
+#else
+	pthread_cond_destroy(&doneCond_);
+	pthread_cond_destroy(&jobCond_);
+	pthread_mutex_destroy(&lock_);
+#endif
+}
+
+void FrameCodec::SetThreads(unsigned int threads)
+{
+	if (threads == 0)
+		threads = processorCount();
+	if (threads == GetThreads())
+		return;
+	stopWorkers();
+	startWorkers(threads - 1);
+}
+
+size_t FrameCodec::MaxCompressedBytes(unsigned int width, unsigned int height)
+{
+	unsigned int stripes = (height + stripeRows - 1)/stripeRows;
+	size_t bytes = headerBytes + 4*(size_t) stripes;
+	for (unsigned int s = 0; s < stripes; ++s)
+	{
+		unsigned int rows = (s + 1 < stripes) ? (unsigned int) stripeRows : height - s*stripeRows;
+		bytes += maxStripeBytes((size_t) rows*width);
+	}
+	return bytes;
+}
+
+size_t FrameCodec::Compress(const unsigned short* src, unsigned int width, unsigned int height, unsigned char* dst)
+{
+	unsigned int stripes = (height + stripeRows - 1)/stripeRows;
+	beginJob();
+	compress_ = true;
+	srcPixels_ = src;
+	width_ = width;
+	height_ = height;
+	stripes_ = stripes;
+	stripeOffset_.resize(stripes);
+	stripeBytes_.resize(stripes);
+	size_t codeBytes = 0;
+	for (unsigned int s = 0; s < stripes; ++s)
+	{
+		unsigned int rows = (s + 1 < stripes) ? (unsigned int) stripeRows : height - s*stripeRows;
+		stripeOffset_[s] = codeBytes;
+		codeBytes += maxStripeBytes((size_t) rows*width);
+	}
+	if (code_.size() < codeBytes)
+		code_.resize(codeBytes);
+	if (residual_.size() < (size_t) width*height)
+		residual_.resize((size_t) width*height);
+
+	if (stripes > 0)
+		runStripes();
+	unlock();
+
+	memcpy(dst, "FC16", 4);
+	putU32(dst + 4, width);
+	putU32(dst + 8, height);
+	putU32(dst + 12, stripeRows);
+	putU32(dst + 16, stripes);
+	unsigned char* out = dst + headerBytes + 4*(size_t) stripes;
+	for (unsigned int s = 0; s < stripes; ++s)
+	{
+		putU32(dst + headerBytes + 4*(size_t) s, (unsigned int) stripeBytes_[s]);
+		memcpy(out, &code_[stripeOffset_[s]], stripeBytes_[s]);
+		out += stripeBytes_[s];
+	}
+	return out - dst;
+}
+
+bool FrameCodec::GetFrameSize(const unsigned char* src, size_t bytes, unsigned int& width, unsigned int& height)
+{
+	if (bytes < headerBytes || memcmp(src, "FC16", 4) != 0)
+		return false;
+	width = getU32(src + 4);
+	height = getU32(src + 8);
+	return true;
+}
+
+bool FrameCodec::Decompress(const unsigned char* src, size_t bytes, unsigned short* dst, unsigned int width, unsigned int height)
+{
+	unsigned int w, h;
+	if (!GetFrameSize(src, bytes, w, h) || w != width || h != height)
+		return false;
+	unsigned int stripes = (height + stripeRows - 1)/stripeRows;
+	if (getU32(src + 12) != stripeRows || getU32(src + 16) != stripes)
+		return false;
+	size_t table = headerBytes + 4*(size_t) stripes;
+	if (bytes < table)
+		return false;
+
+	beginJob();
+	compress_ = false;
+	srcBytes_ = src;
+	dstPixels_ = dst;
+	width_ = width;
+	height_ = height;
+	stripes_ = stripes;
+	stripeOffset_.resize(stripes);
+	stripeBytes_.resize(stripes);
+	size_t offset = table;
+	for (unsigned int s = 0; s < stripes; ++s)
+	{
+		stripeOffset_[s] = offset;
+		stripeBytes_[s] = getU32(src + headerBytes + 4*(size_t) s);
+		if (stripeBytes_[s] > bytes - offset)
+		{
+			unlock();
+			return false;
+		}
+		offset += stripeBytes_[s];
+	}
+	if (residual_.size() < (size_t) width*height)
+		residual_.resize((size_t) width*height);
+
+	bool ok = true;
+	if (stripes > 0)
+	{
+		runStripes();
+		ok = !failed_;
+	}
+	unlock();
+	return ok;
+}
+
+void FrameCodec::codeStripe(unsigned int stripe)
+{
+	unsigned int y0 = stripe*stripeRows;
+	unsigned int rows = (y0 + stripeRows <= height_) ? (unsigned int) stripeRows : height_ - y0;
+	size_t pixels = (size_t) rows*width_;
+	unsigned short* res = &residual_[(size_t) y0*width_];
+	size_t fullBlocks = pixels/blockValues;
+	size_t tail = pixels - fullBlocks*blockValues;
+	unsigned short last[blockValues];
+
+	if (compress_)
+	{
+		const unsigned short* src = srcPixels_ + (size_t) y0*width_;
+		for (unsigned int y = 0; y < rows; ++y)
+			residualRow(res + (size_t) y*width_, src + (size_t) y*width_, (y > 0) ? src + (size_t) (y - 1)*width_ : 0, width_);
+
+		unsigned char* start = &code_[stripeOffset_[stripe]];
+		unsigned char* out = start;
+		for (size_t b = 0; b < fullBlocks; ++b)
+			out = packBlock(out, res + b*blockValues);
+		if (tail > 0)
+		{
+			memset(last, 0, sizeof(last));
+			memcpy(last, res + fullBlocks*blockValues, tail*sizeof(unsigned short));
+			out = packBlock(out, last);
+		}
+		stripeBytes_[stripe] = out - start;
+		return;
+	}
+
+	const unsigned char* in = srcBytes_ + stripeOffset_[stripe];
+	const unsigned char* end = in + stripeBytes_[stripe];
+	for (size_t b = 0; b < fullBlocks && in != 0; ++b)
+		in = unpackBlock(in, end, res + b*blockValues);
+	if (in != 0 && tail > 0)
+	{
+		in = unpackBlock(in, end, last);
+		if (in != 0)
+			memcpy(res + fullBlocks*blockValues, last, tail*sizeof(unsigned short));
+	}
+	if (in != end)
+	{
+		lock();
+		failed_ = true;
+		unlock();
+		return;
+	}
+
+	unsigned short* dst = dstPixels_ + (size_t) y0*width_;
+	unsigned short* row = dst;
+	row[0] = unzigzag(res[0]);
+	for (unsigned int x = 1; x < width_; ++x)
+		row[x] = (unsigned short) (row[x - 1] + unzigzag(res[x]));
+	for (unsigned int y = 1; y < rows; ++y)
+	{
+		const unsigned short* up = row;
+		const unsigned short* r = res + (size_t) y*width_;
+		row += width_;
+		row[0] = (unsigned short) (up[0] + unzigzag(r[0]));
+		for (unsigned int x = 1; x < width_; ++x)
+			row[x] = (unsigned short) (((row[x - 1] + up[x] + 1) >> 1) + unzigzag(r[x]));
+	}
+}
+
+/**
+* Take the lock for setting up a job, once no worker is still looking at the
+* previous one. A worker woken late for a job can still be about to find it
+* finished; the job fields must not change under it.
+*/
+void FrameCodec::beginJob()
+{
+	lock();
+	while (busy_ > 0)
+		waitForDone();
+}
+
+/**
+* Code every stripe of the job set up since beginJob(), on the workers and
+* the caller. Called, and returns, with the lock held.
+*/
+void FrameCodec::runStripes()
+{
+	nextStripe_ = 0;
+	stripesDone_ = 0;
+	failed_ = false;
+	++generation_;
+	signalJob();
+	unlock();
+
+	work();
+
+	lock();
+	while (stripesDone_ < stripes_)
+		waitForDone();
+}
+
+void FrameCodec::work()
+{
+	for (;;)
+	{
+		lock();
+		if (nextStripe_ >= stripes_)
+		{
+			unlock();
+			return;
+		}
+		unsigned int stripe = nextStripe_++;
+		unlock();
+
+		codeStripe(stripe);
+
+		lock();
+		if (++stripesDone_ == stripes_)
+			signalDone();
+		unlock();
+	}
+}
+
+void FrameCodec::workerLoop()
+{
+	lock();
+	unsigned long seen = generation_;
+	for (;;)
+	{
+		while (generation_ == seen && !quit_)
+			waitForJob();
+		if (quit_)
+			break;
+		seen = generation_;
+		++busy_;
+		unlock();
+		work();
+		lock();
+		if (--busy_ == 0)
+			signalDone();
+	}
+	unlock();
+}
+
+void FrameCodec::startWorkers(unsigned int count)
+{
+	quit_ = false;
+	for (unsigned int i = 0; i < count; ++i)
+	{
+#ifdef WIN32
+		HANDLE h = (HANDLE) _beginthreadex(NULL, 0, workerThread, this, 0, NULL);
+		if (h == 0)
+			break;
+		workers_.push_back(h);
+#else
+		pthread_t t;
+		if (pthread_create(&t, 0, workerThread, this) != 0)
+			break;
+		workers_.push_back(t);
+#endif
+	}
+}
+
+void FrameCodec::stopWorkers()
+{
+	lock();
+	quit_ = true;
+	signalJob();
+	unlock();
+	for (size_t i = 0; i < workers_.size(); ++i)
+	{
+#ifdef WIN32
+		WaitForSingleObject(workers_[i], INFINITE);
+		CloseHandle(workers_[i]);
+#else
+		pthread_join(workers_[i], 0);
+#endif
+	}
+	workers_.clear();
+	quit_ = false;
+}
+
+#ifdef WIN32
+
+unsigned __stdcall FrameCodec::workerThread(void* param)
+{
+	((FrameCodec*) param)->workerLoop();
+	return 0;
+}
+
+void FrameCodec::lock()
+{
+	EnterCriticalSection(&lock_);
+}
+
+void FrameCodec::unlock()
+{
+	LeaveCriticalSection(&lock_);
+}
+
+void FrameCodec::waitForJob()
+{
+	SleepConditionVariableCS(&jobCond_, &lock_, INFINITE);
+}
+
+void FrameCodec::waitForDone()
+{
+	SleepConditionVariableCS(&doneCond_, &lock_, INFINITE);
+}
+
+void FrameCodec::signalJob()
+{
+	WakeAllConditionVariable(&jobCond_);
+}
+
+void FrameCodec::signalDone()
+{
+	WakeConditionVariable(&doneCond_);
+}
+
+#else
+
+void* FrameCodec::workerThread(void* param)
+{
+	((FrameCodec*) param)->workerLoop();
+	return 0;
+}
+
+void FrameCodec::lock()
+{
+	pthread_mutex_lock(&lock_);
+}
+
+void FrameCodec::unlock()
+{
+	pthread_mutex_unlock(&lock_);
+}
+
+void FrameCodec::waitForJob()
+{
+	pthread_cond_wait(&jobCond_, &lock_);
+}
+
+void FrameCodec::waitForDone()
+{
+	pthread_cond_wait(&doneCond_, &lock_);
+}
+
+void FrameCodec::signalJob()
+{
+	pthread_cond_broadcast(&jobCond_);
+}
+
+void FrameCodec::signalDone()
+{
+	pthread_cond_signal(&doneCond_);
+}
+
+#endif
+
+FrameCodecBenchmark BenchmarkFrameCodec(FrameCodec& codec, const unsigned short* frame,
+	unsigned int width, unsigned int height, int repeats)
+{
+	FrameCodecBenchmark result;
+	size_t pixels = (size_t) width*height;
+	if (pixels == 0)
+		return result;
+	if (repeats < 1)
+		repeats = 1;
+
+	std::vector<unsigned char> packed(FrameCodec::MaxCompressedBytes(width, height));
+	std::vector<unsigned short> unpacked(pixels);
+	size_t bytes = 0;
+	bool ok = true;
+
+	double t0 = MonotonicClock::NowUs();
+	for (int r = 0; r < repeats; ++r)
+		bytes = codec.Compress(frame, width, height, &packed[0]);
+	double t1 = MonotonicClock::NowUs();
+	for (int r = 0; r < repeats; ++r)
+		ok = codec.Decompress(&packed[0], bytes, &unpacked[0], width, height) && ok;
+	double t2 = MonotonicClock::NowUs();
+
+	double frameBytes = 2.0*pixels;
+	result.ratio = frameBytes/bytes;
+	result.compressMBps = (t1 > t0) ? frameBytes*repeats/(t1 - t0) : 0;	//bytes/us = MB/s
+	result.decompressMBps = (t2 > t1) ? frameBytes*repeats/(t2 - t1) : 0;
+	result.lossless = ok && memcmp(&unpacked[0], frame, 2*pixels) == 0;
+	return result;
+}
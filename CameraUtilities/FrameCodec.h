@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameCodec.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Lossless compression of 16-bit frames for streaming
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#pragma once
+#ifndef _FRAMECODEC_H_
+#define _FRAMECODEC_H_
+
+#include <vector>
+#include <cstddef>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// FrameCodec
+// Lossless compression of 16-bit frames, fast enough to run on the sequence
+// thread. Each pixel is predicted from the average of its left and upper
+// neighbours (the left one alone on a stripe's first row), the residual is
+// zigzag mapped to an unsigned value, and blocks of 32 residuals are packed
+// at the bit width of the largest. Frames that use 12 of 16 bits, or that
+// are mostly dark, shrink accordingly; incompressible frames grow by 1/64.
+//
+// The frame is cut into stripes of stripeRows rows that are coded
+// independently, spread over a small pool of worker threads. The stripe
+// size is fixed, so the output does not depend on the number of threads.
+//
+// Compressed layout (all little-endian):
+//     "FC16", u32 width, u32 height, u32 stripeRows, u32 stripes,
+//     u32 bytes of each stripe, then the stripes;
+//     a stripe is blocks of [u8 bits][4*bits bytes of 32 packed residuals]
+//////////////////////////////////////////////////////////////////////////////
+class FrameCodec
+{
+public:
+	FrameCodec();
+	~FrameCodec();
+
+	// Threads taking part in Compress/Decompress, counting the caller;
+	// 0 for one per processor
+	void SetThreads(unsigned int threads);
+	unsigned int GetThreads() const {return (unsigned int) workers_.size() + 1;}
+
+	// Upper bound of the compressed size of a frame
+	static size_t MaxCompressedBytes(unsigned int width, unsigned int height);
+
+	// Returns the compressed size; dst must hold MaxCompressedBytes()
+	size_t Compress(const unsigned short* src, unsigned int width, unsigned int height, unsigned char* dst);
+
+	// Returns false if src is not a complete compressed frame of this size
+	bool Decompress(const unsigned char* src, size_t bytes, unsigned short* dst, unsigned int width, unsigned int height);
+
+	// Frame size recorded in a compressed frame's header
+	static bool GetFrameSize(const unsigned char* src, size_t bytes, unsigned int& width, unsigned int& height);
+
+	enum {stripeRows = 64};
+
+private:
+	FrameCodec(const FrameCodec&);
+	FrameCodec& operator=(const FrameCodec&);
+
+	void startWorkers(unsigned int count);
+	void stopWorkers();
+	void beginJob();
+	void runStripes();
+	void work();
+	void codeStripe(unsigned int stripe);
+	void workerLoop();
+	void lock();
+	void unlock();
+	void waitForJob();
+	void waitForDone();
+	void signalJob();
+	void signalDone();
+#ifdef WIN32
+	static unsigned __stdcall workerThread(void* param);
+#else
+	static void* workerThread(void* param);
+#endif
+
+	// Current job, set by the caller under the lock before it is published
+	bool compress_;
+	const unsigned short* srcPixels_;
+	unsigned short* dstPixels_;
+	const unsigned char* srcBytes_;
+	unsigned int width_;
+	unsigned int height_;
+	unsigned int stripes_;
+	std::vector<size_t> stripeOffset_;	// where each stripe's code starts
+	std::vector<size_t> stripeBytes_;
+	std::vector<unsigned char> code_;	// compressed stripes at their worst case offsets
+	std::vector<unsigned short> residual_;
+	bool failed_;
+
+	unsigned int nextStripe_;
+	unsigned int stripesDone_;
+	unsigned int busy_;			// workers still inside work() for some job
+	unsigned long generation_;
+	bool quit_;
+
+#ifdef WIN32
+	std::vector<HANDLE> workers_;
+	CRITICAL_SECTION lock_;
+	CONDITION_VARIABLE jobCond_;
+	CONDITION_VARIABLE doneCond_;
+#else
+	std::vector<pthread_t> workers_;
+	pthread_mutex_t lock_;
+	pthread_cond_t jobCond_;
+	pthread_cond_t doneCond_;
+#endif
+};
+
+struct FrameCodecBenchmark
+{
+	double ratio;				// uncompressed/compressed size
+	double compressMBps;		// uncompressed MB per second
+	double decompressMBps;
+	bool lossless;				// decompressed frame matched the original
+
+	FrameCodecBenchmark() : ratio(0), compressMBps(0), decompressMBps(0), lossless(false) {}
+};
+
+// Compress and decompress a frame repeats times
+FrameCodecBenchmark BenchmarkFrameCodec(FrameCodec& codec, const unsigned short* frame,
+	unsigned int width, unsigned int height, int repeats);
+
+// True if the residuals are computed with SSE2 on this machine
+bool CodecHasSimd();
+
+#endif //_FRAMECODEC_H_
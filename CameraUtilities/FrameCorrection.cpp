@@ -0,0 +1,299 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameCorrection.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Dark-frame and flat-field correction of 16-bit frames
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "FrameCorrection.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define CORRECTION_SSE2
+#include <emmintrin.h>
+#elif defined(__SSE2__)
+#define CORRECTION_SSE2
+#include <emmintrin.h>
+#endif
+
+static const unsigned short k_unitGain = 1 << 14;
+
+bool CorrectionHasSimd()
+{
+	// same requirement, and the same run time check, as the accumulator
+	return AccumulateHasSimd();
+}
+
+static void applyScalar(const unsigned short* src, unsigned short* dst,
+	const unsigned short* dark, const unsigned short* gain, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		unsigned int v = src[i];
+		if (dark)
+			v = (v > dark[i]) ? v - dark[i] : 0;
+		if (gain)
+		{
+			v = (v*gain[i]) >> 14;
+			if (v > 65535)
+				v = 65535;
+		}
+		dst[i] = (unsigned short) v;
+	}
+}
+
+#ifdef CORRECTION_SSE2
+
+// 8 pixels per iteration. The 32-bit product x*g is split by mulhi/mullo;
+// (x*g) >> 14 is (hi << 2) | (lo >> 14), and it overflows 16 bits exactly
+// when hi > 0x3FFF.
+static size_t applySse2(const unsigned short* src, unsigned short* dst,
+	const unsigned short* dark, const unsigned short* gain, size_t n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_cmpeq_epi16(zero, zero);
+	const __m128i maxHi = _mm_set1_epi16(0x3FFF);
+	size_t blocks = n/8;
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		size_t k = i*8;
+		__m128i x = _mm_loadu_si128((const __m128i*) (src + k));
+		if (dark)
+			x = _mm_subs_epu16(x, _mm_loadu_si128((const __m128i*) (dark + k)));
+		if (gain)
+		{
+			__m128i g = _mm_loadu_si128((const __m128i*) (gain + k));
+			__m128i hi = _mm_mulhi_epu16(x, g);
+			__m128i lo = _mm_mullo_epi16(x, g);
+			__m128i r = _mm_or_si128(_mm_slli_epi16(hi, 2), _mm_srli_epi16(lo, 14));
+			__m128i fits = _mm_cmpeq_epi16(_mm_subs_epu16(hi, maxHi), zero);
+			x = _mm_or_si128(r, _mm_andnot_si128(fits, ones));
+		}
+		_mm_storeu_si128((__m128i*) (dst + k), x);
+	}
+	return blocks*8;
+}
+
+#endif
+
+FrameCorrection::FrameCorrection() :
+	current_(0),
+	width_(0),
+	height_(0),
+	nPixels_(0),
+	darkEnabled_(false),
+	flatEnabled_(false),
+	hotEnabled_(false)
+{
+}
+
+void FrameCorrection::Select(const std::string& key, unsigned int width, unsigned int height)
+{
+	key_ = key;
+	width_ = width;
+	height_ = height;
+	nPixels_ = (size_t) width*height;
+	current_ = &references_[key];
+	if (!current_->dark.empty() && current_->dark.size() != nPixels_)
+		current_->dark.clear();
+	if (!current_->gain.empty() && current_->gain.size() != nPixels_)
+		current_->gain.clear();
+	if (current_->hot.GetWidth() != width || current_->hot.GetHeight() != height)
+		current_->hot.Clear();
+}
+
+void FrameCorrection::Apply(const unsigned short* src, unsigned short* dst) const
+{
+	const unsigned short* dark = (darkEnabled_ && HasDark()) ? &current_->dark[0] : 0;
+	const unsigned short* gain = (flatEnabled_ && HasFlat()) ? &current_->gain[0] : 0;
+	if (dark == 0 && gain == 0)
+	{
+		if (src != dst)
+			memcpy(dst, src, nPixels_*sizeof(unsigned short));
+	}
+	else
+	{
+		size_t done = 0;
+#ifdef CORRECTION_SSE2
+		if (CorrectionHasSimd())
+			done = applySse2(src, dst, dark, gain, nPixels_);
+#endif
+		applyScalar(src + done, dst + done, dark ? dark + done : 0, gain ? gain + done : 0, nPixels_ - done);
+	}
+
+	// after dark and flat, so the neighbours' values are comparable
+	if (hotEnabled_ && GetHotPixelCount() > 0)
+		current_->hot.Correct(dst);
+}
+
+void FrameCorrection::BeginReference(unsigned int frames)
+{
+	reference_.Start(nPixels_, frames, false);
+}
+
+bool FrameCorrection::AddReference(const unsigned short* frame)
+{
+	return reference_.Add(frame);
+}
+
+void FrameCorrection::GetReferenceMean(std::vector<unsigned short>& mean) const
+{
+	mean.resize(nPixels_);
+	const unsigned int* sum = reference_.GetSum();
+	unsigned int n = reference_.GetCount();
+	if (sum == 0 || n == 0)
+	{
+		mean.assign(nPixels_, 0);
+		return;
+	}
+	for (size_t i = 0; i < nPixels_; ++i)
+		mean[i] = (unsigned short) ((sum[i] + n/2)/n);
+}
+
+void FrameCorrection::SetDarkFromReference()
+{
+	if (current_ == 0)
+		return;
+	GetReferenceMean(current_->dark);
+}
+
+void FrameCorrection::SetFlatFromReference()
+{
+	if (current_ == 0 || reference_.GetCount() == 0)
+		return;
+
+	// flat signal above dark, and its mean over the frame
+	const unsigned int* sum = reference_.GetSum();
+	double n = reference_.GetCount();
+	std::vector<float> signal(nPixels_);
+	double total = 0;
+	for (size_t i = 0; i < nPixels_; ++i)
+	{
+		double s = sum[i]/n;
+		if (HasDark())
+			s -= current_->dark[i];
+		signal[i] = (float) s;
+		total += s;
+	}
+	double mean = (nPixels_ > 0) ? total/nPixels_ : 0;
+
+	// Pixels without usable signal keep unit gain
+	current_->gain.resize(nPixels_);
+	for (size_t i = 0; i < nPixels_; ++i)
+	{
+		double g = (signal[i] > 0 && mean > 0) ? mean/signal[i]*k_unitGain : k_unitGain;
+		current_->gain[i] = (unsigned short) ((g < 65535) ? g + 0.5 : 65535);
+	}
+}
+
+void FrameCorrection::DetectHotPixels(double sigma)
+{
+	if (current_ == 0 || reference_.GetCount() == 0)
+		return;
+	std::vector<unsigned short> mean;
+	GetReferenceMean(mean);
+	current_->hot.Detect(&mean[0], width_, height_, sigma);
+}
+
+void FrameCorrection::ClearDark()
+{
+	if (current_ != 0)
+		current_->dark.clear();
+}
+
+void FrameCorrection::ClearFlat()
+{
+	if (current_ != 0)
+		current_->gain.clear();
+}
+
+void FrameCorrection::ClearHotPixels()
+{
+	if (current_ != 0)
+		current_->hot.Clear();
+}
+
+// File layout: "FFC1", pixel count, dark present, gain present (all uint32),
+// then the dark and the gain as uint16 arrays, then the number of hot pixels
+// and their indices (uint32). Files without the hot-pixel part still load.
+bool FrameCorrection::Save(const std::string& path) const
+{
+	if (current_ == 0)
+		return false;
+	FILE* fp = fopen(path.c_str(), "wb");
+	if (fp == 0)
+		return false;
+
+	unsigned int header[4];
+	memcpy(&header[0], "FFC1", 4);
+	header[1] = (unsigned int) nPixels_;
+	header[2] = HasDark() ? 1 : 0;
+	header[3] = HasFlat() ? 1 : 0;
+	bool ok = fwrite(header, sizeof(header), 1, fp) == 1;
+	if (ok && HasDark())
+		ok = fwrite(&current_->dark[0], sizeof(unsigned short), nPixels_, fp) == nPixels_;
+	if (ok && HasFlat())
+		ok = fwrite(&current_->gain[0], sizeof(unsigned short), nPixels_, fp) == nPixels_;
+	unsigned int nHot = (unsigned int) GetHotPixelCount();
+	if (ok)
+		ok = fwrite(&nHot, sizeof(nHot), 1, fp) == 1;
+	if (ok && nHot > 0)
+		ok = fwrite(&current_->hot.GetPixels()[0], sizeof(unsigned int), nHot, fp) == nHot;
+	return (fclose(fp) == 0) && ok;
+}
+
+bool FrameCorrection::Load(const std::string& path)
+{
+	if (current_ == 0)
+		return false;
+	FILE* fp = fopen(path.c_str(), "rb");
+	if (fp == 0)
+		return false;
+
+	unsigned int header[4];
+	bool ok = fread(header, sizeof(header), 1, fp) == 1
+		&& memcmp(&header[0], "FFC1", 4) == 0 && header[1] == nPixels_;
+	References loaded;
+	if (ok && header[2])
+	{
+		loaded.dark.resize(nPixels_);
+		ok = fread(&loaded.dark[0], sizeof(unsigned short), nPixels_, fp) == nPixels_;
+	}
+	if (ok && header[3])
+	{
+		loaded.gain.resize(nPixels_);
+		ok = fread(&loaded.gain[0], sizeof(unsigned short), nPixels_, fp) == nPixels_;
+	}
+	unsigned int nHot = 0;
+	if (ok && fread(&nHot, sizeof(nHot), 1, fp) == 1 && nHot <= nPixels_)
+	{
+		std::vector<unsigned int> hot(nHot);
+		if (nHot > 0)
+			ok = fread(&hot[0], sizeof(unsigned int), nHot, fp) == nHot;
+		for (size_t i = 0; ok && i < hot.size(); ++i)
+			ok = hot[i] < nPixels_;
+		loaded.hot.SetPixels(hot, width_, height_);
+	}
+	else
+		loaded.hot.SetPixels(std::vector<unsigned int>(), width_, height_);
+	fclose(fp);
+
+	if (ok)
+		*current_ = loaded;
+	return ok;
+}
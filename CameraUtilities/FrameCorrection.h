@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameCorrection.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Dark-frame and flat-field correction of 16-bit frames
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+#ifndef _FRAMECORRECTION_H_
+#define _FRAMECORRECTION_H_
+
+#include "FrameAccumulator.h"
+#include "HotPixelMap.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <cstddef>
+
+//////////////////////////////////////////////////////////////////////////////
+// FrameCorrection
+// Dark-frame subtraction and flat-field gain for 16-bit frames:
+//     out = min(65535, (max(0, in - dark) * gain) >> 14)
+// with the gain a per-pixel 2.14 fixed point factor (0 to 4). One SSE2 pass
+// does both, and can double as the copy out of the driver's buffer. Hot
+// pixels found in the dark are then repaired from their neighbours.
+//
+// References belong to a readout geometry (binning, ROI, orientation),
+// identified by a key the camera makes up. References for several
+// geometries are kept, so switching binning back and forth keeps them.
+//////////////////////////////////////////////////////////////////////////////
+class FrameCorrection
+{
+public:
+	FrameCorrection();
+	~FrameCorrection() {};
+
+	// Use the references stored under key, for frames of width x height.
+	// References of a different size under the same key are dropped.
+	void Select(const std::string& key, unsigned int width, unsigned int height);
+	const std::string& GetKey() const {return key_;}
+
+	bool HasDark() const {return current_ != 0 && !current_->dark.empty();}
+	bool HasFlat() const {return current_ != 0 && !current_->gain.empty();}
+	size_t GetHotPixelCount() const {return (current_ != 0) ? current_->hot.GetCount() : 0;}
+	void EnableDark(bool enable) {darkEnabled_ = enable;}
+	void EnableFlat(bool enable) {flatEnabled_ = enable;}
+	void EnableHotPixels(bool enable) {hotEnabled_ = enable;}
+	bool IsDarkEnabled() const {return darkEnabled_;}
+	bool IsFlatEnabled() const {return flatEnabled_;}
+	bool IsHotPixelEnabled() const {return hotEnabled_;}
+
+	// True if Apply would change anything
+	bool IsActive() const {return (darkEnabled_ && HasDark()) || (flatEnabled_ && HasFlat())
+		|| (hotEnabled_ && GetHotPixelCount() > 0);}
+
+	// Correct one frame of the selected size; src and dst may be the same
+	void Apply(const unsigned short* src, unsigned short* dst) const;
+
+	// Capturing a reference: average `frames` frames. AddReference returns
+	// true once enough have been added.
+	void BeginReference(unsigned int frames);
+	bool AddReference(const unsigned short* frame);
+
+	// Turn the averaged frames into the dark, or into the flat-field gain
+	// (normalised to the mean, with the current dark taken off first)
+	void SetDarkFromReference();
+	void SetFlatFromReference();
+
+	// Build the hot-pixel map from the averaged (dark) frames
+	void DetectHotPixels(double sigma);
+
+	// The averaged reference frame, rounded (for callers analysing darks)
+	void GetReferenceMean(std::vector<unsigned short>& mean) const;
+
+	void ClearDark();
+	void ClearFlat();
+	void ClearHotPixels();
+
+	// Binary file with the selected geometry's dark, gain and hot pixels
+	bool Save(const std::string& path) const;
+	bool Load(const std::string& path);
+
+private:
+	struct References
+	{
+		std::vector<unsigned short> dark;
+		std::vector<unsigned short> gain;	// 2.14 fixed point
+		HotPixelMap hot;
+	};
+
+	std::map<std::string, References> references_;
+	std::string key_;
+	References* current_;
+	unsigned int width_;
+	unsigned int height_;
+	size_t nPixels_;
+	bool darkEnabled_;
+	bool flatEnabled_;
+	bool hotEnabled_;
+	FrameAccumulator reference_;
+};
+
+// True if FrameCorrection::Apply uses the SSE2 kernel on this machine
+bool CorrectionHasSimd();
+
+#endif //_FRAMECORRECTION_H_
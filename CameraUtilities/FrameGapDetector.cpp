@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameGapDetector.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Detection of missing frames from camera counters and timestamps
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "FrameGapDetector.h"
+#include <math.h>
+
+FrameGapDetector::FrameGapDetector()
+{
+	Reset();
+}
+
+void FrameGapDetector::Reset()
+{
+	frames_ = 0;
+	dropped_ = 0;
+	lastCounter_ = 0;
+	lastTimeUs_ = 0;
+	meanIntervalUs_ = 0;
+	nIntervals_ = 0;
+}
+
+long FrameGapDetector::AddFrameCounter(unsigned long counter, int counterBits)
+{
+	long missed = 0;
+	if (frames_ > 0)
+	{
+		unsigned long mask = (counterBits >= 32) ? 0xFFFFFFFFUL : ((1UL << counterBits) - 1);
+		unsigned long step = (counter - lastCounter_) & mask;
+		if (step > 1 && step < (mask >> 1))	//a huge step is a counter reset, not a gap
+			missed = (long) (step - 1);
+	}
+	lastCounter_ = counter;
+	++frames_;
+	dropped_ += missed;
+	return missed;
+}
+
+long FrameGapDetector::AddTimestamp(double timeUs, double expectedIntervalUs)
+{
+	long missed = 0;
+	if (frames_ > 0)
+	{
+		double intervalUs = timeUs - lastTimeUs_;
+		double expectedUs = (expectedIntervalUs > 0) ? expectedIntervalUs : meanIntervalUs_;
+		if (expectedUs > 0 && intervalUs > 1.5*expectedUs)
+			missed = (long) floor(intervalUs/expectedUs + 0.5) - 1;
+		else if (intervalUs > 0)
+		{
+			// only learn from intervals that look like consecutive frames
+			++nIntervals_;
+			meanIntervalUs_ += (intervalUs - meanIntervalUs_)/nIntervals_;
+		}
+	}
+	lastTimeUs_ = timeUs;
+	++frames_;
+	dropped_ += missed;
+	return missed;
+}
@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameGapDetector.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Detection of missing frames from camera counters and timestamps
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+#ifndef _FRAMEGAPDETECTOR_H_
+#define _FRAMEGAPDETECTOR_H_
+
+//////////////////////////////////////////////////////////////////////////////
+// FrameGapDetector
+// Counts frames missing from a sequence. Feed it either the camera's own
+// frame counter or its exposure start times, once per delivered frame.
+//////////////////////////////////////////////////////////////////////////////
+class FrameGapDetector
+{
+public:
+	FrameGapDetector();
+	~FrameGapDetector() {};
+
+	void Reset();
+
+	// Hardware frame counter, counterBits wide (wraps to 0). Returns the
+	// number of frames missed immediately before this one.
+	long AddFrameCounter(unsigned long counter, int counterBits = 32);
+
+	// Frame start time. A frame starting more than 1.5 intervals after the
+	// previous one is taken to follow missed frames. An expected interval of
+	// zero uses the running mean of the intervals seen so far.
+	long AddTimestamp(double timeUs, double expectedIntervalUs);
+
+	long GetFrames() const {return frames_;}
+	long GetDropped() const {return dropped_;}
+	double GetLastTimeUs() const {return lastTimeUs_;}
+
+private:
+	long frames_;
+	long dropped_;
+	unsigned long lastCounter_;
+	double lastTimeUs_;
+	double meanIntervalUs_;
+	long nIntervals_;
+};
+
+#endif //_FRAMEGAPDETECTOR_H_
@@ -0,0 +1,212 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FramePacer.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Absolute-deadline frame pacing for camera sequence threads
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "FramePacer.h"
+#include <math.h>
+
+#ifdef WIN32
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <time.h>
+#include <errno.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// MonotonicClock
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef WIN32
+
+double MonotonicClock::NowUs()
+{
+	static LARGE_INTEGER freq = {0};
+	if (freq.QuadPart == 0)
+		QueryPerformanceFrequency(&freq);
+
+	LARGE_INTEGER count;
+	QueryPerformanceCounter(&count);
+	return (double) count.QuadPart * 1.0e6 / (double) freq.QuadPart;
+}
+
+void MonotonicClock::SleepUntilUs(double deadlineUs)
+{
+	// Windows has no absolute monotonic sleep, so re-arm a relative waitable
+	// timer against the performance counter until the deadline is reached.
+	// The high resolution flag (Win10 1803+) gets us well under 1ms; older
+	// systems fall back to a standard timer at the scheduler tick.
+	HANDLE hTimer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (hTimer == NULL)
+		hTimer = CreateWaitableTimer(NULL, TRUE, NULL);
+	if (hTimer == NULL)
+	{
+		double remainingUs = deadlineUs - NowUs();
+		if (remainingUs > 0)
+			Sleep((DWORD) ceil(remainingUs/1000));
+		return;
+	}
+
+	double remainingUs = deadlineUs - NowUs();
+	while (remainingUs > 0)
+	{
+		LARGE_INTEGER due;
+		due.QuadPart = -(LONGLONG) ceil(remainingUs * 10);	//relative, 100ns units
+		if (!SetWaitableTimer(hTimer, &due, 0, NULL, NULL, FALSE))
+			break;
+		WaitForSingleObject(hTimer, INFINITE);
+		remainingUs = deadlineUs - NowUs();
+	}
+	CloseHandle(hTimer);
+}
+
+#else
+
+double MonotonicClock::NowUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec * 1.0e6 + (double) ts.tv_nsec / 1.0e3;
+}
+
+void MonotonicClock::SleepUntilUs(double deadlineUs)
+{
+	struct timespec ts;
+	ts.tv_sec = (time_t) (deadlineUs / 1.0e6);
+	ts.tv_nsec = (long) ((deadlineUs - (double) ts.tv_sec * 1.0e6) * 1.0e3);
+	if (ts.tv_nsec >= 1000000000L)
+	{
+		ts.tv_sec += 1;
+		ts.tv_nsec -= 1000000000L;
+	}
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// FramePacer
+///////////////////////////////////////////////////////////////////////////////
+
+FramePacer::FramePacer() :
+	intervalUs_(0),
+	startUs_(0),
+	frameIndex_(0),
+	nJitter_(0),
+	meanJitter_(0),
+	m2Jitter_(0),
+	maxJitter_(0),
+	lateFrames_(0)
+{
+}
+
+void FramePacer::Start(double intervalMs)
+{
+	intervalUs_ = (intervalMs > 0) ? intervalMs*1000 : 0;
+	startUs_ = MonotonicClock::NowUs();
+	frameIndex_ = 0;
+	nJitter_ = 0;
+	meanJitter_ = 0;
+	m2Jitter_ = 0;
+	maxJitter_ = 0;
+	lateFrames_ = 0;
+}
+
+void FramePacer::WaitForNextFrame()
+{
+	if (frameIndex_++ == 0 || intervalUs_ <= 0)
+		return;
+
+	double deadlineUs = startUs_ + (frameIndex_ - 1) * intervalUs_;
+	MonotonicClock::SleepUntilUs(deadlineUs);
+	double lateUs = MonotonicClock::NowUs() - deadlineUs;
+
+	if (lateUs > intervalUs_)
+	{
+		// Missed by more than a frame (readout slower than interval, or the
+		// thread was suspended): rebase rather than firing a burst of frames.
+		++lateFrames_;
+		startUs_ += (lateUs - fmod(lateUs, intervalUs_));
+	}
+
+	++nJitter_;
+	double delta = lateUs - meanJitter_;
+	meanJitter_ += delta/nJitter_;
+	m2Jitter_ += delta*(lateUs - meanJitter_);
+	if (lateUs > maxJitter_)
+		maxJitter_ = lateUs;
+}
+
+FramePacingStats FramePacer::GetStats() const
+{
+	FramePacingStats stats;
+	stats.frames = frameIndex_;
+	stats.lateFrames = lateFrames_;
+	stats.meanJitterUs = meanJitter_;
+	stats.stdJitterUs = (nJitter_ > 1) ? sqrt(m2Jitter_/(nJitter_ - 1)) : 0;
+	stats.maxJitterUs = maxJitter_;
+	return stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// FrameRateMeter
+///////////////////////////////////////////////////////////////////////////////
+
+FrameRateMeter::FrameRateMeter() :
+	frames_(0),
+	firstUs_(0),
+	lastUs_(0),
+	sumLatencyUs_(0),
+	maxLatencyUs_(0)
+{
+}
+
+void FrameRateMeter::Start()
+{
+	frames_ = 0;
+	firstUs_ = 0;
+	lastUs_ = 0;
+	sumLatencyUs_ = 0;
+	maxLatencyUs_ = 0;
+}
+
+void FrameRateMeter::AddFrame(double readyUs)
+{
+	double now = MonotonicClock::NowUs();
+	if (frames_++ == 0)
+		firstUs_ = now;
+	lastUs_ = now;
+
+	double latencyUs = (readyUs > 0 && readyUs <= now) ? now - readyUs : 0;
+	sumLatencyUs_ += latencyUs;
+	if (latencyUs > maxLatencyUs_)
+		maxLatencyUs_ = latencyUs;
+}
+
+FrameRateStats FrameRateMeter::GetStats() const
+{
+	FrameRateStats stats;
+	stats.frames = frames_;
+	stats.fps = (frames_ > 1 && lastUs_ > firstUs_) ? (frames_ - 1)*1.0e6/(lastUs_ - firstUs_) : 0;
+	stats.meanLatencyUs = (frames_ > 0) ? sumLatencyUs_/frames_ : 0;
+	stats.maxLatencyUs = maxLatencyUs_;
+	return stats;
+}
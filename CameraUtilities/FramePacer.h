@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FramePacer.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Absolute-deadline frame pacing for camera sequence threads
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+#ifndef _FRAMEPACER_H_
+#define _FRAMEPACER_H_
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// MonotonicClock
+// Thin wrapper around QueryPerformanceCounter / CLOCK_MONOTONIC so that
+// deadlines are unaffected by wall clock adjustments.
+//////////////////////////////////////////////////////////////////////////////
+class MonotonicClock
+{
+public:
+	// Current time in microseconds from an arbitrary (fixed) origin
+	static double NowUs();
+
+	// Block the calling thread until NowUs() >= deadlineUs. Sleeps rather
+	// than spins; returns immediately if the deadline has already passed.
+	static void SleepUntilUs(double deadlineUs);
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// FramePacingStats
+// Snapshot of the lateness of frame starts relative to their deadlines
+//////////////////////////////////////////////////////////////////////////////
+struct FramePacingStats
+{
+	long frames;			// frames paced since Start()
+	long lateFrames;		// frames started more than one interval late
+	double meanJitterUs;
+	double stdJitterUs;
+	double maxJitterUs;
+
+	FramePacingStats() : frames(0), lateFrames(0), meanJitterUs(0), stdJitterUs(0), maxJitterUs(0) {}
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// FramePacer
+// Frame n of a sequence is due at start + n*interval. Deadlines are absolute,
+// so a late frame does not push back every frame after it; if we fall more
+// than a whole interval behind the schedule is rebased rather than bursting
+// to catch up. An interval of zero means "as fast as the camera allows".
+//////////////////////////////////////////////////////////////////////////////
+class FramePacer
+{
+public:
+	FramePacer();
+	~FramePacer() {};
+
+	void Start(double intervalMs);
+
+	// Wait for the next frame's deadline and record how late we woke.
+	// The first call after Start() returns immediately.
+	void WaitForNextFrame();
+
+	double GetIntervalMs() const {return intervalUs_/1000;}
+	FramePacingStats GetStats() const;
+
+private:
+	double intervalUs_;
+	double startUs_;
+	long frameIndex_;
+
+	// Welford running mean/variance of lateness
+	long nJitter_;
+	double meanJitter_;
+	double m2Jitter_;
+	double maxJitter_;
+	long lateFrames_;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// FrameRateStats
+// Delivered frame rate and the latency of the adapter's own processing
+//////////////////////////////////////////////////////////////////////////////
+struct FrameRateStats
+{
+	long frames;			// frames delivered since Start()
+	double fps;				// over the span from the first to the last frame
+	double meanLatencyUs;	// from the frame being ready at the camera to delivery
+	double maxLatencyUs;
+
+	FrameRateStats() : frames(0), fps(0), meanLatencyUs(0), maxLatencyUs(0) {}
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// FrameRateMeter
+// Measures what comes out of the end of the acquisition path: the rate at
+// which frames are delivered, and how long each spent between the camera
+// having it ready and its delivery (orientation, correction, metadata and
+// insertion).
+//////////////////////////////////////////////////////////////////////////////
+class FrameRateMeter
+{
+public:
+	FrameRateMeter();
+	~FrameRateMeter() {};
+
+	void Start();
+
+	// Record a frame delivered now, which was ready at readyUs (NowUs() time)
+	void AddFrame(double readyUs);
+
+	FrameRateStats GetStats() const;
+
+private:
+	long frames_;
+	double firstUs_;
+	double lastUs_;
+	double sumLatencyUs_;
+	double maxLatencyUs_;
+};
+
+#endif //_FRAMEPACER_H_
@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameQueue.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Lock-free single producer/single consumer queue of camera frames
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "FrameQueue.h"
+
+#ifdef WIN32
+#include <windows.h>
+#define FRAMEQUEUE_BARRIER() MemoryBarrier()
+#else
+#define FRAMEQUEUE_BARRIER() __sync_synchronize()
+#endif
+
+FrameQueue::FrameQueue() :
+	head_(0),
+	tail_(0),
+	highWater_(0)
+{
+}
+
+void FrameQueue::Allocate(unsigned int capacity, unsigned long frameBytes)
+{
+	if (capacity < 1)
+		capacity = 1;
+	slots_.resize(capacity);
+	for (unsigned int i = 0; i < capacity; ++i)
+	{
+		if (slots_[i].pixels.size() < frameBytes)
+			slots_[i].pixels.resize(frameBytes);
+	}
+	Reset();
+}
+
+void FrameQueue::Reset()
+{
+	head_ = 0;
+	tail_ = 0;
+	highWater_ = 0;
+}
+
+QueuedFrame* FrameQueue::BeginPush()
+{
+	if (slots_.empty() || head_ - tail_ >= slots_.size())
+		return 0;
+	return &slots_[head_ % slots_.size()];
+}
+
+void FrameQueue::Push()
+{
+	// slot contents must be visible before the consumer can see the new head
+	FRAMEQUEUE_BARRIER();
+	head_ = head_ + 1;
+
+	unsigned int size = (unsigned int) (head_ - tail_);
+	if (size > highWater_)
+		highWater_ = size;
+}
+
+QueuedFrame* FrameQueue::Front()
+{
+	if (head_ == tail_)
+		return 0;
+	// don't read the slot before we have seen the head that published it
+	FRAMEQUEUE_BARRIER();
+	return &slots_[tail_ % slots_.size()];
+}
+
+void FrameQueue::Pop()
+{
+	// finish reading the slot before handing it back to the producer
+	FRAMEQUEUE_BARRIER();
+	tail_ = tail_ + 1;
+}
+
+unsigned int FrameQueue::Size() const
+{
+	return (unsigned int) (head_ - tail_);
+}
@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameQueue.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Lock-free single producer/single consumer queue of camera frames
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+#ifndef _FRAMEQUEUE_H_
+#define _FRAMEQUEUE_H_
+
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// QueuedFrame
+// One slot of a FrameQueue. Pixel storage is allocated once and reused; the
+// remaining fields describe the frame currently held in the slot.
+//////////////////////////////////////////////////////////////////////////////
+struct QueuedFrame
+{
+	std::vector<unsigned char> pixels;
+	unsigned long bytes;		// valid bytes in pixels
+	unsigned int width;
+	unsigned int height;
+	unsigned int stride;		// bytes per row
+	int pixelFormat;			// camera specific
+	double timestampUs;			// host time (MonotonicClock) when the frame arrived
+	unsigned long frameNumber;	// producer's count, including frames it dropped
+	unsigned long deviceFrameNumber;	// camera's own frame counter, if it has one
+	unsigned long deviceTimestamp;		// camera's own timestamp (camera specific units)
+	unsigned long deviceShutter;		// shutter setting the frame was exposed with, if known
+
+	QueuedFrame() : bytes(0), width(0), height(0), stride(0), pixelFormat(0), timestampUs(0), frameNumber(0),
+		deviceFrameNumber(0), deviceTimestamp(0), deviceShutter(0) {}
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// FrameQueue
+// Fixed capacity ring of preallocated frames, shared by exactly one producer
+// thread (e.g. a driver retrieval thread) and one consumer thread (the
+// sequence thread). Neither side takes a lock: each owns one index and only
+// publishes it after the slot contents are complete. Allocate() and Reset()
+// must only be called while neither thread is running.
+//////////////////////////////////////////////////////////////////////////////
+class FrameQueue
+{
+public:
+	FrameQueue();
+	~FrameQueue() {};
+
+	void Allocate(unsigned int capacity, unsigned long frameBytes);
+	void Reset();
+
+	// Producer: get a free slot (NULL if the queue is full), fill it, then
+	// publish it with Push().
+	QueuedFrame* BeginPush();
+	void Push();
+
+	// Consumer: oldest frame (NULL if the queue is empty); release it with
+	// Pop() once the data has been copied out.
+	QueuedFrame* Front();
+	void Pop();
+
+	unsigned int Size() const;
+	unsigned int Capacity() const {return (unsigned int) slots_.size();}
+	unsigned int HighWater() const {return highWater_;}
+
+private:
+	std::vector<QueuedFrame> slots_;
+	volatile unsigned long head_;	// frames pushed, written by the producer only
+	volatile unsigned long tail_;	// frames popped, written by the consumer only
+	volatile unsigned int highWater_;
+};
+
+#endif //_FRAMEQUEUE_H_
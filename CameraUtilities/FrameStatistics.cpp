@@ -0,0 +1,242 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameStatistics.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Single-pass per-frame statistics, fused with the frame copy
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "FrameStatistics.h"
+#include "FrameAccumulator.h"
+#include <math.h>
+#include <string.h>
+#include <sstream>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define STATISTICS_SSE2
+#include <emmintrin.h>
+#elif defined(__SSE2__)
+#define STATISTICS_SSE2
+#include <emmintrin.h>
+#endif
+
+// Pixels per block: small enough that the 16 and 32-bit SIMD lane counters
+// cannot overflow, and that the block is still in cache for the histogram
+static const size_t k_blockPixels = 32768;
+
+bool StatisticsHasSimd()
+{
+	// same requirement, and the same run time check, as the accumulator
+	return AccumulateHasSimd();
+}
+
+FrameStatistics::FrameStatistics() :
+	bitDepth_(16),
+	histogramEnabled_(false),
+	nPixels_(0),
+	min_(0),
+	max_(0),
+	sum_(0),
+	sumSq_(0),
+	saturated_(0)
+{
+}
+
+void FrameStatistics::SetBitDepth(int bits)
+{
+	bitDepth_ = (bits < 8) ? 8 : ((bits > 16) ? 16 : bits);
+}
+
+void FrameStatistics::begin(size_t n)
+{
+	nPixels_ = n;
+	min_ = 0xFFFFFFFF;
+	max_ = 0;
+	sum_ = 0;
+	sumSq_ = 0;
+	saturated_ = 0;
+	if (histogramEnabled_)
+		histogram_.assign(256, 0);
+	else
+		histogram_.clear();
+}
+
+#ifdef STATISTICS_SSE2
+
+// Statistics of one block of at most k_blockPixels, 8 pixels at a time.
+// Unsigned 16-bit min/max/compare are done as signed after flipping the top
+// bit. Sums go to 32-bit lanes, squares (32-bit from mullo/mulhi) to 64-bit.
+static size_t statsU16Sse2(const unsigned short* src, unsigned short* dst, size_t n,
+	unsigned short saturation, unsigned int& min, unsigned int& max,
+	unsigned long long& sum, unsigned long long& sumSq, size_t& saturated)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16((short) 0x8000);
+	const __m128i satLimit = _mm_set1_epi16((short) ((saturation - 1) ^ 0x8000));
+	__m128i vMin = _mm_set1_epi16(0x7FFF);
+	__m128i vMax = bias;
+	__m128i vSat = zero;
+	__m128i vSum = zero;
+	__m128i vSumSq = zero;
+
+	size_t blocks = n/8;
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*) (src + i*8));
+		if (dst)
+			_mm_storeu_si128((__m128i*) (dst + i*8), x);
+
+		__m128i xb = _mm_xor_si128(x, bias);
+		vMin = _mm_min_epi16(vMin, xb);
+		vMax = _mm_max_epi16(vMax, xb);
+		vSat = _mm_sub_epi16(vSat, _mm_cmpgt_epi16(xb, satLimit));
+
+		vSum = _mm_add_epi32(vSum, _mm_unpacklo_epi16(x, zero));
+		vSum = _mm_add_epi32(vSum, _mm_unpackhi_epi16(x, zero));
+
+		__m128i lo = _mm_mullo_epi16(x, x);
+		__m128i hi = _mm_mulhi_epu16(x, x);
+		__m128i sq0 = _mm_unpacklo_epi16(lo, hi);
+		__m128i sq1 = _mm_unpackhi_epi16(lo, hi);
+		vSumSq = _mm_add_epi64(vSumSq, _mm_unpacklo_epi32(sq0, zero));
+		vSumSq = _mm_add_epi64(vSumSq, _mm_unpackhi_epi32(sq0, zero));
+		vSumSq = _mm_add_epi64(vSumSq, _mm_unpacklo_epi32(sq1, zero));
+		vSumSq = _mm_add_epi64(vSumSq, _mm_unpackhi_epi32(sq1, zero));
+	}
+
+	unsigned short mins[8], maxs[8], sats[8];
+	unsigned int sums[4];
+	unsigned long long sumSqs[2];
+	_mm_storeu_si128((__m128i*) mins, _mm_xor_si128(vMin, bias));
+	_mm_storeu_si128((__m128i*) maxs, _mm_xor_si128(vMax, bias));
+	_mm_storeu_si128((__m128i*) sats, vSat);
+	_mm_storeu_si128((__m128i*) sums, vSum);
+	_mm_storeu_si128((__m128i*) sumSqs, vSumSq);
+	if (blocks > 0)
+	{
+		for (int k = 0; k < 8; ++k)
+		{
+			if (mins[k] < min)
+				min = mins[k];
+			if (maxs[k] > max)
+				max = maxs[k];
+			saturated += sats[k];
+		}
+	}
+	for (int k = 0; k < 4; ++k)
+		sum += sums[k];
+	sumSq += sumSqs[0] + sumSqs[1];
+	return blocks*8;
+}
+
+#endif
+
+void FrameStatistics::Process(const unsigned short* src, unsigned short* dst, size_t n)
+{
+	begin(n);
+	unsigned short saturation = (unsigned short) ((1 << bitDepth_) - 1);
+	int shift = bitDepth_ - 8;
+#ifdef STATISTICS_SSE2
+	bool simd = StatisticsHasSimd();
+#endif
+
+	for (size_t start = 0; start < n; start += k_blockPixels)
+	{
+		size_t count = (n - start < k_blockPixels) ? n - start : k_blockPixels;
+		const unsigned short* s = src + start;
+		unsigned short* d = dst ? dst + start : 0;
+
+		size_t done = 0;
+#ifdef STATISTICS_SSE2
+		if (simd)
+			done = statsU16Sse2(s, d, count, saturation, min_, max_, sum_, sumSq_, saturated_);
+#endif
+		for (size_t i = done; i < count; ++i)
+		{
+			unsigned int v = s[i];
+			if (d)
+				d[i] = (unsigned short) v;
+			if (v < min_)
+				min_ = v;
+			if (v > max_)
+				max_ = v;
+			if (v >= saturation)
+				++saturated_;
+			sum_ += v;
+			sumSq_ += (unsigned long long) (v*v);
+		}
+
+		if (histogramEnabled_)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				unsigned int bin = s[i] >> shift;
+				++histogram_[(bin > 255) ? 255 : bin];
+			}
+		}
+	}
+	if (n == 0)
+		min_ = 0;
+}
+
+void FrameStatistics::Process(const unsigned char* src, unsigned char* dst, size_t n)
+{
+	begin(n);
+	if (dst)
+		memcpy(dst, src, n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		unsigned int v = src[i];
+		if (v < min_)
+			min_ = v;
+		if (v > max_)
+			max_ = v;
+		if (v == 255)
+			++saturated_;
+		sum_ += v;
+		sumSq_ += v*v;
+		if (histogramEnabled_)
+			++histogram_[v];
+	}
+	if (n == 0)
+		min_ = 0;
+}
+
+double FrameStatistics::GetMean() const
+{
+	return (nPixels_ > 0) ? (double) sum_/nPixels_ : 0;
+}
+
+double FrameStatistics::GetStdDev() const
+{
+	if (nPixels_ < 2)
+		return 0;
+	double mean = GetMean();
+	double var = ((double) sumSq_ - mean*(double) sum_)/(nPixels_ - 1);
+	return (var > 0) ? sqrt(var) : 0;
+}
+
+std::string FrameStatistics::HistogramToString() const
+{
+	std::ostringstream os;
+	for (size_t i = 0; i < histogram_.size(); ++i)
+	{
+		if (i > 0)
+			os << ",";
+		os << histogram_[i];
+	}
+	return os.str();
+}
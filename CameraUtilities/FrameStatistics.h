@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameStatistics.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Single-pass per-frame statistics, fused with the frame copy
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+#ifndef _FRAMESTATISTICS_H_
+#define _FRAMESTATISTICS_H_
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+//////////////////////////////////////////////////////////////////////////////
+// FrameStatistics
+// Minimum, maximum, sum, sum of squares, saturated pixel count and
+// (optionally) a 256-bin histogram of a frame, from one pass that can also
+// copy the frame to its destination. 16-bit frames use SSE2; the histogram
+// is filled from each block while it is still in cache.
+//
+// Saturation is judged, and the histogram binned, against the camera's bit
+// depth: a 12-bit frame saturates at 4095 and its bins are 16 levels wide.
+//////////////////////////////////////////////////////////////////////////////
+class FrameStatistics
+{
+public:
+	FrameStatistics();
+	~FrameStatistics() {};
+
+	void SetBitDepth(int bits);
+	void EnableHistogram(bool enable) {histogramEnabled_ = enable;}
+	bool IsHistogramEnabled() const {return histogramEnabled_;}
+
+	// Scan n pixels, copying them to dst unless dst is null
+	void Process(const unsigned short* src, unsigned short* dst, size_t n);
+	void Process(const unsigned char* src, unsigned char* dst, size_t n);
+
+	size_t GetPixelCount() const {return nPixels_;}
+	unsigned int GetMin() const {return min_;}
+	unsigned int GetMax() const {return max_;}
+	double GetSum() const {return (double) sum_;}
+	double GetSumSq() const {return (double) sumSq_;}
+	double GetMean() const;
+	double GetStdDev() const;
+	size_t GetSaturated() const {return saturated_;}
+
+	// Empty unless the histogram is enabled
+	const std::vector<unsigned int>& GetHistogram() const {return histogram_;}
+
+	// Histogram as comma separated counts, for image metadata
+	std::string HistogramToString() const;
+
+private:
+	void begin(size_t n);
+
+	int bitDepth_;
+	bool histogramEnabled_;
+	size_t nPixels_;
+	unsigned int min_;
+	unsigned int max_;
+	unsigned long long sum_;
+	unsigned long long sumSq_;
+	size_t saturated_;
+	std::vector<unsigned int> histogram_;
+};
+
+// True if FrameStatistics uses the SSE2 kernel on this machine
+bool StatisticsHasSimd();
+
+#endif //_FRAMESTATISTICS_H_
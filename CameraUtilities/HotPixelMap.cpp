@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          HotPixelMap.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Sparse hot-pixel detection from dark frames and median repair
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "HotPixelMap.h"
+#include <math.h>
+#include <algorithm>
+
+HotPixelMap::HotPixelMap() :
+	width_(0),
+	height_(0)
+{
+}
+
+void HotPixelMap::Detect(const unsigned short* dark, unsigned int width, unsigned int height, double sigma)
+{
+	width_ = width;
+	height_ = height;
+	pixels_.clear();
+	size_t n = (size_t) width*height;
+	if (n == 0)
+		return;
+
+	// mean and standard deviation, then again within the first threshold
+	double limit = 65536;
+	double mean = 0, sd = 0;
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		double sum = 0, sumSq = 0;
+		size_t count = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			double v = dark[i];
+			if (v <= limit)
+			{
+				sum += v;
+				sumSq += v*v;
+				++count;
+			}
+		}
+		if (count == 0)
+			break;
+		mean = sum/count;
+		sd = sqrt(std::max(0.0, sumSq/count - mean*mean));
+		limit = mean + sigma*sd;
+	}
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (dark[i] > limit)
+			pixels_.push_back((unsigned int) i);
+	}
+}
+
+void HotPixelMap::SetPixels(const std::vector<unsigned int>& pixels, unsigned int width, unsigned int height)
+{
+	width_ = width;
+	height_ = height;
+	pixels_ = pixels;
+	std::sort(pixels_.begin(), pixels_.end());
+}
+
+bool HotPixelMap::isHot(unsigned int index) const
+{
+	return std::binary_search(pixels_.begin(), pixels_.end(), index);
+}
+
+void HotPixelMap::Correct(unsigned short* frame) const
+{
+	for (size_t k = 0; k < pixels_.size(); ++k)
+	{
+		unsigned int index = pixels_[k];
+		unsigned int x = index % width_;
+		unsigned int y = index / width_;
+
+		// good pixels of the 3x3 neighbourhood
+		unsigned short v[8];
+		int count = 0;
+		for (int dy = -1; dy <= 1; ++dy)
+		{
+			if ((dy < 0 && y == 0) || (dy > 0 && y + 1 >= height_))
+				continue;
+			for (int dx = -1; dx <= 1; ++dx)
+			{
+				if ((dx == 0 && dy == 0) || (dx < 0 && x == 0) || (dx > 0 && x + 1 >= width_))
+					continue;
+				unsigned int j = index + dy*(int) width_ + dx;
+				if (!isHot(j))
+					v[count++] = frame[j];
+			}
+		}
+		if (count == 0)
+			continue;	// a cluster of defects, nothing to go on
+
+		// insertion sort, at most 8 values
+		for (int i = 1; i < count; ++i)
+		{
+			unsigned short t = v[i];
+			int j = i;
+			for (; j > 0 && v[j - 1] > t; --j)
+				v[j] = v[j - 1];
+			v[j] = t;
+		}
+		frame[index] = (count & 1) ? v[count/2] : (unsigned short) ((v[count/2 - 1] + v[count/2] + 1)/2);
+	}
+}
@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          HotPixelMap.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Sparse hot-pixel detection from dark frames and median repair
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+#ifndef _HOTPIXELMAP_H_
+#define _HOTPIXELMAP_H_
+
+#include <vector>
+#include <cstddef>
+
+//////////////////////////////////////////////////////////////////////////////
+// HotPixelMap
+// List of defective pixels found in a dark frame: those more than `sigma`
+// standard deviations above the mean dark level (the statistics are taken
+// once more without the outliers, so a few very hot pixels do not hide the
+// rest). Each listed pixel is replaced by the median of its good
+// neighbours, so the cost of a frame is proportional to the number of
+// defects, not to its size.
+//////////////////////////////////////////////////////////////////////////////
+class HotPixelMap
+{
+public:
+	HotPixelMap();
+	~HotPixelMap() {};
+
+	void Detect(const unsigned short* dark, unsigned int width, unsigned int height, double sigma);
+
+	// Replace the listed pixels of a frame of the detected size
+	void Correct(unsigned short* frame) const;
+
+	void Clear() {pixels_.clear();}
+	size_t GetCount() const {return pixels_.size();}
+	unsigned int GetWidth() const {return width_;}
+	unsigned int GetHeight() const {return height_;}
+
+	// Sorted pixel indices (y*width + x), for saving and restoring the map
+	const std::vector<unsigned int>& GetPixels() const {return pixels_;}
+	void SetPixels(const std::vector<unsigned int>& pixels, unsigned int width, unsigned int height);
+
+private:
+	bool isHot(unsigned int index) const;
+
+	std::vector<unsigned int> pixels_;
+	unsigned int width_;
+	unsigned int height_;
+};
+
+#endif //_HOTPIXELMAP_H_
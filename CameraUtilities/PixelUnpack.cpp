@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          PixelUnpack.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Unpacking of packed 12-bit camera pixels to 16 bits
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "PixelUnpack.h"
+#include "FramePacer.h"
+#include <vector>
+
+// The vector kernel needs SSSE3 (pshufb). MSVC always compiles it and
+// checks the CPU at run time. gcc/clang compile it for SSSE3 through the
+// target attribute, so no per-file flag is needed, and check the CPU at run
+// time unless the whole build already assumes SSSE3.
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define UNPACK12_SSSE3
+#define UNPACK12_RUNTIME_CHECK
+#define UNPACK12_TARGET
+#include <intrin.h>
+#include <tmmintrin.h>
+#elif defined(__SSSE3__)
+#define UNPACK12_SSSE3
+#define UNPACK12_TARGET
+#include <tmmintrin.h>
+#elif (defined(__i386__) || defined(__x86_64__)) \
+	&& (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define UNPACK12_SSSE3
+#define UNPACK12_BUILTIN_CHECK
+#define UNPACK12_TARGET __attribute__((target("ssse3")))
+#include <tmmintrin.h>
+#endif
+
+void Unpack12To16Scalar(const unsigned char* src, unsigned short* dst, size_t nPixels)
+{
+	size_t pairs = nPixels/2;
+	for (size_t i = 0; i < pairs; ++i, src += 3, dst += 2)
+	{
+		dst[0] = (unsigned short) ((src[0] << 4) | (src[1] & 0x0F));
+		dst[1] = (unsigned short) ((src[2] << 4) | (src[1] >> 4));
+	}
+	if (nPixels & 1)
+		dst[0] = (unsigned short) ((src[0] << 4) | (src[1] & 0x0F));
+}
+
+#ifdef UNPACK12_SSSE3
+
+// 8 pixels (12 bytes) per iteration. Each pixel's two source bytes are
+// shuffled into a 16-bit lane as (lo = byte 1, hi = byte 0 or 2) so that
+//     odd pixels  = lane >> 4
+//     even pixels = ((lane >> 4) & 0x0FF0) | (lane & 0x000F)
+UNPACK12_TARGET static void Unpack12To16Ssse3(const unsigned char* src, unsigned short* dst, size_t nPixels)
+{
+	const __m128i shuffle = _mm_setr_epi8(1,0,1,2, 4,3,4,5, 7,6,7,8, 10,9,10,11);
+	const __m128i maskHigh = _mm_setr_epi16(0x0FF0,0x0FFF, 0x0FF0,0x0FFF, 0x0FF0,0x0FFF, 0x0FF0,0x0FFF);
+	const __m128i maskLow = _mm_setr_epi16(0x000F,0, 0x000F,0, 0x000F,0, 0x000F,0);
+
+	// each 16 byte load only uses 12, so the last load must still end
+	// inside the source
+	size_t bytes = (nPixels*3)/2;
+	size_t blocks = (bytes >= 16) ? (bytes - 16)/12 + 1 : 0;
+	for (size_t i = 0; i < blocks; ++i, src += 12, dst += 8)
+	{
+		__m128i in = _mm_loadu_si128((const __m128i*) src);
+		__m128i w = _mm_shuffle_epi8(in, shuffle);
+		__m128i s = _mm_srli_epi16(w, 4);
+		__m128i out = _mm_or_si128(_mm_and_si128(s, maskHigh), _mm_and_si128(w, maskLow));
+		_mm_storeu_si128((__m128i*) dst, out);
+	}
+	Unpack12To16Scalar(src, dst, nPixels - blocks*8);
+}
+
+#endif
+
+bool Unpack12HasSimd()
+{
+#if defined(UNPACK12_RUNTIME_CHECK)
+	static int hasSsse3 = -1;
+	if (hasSsse3 < 0)
+	{
+		int info[4];
+		__cpuid(info, 1);
+		hasSsse3 = (info[2] & (1 << 9)) ? 1 : 0;
+	}
+	return hasSsse3 != 0;
+#elif defined(UNPACK12_BUILTIN_CHECK)
+	static int hasSsse3 = -1;
+	if (hasSsse3 < 0)
+	{
+		__builtin_cpu_init();
+		hasSsse3 = __builtin_cpu_supports("ssse3") ? 1 : 0;
+	}
+	return hasSsse3 != 0;
+#elif defined(UNPACK12_SSSE3)
+	return true;
+#else
+	return false;
+#endif
+}
+
+void Unpack12To16(const unsigned char* src, unsigned short* dst, size_t nPixels)
+{
+#ifdef UNPACK12_SSSE3
+	if (Unpack12HasSimd())
+	{
+		Unpack12To16Ssse3(src, dst, nPixels);
+		return;
+	}
+#endif
+	Unpack12To16Scalar(src, dst, nPixels);
+}
+
+void BenchmarkUnpack12(size_t nPixels, int repeats, double& scalarMpixPerS, double& simdMpixPerS)
+{
+	std::vector<unsigned char> packed((nPixels*3 + 1)/2);
+	std::vector<unsigned short> unpacked(nPixels);
+	for (size_t i = 0; i < packed.size(); ++i)
+		packed[i] = (unsigned char) (i*131 + 7);
+	if (repeats < 1)
+		repeats = 1;
+
+	double t0 = MonotonicClock::NowUs();
+	for (int r = 0; r < repeats; ++r)
+		Unpack12To16Scalar(&packed[0], &unpacked[0], nPixels);
+	double t1 = MonotonicClock::NowUs();
+	for (int r = 0; r < repeats; ++r)
+		Unpack12To16(&packed[0], &unpacked[0], nPixels);
+	double t2 = MonotonicClock::NowUs();
+
+	scalarMpixPerS = (t1 > t0) ? (double) nPixels*repeats/(t1 - t0) : 0;
+	simdMpixPerS = (t2 > t1) ? (double) nPixels*repeats/(t2 - t1) : 0;
+}
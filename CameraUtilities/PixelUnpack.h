@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          PixelUnpack.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Unpacking of packed 12-bit camera pixels to 16 bits
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+#ifndef _PIXELUNPACK_H_
+#define _PIXELUNPACK_H_
+
+#include <cstddef>
+
+//////////////////////////////////////////////////////////////////////////////
+// Packed 12-bit (IIDC Y12 / FlyCapture2 MONO12): every two pixels share
+// three bytes,
+//     byte 0: pixel 0 bits 11-4
+//     byte 1: pixel 1 bits 3-0 (high nibble), pixel 0 bits 3-0 (low nibble)
+//     byte 2: pixel 1 bits 11-4
+// Output pixels are right aligned, i.e. 0..4095.
+//////////////////////////////////////////////////////////////////////////////
+
+// Unpack nPixels pixels using the fastest kernel the CPU supports
+void Unpack12To16(const unsigned char* src, unsigned short* dst, size_t nPixels);
+
+// Plain C kernel, also used for the tail the vector kernel can't reach
+void Unpack12To16Scalar(const unsigned char* src, unsigned short* dst, size_t nPixels);
+
+// True if Unpack12To16 uses the SSSE3 kernel on this machine
+bool Unpack12HasSimd();
+
+// Throughput of the scalar and dispatched kernels, in megapixels per second,
+// measured on a synthetic frame of nPixels pixels
+void BenchmarkUnpack12(size_t nPixels, int repeats, double& scalarMpixPerS, double& simdMpixPerS);
+
+#endif //_PIXELUNPACK_H_
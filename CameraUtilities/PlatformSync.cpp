@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          PlatformSync.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Events, atomics and thread priority for Windows and POSIX
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#include "PlatformSync.h"
+
+#ifndef WIN32
+#include <time.h>
+#include <errno.h>
+#include <sched.h>
+#endif
+
+#ifdef WIN32
+
+AutoResetEvent::AutoResetEvent()
+{
+	event_ = CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+AutoResetEvent::~AutoResetEvent()
+{
+	CloseHandle(event_);
+}
+
+void AutoResetEvent::Set()
+{
+	SetEvent(event_);
+}
+
+bool AutoResetEvent::Wait(long timeoutMs)
+{
+	return WaitForSingleObject(event_, (DWORD) timeoutMs) == WAIT_OBJECT_0;
+}
+
+long AtomicExchange(volatile long* target, long value)
+{
+	return InterlockedExchange(target, value);
+}
+
+void LowerCurrentThreadPriority()
+{
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+}
+
+#else
+
+AutoResetEvent::AutoResetEvent() :
+	set_(false)
+{
+	pthread_mutex_init(&lock_, 0);
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&cond_, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+AutoResetEvent::~AutoResetEvent()
+{
+	pthread_cond_destroy(&cond_);
+	pthread_mutex_destroy(&lock_);
+}
+
+void AutoResetEvent::Set()
+{
+	pthread_mutex_lock(&lock_);
+	set_ = true;
+	pthread_cond_signal(&cond_);
+	pthread_mutex_unlock(&lock_);
+}
+
+bool AutoResetEvent::Wait(long timeoutMs)
+{
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += timeoutMs/1000;
+	deadline.tv_nsec += (timeoutMs%1000)*1000000L;
+	if (deadline.tv_nsec >= 1000000000L)
+	{
+		deadline.tv_sec += 1;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&lock_);
+	while (!set_)
+	{
+		if (pthread_cond_timedwait(&cond_, &lock_, &deadline) == ETIMEDOUT)
+			break;
+	}
+	bool wasSet = set_;
+	set_ = false;
+	pthread_mutex_unlock(&lock_);
+	return wasSet;
+}
+
+long AtomicExchange(volatile long* target, long value)
+{
+	// __sync_lock_test_and_set is only an acquire barrier
+	__sync_synchronize();
+	return __sync_lock_test_and_set(target, value);
+}
+
+void LowerCurrentThreadPriority()
+{
+	// Unprivileged threads can't be given a lower static priority; on Linux
+	// SCHED_BATCH is the nearest thing, a time-sharing thread that the
+	// scheduler treats as CPU bound and does not let preempt others.
+#ifdef SCHED_BATCH
+	struct sched_param param;
+	param.sched_priority = 0;
+	pthread_setschedparam(pthread_self(), SCHED_BATCH, &param);
+#endif
+}
+
+#endif
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          PlatformSync.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Events, atomics and thread priority for Windows and POSIX
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#pragma once
+#ifndef _PLATFORMSYNC_H_
+#define _PLATFORMSYNC_H_
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// AutoResetEvent
+// A Win32 auto-reset event, or its equivalent made from a pthread mutex and
+// condition: Set() releases one Wait(), or the next one if nobody is waiting.
+//////////////////////////////////////////////////////////////////////////////
+class AutoResetEvent
+{
+public:
+	AutoResetEvent();
+	~AutoResetEvent();
+
+	void Set();
+
+	// Returns true if the event was set, false on timeout
+	bool Wait(long timeoutMs);
+
+private:
+	AutoResetEvent(const AutoResetEvent&);
+	AutoResetEvent& operator=(const AutoResetEvent&);
+
+#ifdef WIN32
+	HANDLE event_;
+#else
+	pthread_mutex_t lock_;
+	pthread_cond_t cond_;
+	bool set_;
+#endif
+};
+
+// Store value with a full memory barrier and return the previous value
+long AtomicExchange(volatile long* target, long value);
+
+// Drop the calling thread below normal priority, for housekeeping threads
+// which must not compete with the sequence thread
+void LowerCurrentThreadPriority();
+
+#endif //_PLATFORMSYNC_H_
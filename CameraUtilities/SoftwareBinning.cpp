@@ -0,0 +1,174 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SoftwareBinning.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Host-side NxM pixel binning of 16-bit frames
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "SoftwareBinning.h"
+#include "FrameAccumulator.h"
+#include <string.h>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define BINNING_SSE2
+#include <emmintrin.h>
+#elif defined(__SSE2__)
+#define BINNING_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef BINNING_SSE2
+
+// Widen 8 16-bit pixels to 32 bits and add them to the row sum
+static size_t addRowSse2(unsigned int* sum, const unsigned short* row, size_t n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t blocks = n/8;
+	for (size_t i = 0; i < blocks; ++i, row += 8, sum += 8)
+	{
+		__m128i in = _mm_loadu_si128((const __m128i*) row);
+		__m128i lo = _mm_loadu_si128((const __m128i*) sum);
+		__m128i hi = _mm_loadu_si128((const __m128i*) (sum + 4));
+		_mm_storeu_si128((__m128i*) sum, _mm_add_epi32(lo, _mm_unpacklo_epi16(in, zero)));
+		_mm_storeu_si128((__m128i*) (sum + 4), _mm_add_epi32(hi, _mm_unpackhi_epi16(in, zero)));
+	}
+	return blocks*8;
+}
+
+// Add adjacent pairs: 8 sums in, 4 out. The even and odd lanes of two
+// registers are gathered with a float shuffle (a bit move, no conversion).
+static size_t addPairsSse2(unsigned int* out, const unsigned int* in, size_t nOut)
+{
+	size_t blocks = nOut/4;
+	for (size_t i = 0; i < blocks; ++i, in += 8, out += 4)
+	{
+		__m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*) in));
+		__m128 b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*) (in + 4)));
+		__m128i even = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128i odd = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		_mm_storeu_si128((__m128i*) out, _mm_add_epi32(even, odd));
+	}
+	return blocks*4;
+}
+
+#endif
+
+SoftwareBinning::SoftwareBinning() :
+	width_(0),
+	height_(0),
+	binX_(1),
+	binY_(1),
+	outWidth_(0),
+	outHeight_(0)
+{
+}
+
+void SoftwareBinning::Configure(unsigned int width, unsigned int height, unsigned int binX, unsigned int binY)
+{
+	width_ = width;
+	height_ = height;
+	binX_ = (binX > 0) ? binX : 1;
+	binY_ = (binY > 0) ? binY : 1;
+	outWidth_ = width_/binX_;
+	outHeight_ = height_/binY_;
+	rowSum_.resize(width_ + 8);
+	binSum_.resize(outWidth_*2 + 8);
+}
+
+/**
+* Sum of the binX x binY blocks of output row outY, outWidth_ values
+*/
+const unsigned int* SoftwareBinning::sumRow(const unsigned short* src, unsigned int outY)
+{
+	bool simd = false;
+#ifdef BINNING_SSE2
+	// same requirement, and the same run time check, as the accumulator
+	simd = AccumulateHasSimd();
+#endif
+	size_t used = (size_t) outWidth_*binX_;	// cropped width
+
+	// vertical: binY rows into rowSum_
+	memset(&rowSum_[0], 0, used*sizeof(unsigned int));
+	for (unsigned int r = 0; r < binY_; ++r)
+	{
+		const unsigned short* row = src + ((size_t) outY*binY_ + r)*width_;
+		size_t done = 0;
+#ifdef BINNING_SSE2
+		if (simd)
+			done = addRowSse2(&rowSum_[0], row, used);
+#endif
+		for (size_t x = done; x < used; ++x)
+			rowSum_[x] += row[x];
+	}
+
+	// horizontal: binX adjacent columns
+	if (binX_ == 1)
+		return &rowSum_[0];
+
+#ifdef BINNING_SSE2
+	if (simd && (binX_ == 2 || binX_ == 4))
+	{
+		// 4 is pairs of pairs; the second pass works in place at the front
+		unsigned int* pairs = &binSum_[0];
+		size_t nPairs = used/2;
+		size_t done = addPairsSse2(pairs, &rowSum_[0], nPairs);
+		for (size_t x = done; x < nPairs; ++x)
+			pairs[x] = rowSum_[2*x] + rowSum_[2*x + 1];
+		if (binX_ == 4)
+		{
+			size_t nQuads = nPairs/2;
+			done = addPairsSse2(pairs, pairs, nQuads);
+			for (size_t x = done; x < nQuads; ++x)
+				pairs[x] = pairs[2*x] + pairs[2*x + 1];
+		}
+		return pairs;
+	}
+#endif
+
+	unsigned int* out = &binSum_[0];
+	const unsigned int* in = &rowSum_[0];
+	for (unsigned int x = 0; x < outWidth_; ++x, in += binX_)
+	{
+		unsigned int s = 0;
+		for (unsigned int k = 0; k < binX_; ++k)
+			s += in[k];
+		out[x] = s;
+	}
+	return out;
+}
+
+void SoftwareBinning::Bin(const unsigned short* src, unsigned short* dst)
+{
+	for (unsigned int y = 0; y < outHeight_; ++y)
+	{
+		const unsigned int* sums = sumRow(src, y);
+		unsigned short* out = dst + (size_t) y*outWidth_;
+		for (unsigned int x = 0; x < outWidth_; ++x)
+			out[x] = (unsigned short) ((sums[x] > 65535) ? 65535 : sums[x]);
+	}
+}
+
+void SoftwareBinning::Bin(const unsigned short* src, float* dst)
+{
+	for (unsigned int y = 0; y < outHeight_; ++y)
+	{
+		const unsigned int* sums = sumRow(src, y);
+		float* out = dst + (size_t) y*outWidth_;
+		for (unsigned int x = 0; x < outWidth_; ++x)
+			out[x] = (float) sums[x];
+	}
+}
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SoftwareBinning.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Host-side NxM pixel binning of 16-bit frames
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+#ifndef _SOFTWAREBINNING_H_
+#define _SOFTWAREBINNING_H_
+
+#include <vector>
+#include <cstddef>
+
+//////////////////////////////////////////////////////////////////////////////
+// SoftwareBinning
+// Sums binX x binY blocks of a 16-bit frame, for factors the sensor can't
+// bin itself (3x3, 4x2, ...) or on top of its own binning. Columns and rows
+// left over at the right and bottom edges are cropped.
+//
+// The binY rows of a block are first added into a 32-bit row (SSE2), then
+// adjacent columns of that row are added (SSE2 for binX of 2 and 4). The
+// result is either clipped to 16 bits or kept exact as 32-bit float.
+//////////////////////////////////////////////////////////////////////////////
+class SoftwareBinning
+{
+public:
+	SoftwareBinning();
+	~SoftwareBinning() {};
+
+	void Configure(unsigned int width, unsigned int height, unsigned int binX, unsigned int binY);
+
+	bool IsActive() const {return binX_ > 1 || binY_ > 1;}
+	unsigned int GetBinX() const {return binX_;}
+	unsigned int GetBinY() const {return binY_;}
+	unsigned int GetOutputWidth() const {return outWidth_;}
+	unsigned int GetOutputHeight() const {return outHeight_;}
+
+	// Bin a frame of the configured size, saturating at 65535
+	void Bin(const unsigned short* src, unsigned short* dst);
+
+	// Bin a frame of the configured size, exactly (sums below 2^24)
+	void Bin(const unsigned short* src, float* dst);
+
+private:
+	const unsigned int* sumRow(const unsigned short* src, unsigned int outY);
+
+	unsigned int width_;
+	unsigned int height_;
+	unsigned int binX_;
+	unsigned int binY_;
+	unsigned int outWidth_;
+	unsigned int outHeight_;
+	std::vector<unsigned int> rowSum_;	// binY rows added, width_ wide
+	std::vector<unsigned int> binSum_;	// rowSum_ with binX columns added
+};
+
+#endif //_SOFTWAREBINNING_H_
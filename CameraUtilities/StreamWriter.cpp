@@ -0,0 +1,667 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          StreamWriter.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Asynchronous stream of camera frames to a raw file on disk
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#include "StreamWriter.h"
+#include "FramePacer.h"
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef WIN32
+#include <malloc.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#endif
+
+namespace
+{
+	// Unbuffered writes must start, end and sit in memory on sector
+	// boundaries; a page covers every sector size in use
+	const size_t ioAlignment = 4096;
+	const unsigned int defaultBuffers = 2;
+	const size_t defaultBufferBytes = 16 << 20;
+	const size_t defaultSyncBytes = 256 << 20;
+
+	size_t alignUp(size_t bytes)
+	{
+		return ((bytes + ioAlignment - 1)/ioAlignment)*ioAlignment;
+	}
+
+	unsigned char* allocateAligned(size_t bytes)
+	{
+#ifdef WIN32
+		return (unsigned char*) _aligned_malloc(bytes, ioAlignment);
+#else
+		void* p = 0;
+		if (posix_memalign(&p, ioAlignment, bytes) != 0)
+			return 0;
+		return (unsigned char*) p;
+#endif
+	}
+
+	void freeAligned(unsigned char* p)
+	{
+#ifdef WIN32
+		_aligned_free(p);
+#else
+		free(p);
+#endif
+	}
+}
+
+std::string JsonString(const std::string& s)
+{
+	std::string out = "\"";
+	for (size_t i = 0; i < s.size(); ++i)
+	{
+		unsigned char c = (unsigned char) s[i];
+		if (c == '"' || c == '\\')
+		{
+			out += '\\';
+			out += (char) c;
+		}
+		else if (c < 0x20)
+		{
+			char esc[8];
+			sprintf(esc, "\\u%04x", (unsigned int) c);
+			out += esc;
+		}
+		else
+			out += (char) c;
+	}
+	return out + "\"";
+}
+
+StreamWriter::StreamWriter() :
+	compression_("none"),
+	frameBytes_(0),
+	bufferBytes_(defaultBufferBytes),
+	bufferCount_(defaultBuffers),
+	syncBytes_(defaultSyncBytes),
+	open_(false),
+	direct_(false),
+	failed_(false),
+	stop_(false),
+	sidecar_(0),
+	head_(0),
+	tail_(0),
+	framesQueued_(0),
+	recordOffset_(0),
+	framesWritten_(0),
+	maxQueueDepth_(0),
+	stalls_(0),
+	bytesWritten_(0),
+	bytesSinceSync_(0),
+	busyUs_(0)
+{
+#ifdef WIN32
+	file_ = INVALID_HANDLE_VALUE;
+	thread_ = 0;
+	InitializeCriticalSection(&lock_);
+	InitializeConditionVariable(&dataCond_);
+	InitializeConditionVariable(&spaceCond_);
+#else
+	file_ = -1;
+	pthread_mutex_init(&lock_, 0);
+	pthread_cond_init(&dataCond_, 0);
+	pthread_cond_init(&spaceCond_, 0);
+#endif
+}
+
+StreamWriter::~StreamWriter()
+{
+	Close();
+#ifdef WIN32
+	DeleteCriticalSection(&lock_);
+#else
+	pthread_cond_destroy(&spaceCond_);
+	pthread_cond_destroy(&dataCond_);
+	pthread_mutex_destroy(&lock_);
+#endif
+}
+
+void StreamWriter::SetBuffers(unsigned int count, size_t bufferBytes)
+{
+	bufferCount_ = (count < 2) ? 2 : count;
+	bufferBytes_ = (bufferBytes < ioAlignment) ? ioAlignment : alignUp(bufferBytes);
+}
+
+bool StreamWriter::Open(const std::string& base, unsigned int width, unsigned int height,
+	unsigned int bytesPerPixel, unsigned long expectedFrames)
+{
+	Close();
+	error_.clear();
+	failed_ = false;
+	stop_ = false;
+	frameBytes_ = (size_t) width*height*bytesPerPixel;
+	if (frameBytes_ == 0)
+	{
+		error_ = "Empty frame";
+		return false;
+	}
+
+	buffers_.resize(bufferCount_);
+	for (unsigned int i = 0; i < bufferCount_; ++i)
+	{
+		buffers_[i].data = allocateAligned(bufferBytes_);
+		if (buffers_[i].data == 0)
+		{
+			freeBuffers();
+			error_ = "Out of memory for the staging buffers";
+			return false;
+		}
+	}
+
+	rawPath_ = base + ".raw";
+	if (!openRaw(rawPath_, (unsigned long long) frameBytes_*expectedFrames))
+	{
+		freeBuffers();
+		error_ = "Could not create " + rawPath_;
+		return false;
+	}
+	std::string jsonPath = base + ".json";
+	sidecar_ = fopen(jsonPath.c_str(), "w");
+	if (sidecar_ == 0)
+	{
+		closeRaw(0);
+		freeBuffers();
+		error_ = "Could not create " + jsonPath;
+		return false;
+	}
+
+	size_t slash = rawPath_.find_last_of("/\\");
+	std::string rawName = (slash == std::string::npos) ? rawPath_ : rawPath_.substr(slash + 1);
+	fprintf(sidecar_, "{\n\"rawFile\": %s,\n\"width\": %u,\n\"height\": %u,\n\"bytesPerPixel\": %u,\n"
+		"\"byteOrder\": \"little-endian\",\n\"frameBytes\": %lu,\n\"compression\": %s,\n\"frames\": [",
+		JsonString(rawName).c_str(), width, height, bytesPerPixel, (unsigned long) frameBytes_,
+		JsonString(compression_).c_str());
+
+	head_ = 0;
+	tail_ = 0;
+	framesQueued_ = 0;
+	recordOffset_ = 0;
+	framesWritten_ = 0;
+	maxQueueDepth_ = 0;
+	stalls_ = 0;
+	bytesWritten_ = 0;
+	bytesSinceSync_ = 0;
+	busyUs_ = 0;
+
+#ifdef WIN32
+	thread_ = (HANDLE) _beginthreadex(NULL, 0, ioThread, this, 0, NULL);
+	bool started = (thread_ != 0);
+#else
+	bool started = (pthread_create(&thread_, 0, ioThread, this) == 0);
+#endif
+	if (!started)
+	{
+		fclose(sidecar_);
+		sidecar_ = 0;
+		closeRaw(0);
+		freeBuffers();
+		error_ = "Could not start the I/O thread";
+		return false;
+	}
+	open_ = true;
+	return true;
+}
+
+bool StreamWriter::Write(const unsigned char* pixels, const std::string& metadataJson)
+{
+	return WriteRecord(pixels, frameBytes_, metadataJson);
+}
+
+bool StreamWriter::WriteRecord(const unsigned char* data, size_t bytes, const std::string& metadataJson)
+{
+	if (!open_)
+		return false;
+
+	size_t done = 0;
+	for (;;)
+	{
+		lock();
+		if (head_ - tail_ >= buffers_.size())
+		{
+			// every buffer is queued for the disk
+			++stalls_;
+			while (head_ - tail_ >= buffers_.size() && !failed_)
+				waitForSpace();
+		}
+		bool failed = failed_;
+		unlock();
+		if (failed)
+			return false;
+
+		// the buffer at head_ belongs to us until it is published
+		Staging& b = buffers_[head_ % buffers_.size()];
+		size_t n = bytes - done;
+		if (n > bufferBytes_ - b.used)
+			n = bufferBytes_ - b.used;
+		memcpy(b.data + b.used, data + done, n);
+		b.used += n;
+		done += n;
+
+		if (done == bytes)
+		{
+			char entry[80];
+			sprintf(entry, "%s{\"offset\": %llu, \"bytes\": %lu, \"metadata\": ",
+				(framesQueued_ > 0) ? ",\n" : "\n", recordOffset_, (unsigned long) bytes);
+			b.metadata += entry;
+			b.metadata += metadataJson;
+			b.metadata += "}";
+			++b.frames;
+			++framesQueued_;
+			recordOffset_ += bytes;
+		}
+		if (b.used == bufferBytes_)
+			publish();
+		if (done == bytes)
+			return true;
+	}
+}
+
+bool StreamWriter::Close()
+{
+	if (!open_)
+		return true;
+
+	if (buffers_[head_ % buffers_.size()].used > 0)
+		publish();
+	lock();
+	stop_ = true;
+	signalData();
+	unlock();
+#ifdef WIN32
+	WaitForSingleObject(thread_, INFINITE);
+	CloseHandle(thread_);
+	thread_ = 0;
+#else
+	pthread_join(thread_, 0);
+#endif
+
+	bool ok = !failed_;
+	if (!closeRaw(bytesWritten_) && ok)
+	{
+		ok = false;
+		error_ = "Could not finish " + rawPath_;
+	}
+	fprintf(sidecar_, "\n],\n\"frameCount\": %lu\n}\n", framesWritten_);
+	if (fclose(sidecar_) != 0 && ok)
+	{
+		ok = false;
+		error_ = "Could not finish the metadata file";
+	}
+	sidecar_ = 0;
+	freeBuffers();
+	open_ = false;
+	return ok;
+}
+
+std::string StreamWriter::GetError()
+{
+	lock();
+	std::string error = error_;
+	unlock();
+	return error;
+}
+
+unsigned long StreamWriter::GetFramesWritten()
+{
+	lock();
+	unsigned long frames = framesWritten_;
+	unlock();
+	return frames;
+}
+
+unsigned int StreamWriter::GetQueueDepth()
+{
+	lock();
+	unsigned int depth = (unsigned int) (head_ - tail_);
+	unlock();
+	return depth;
+}
+
+unsigned int StreamWriter::GetMaxQueueDepth()
+{
+	lock();
+	unsigned int depth = maxQueueDepth_;
+	unlock();
+	return depth;
+}
+
+unsigned long StreamWriter::GetStalls()
+{
+	lock();
+	unsigned long stalls = stalls_;
+	unlock();
+	return stalls;
+}
+
+double StreamWriter::GetThroughputMBps()
+{
+	lock();
+	double rate = (busyUs_ > 0) ? (double) bytesWritten_/busyUs_ : 0;	//bytes/us = MB/s
+	unlock();
+	return rate;
+}
+
+/**
+* Hand the buffer at head_ to the I/O thread
+*/
+void StreamWriter::publish()
+{
+	lock();
+	++head_;
+	unsigned int depth = (unsigned int) (head_ - tail_);
+	if (depth > maxQueueDepth_)
+		maxQueueDepth_ = depth;
+	signalData();
+	unlock();
+}
+
+void StreamWriter::fail(const std::string& message)
+{
+	lock();
+	if (!failed_)
+		error_ = message;
+	failed_ = true;
+	signalSpace();
+	unlock();
+}
+
+void StreamWriter::freeBuffers()
+{
+	for (size_t i = 0; i < buffers_.size(); ++i)
+	{
+		if (buffers_[i].data != 0)
+			freeAligned(buffers_[i].data);
+	}
+	buffers_.clear();
+}
+
+void StreamWriter::ioLoop()
+{
+	for (;;)
+	{
+		lock();
+		while (head_ == tail_ && !stop_)
+			waitForData();
+		bool drained = (head_ == tail_);
+		bool failed = failed_;
+		unlock();
+		if (drained)
+			break;
+
+		Staging& b = buffers_[tail_ % buffers_.size()];
+		size_t bytes = b.used;
+		double elapsedUs = 0;
+		bool ok = false;
+		if (!failed)
+		{
+			// Only the last buffer of a stream can be part full. Unbuffered
+			// writes are padded to a whole block; Close() trims the file.
+			size_t writeBytes = bytes;
+			if (direct_)
+			{
+				writeBytes = alignUp(bytes);
+				memset(b.data + bytes, 0, writeBytes - bytes);
+			}
+
+			double t0 = MonotonicClock::NowUs();
+			ok = writeRaw(b.data, writeBytes);
+			bytesSinceSync_ += writeBytes;
+			if (ok && bytesSinceSync_ >= syncBytes_)
+			{
+				ok = syncRaw();
+				bytesSinceSync_ = 0;
+			}
+			elapsedUs = MonotonicClock::NowUs() - t0;
+
+			if (ok)
+				fputs(b.metadata.c_str(), sidecar_);
+			else
+				fail("Write to " + rawPath_ + " failed");
+		}
+
+		lock();
+		if (ok)
+		{
+			bytesWritten_ += bytes;
+			framesWritten_ += b.frames;
+			busyUs_ += elapsedUs;
+		}
+		b.used = 0;
+		b.frames = 0;
+		b.metadata.clear();
+		++tail_;
+		signalSpace();
+		unlock();
+	}
+}
+
+#ifdef WIN32
+
+unsigned __stdcall StreamWriter::ioThread(void* param)
+{
+	((StreamWriter*) param)->ioLoop();
+	return 0;
+}
+
+void StreamWriter::lock()
+{
+	EnterCriticalSection(&lock_);
+}
+
+void StreamWriter::unlock()
+{
+	LeaveCriticalSection(&lock_);
+}
+
+void StreamWriter::waitForData()
+{
+	SleepConditionVariableCS(&dataCond_, &lock_, INFINITE);
+}
+
+void StreamWriter::waitForSpace()
+{
+	SleepConditionVariableCS(&spaceCond_, &lock_, INFINITE);
+}
+
+void StreamWriter::signalData()
+{
+	WakeConditionVariable(&dataCond_);
+}
+
+void StreamWriter::signalSpace()
+{
+	WakeConditionVariable(&spaceCond_);
+}
+
+bool StreamWriter::openRaw(const std::string& path, unsigned long long preallocate)
+{
+	file_ = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	direct_ = (file_ != INVALID_HANDLE_VALUE);
+	if (!direct_)
+		file_ = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file_ == INVALID_HANDLE_VALUE)
+		return false;
+
+	if (preallocate > 0)
+	{
+		// reserve the space up front so the file is not extended write by write
+		LARGE_INTEGER pos;
+		pos.QuadPart = (LONGLONG) alignUp((size_t) preallocate);
+		if (SetFilePointerEx(file_, pos, NULL, FILE_BEGIN))
+			SetEndOfFile(file_);
+		pos.QuadPart = 0;
+		SetFilePointerEx(file_, pos, NULL, FILE_BEGIN);
+	}
+	return true;
+}
+
+bool StreamWriter::writeRaw(const unsigned char* data, size_t bytes)
+{
+	while (bytes > 0)
+	{
+		DWORD chunk = (bytes > 0x40000000) ? 0x40000000 : (DWORD) bytes;
+		DWORD written = 0;
+		if (!WriteFile(file_, data, chunk, &written, NULL) || written == 0)
+			return false;
+		data += written;
+		bytes -= written;
+	}
+	return true;
+}
+
+bool StreamWriter::syncRaw()
+{
+	return FlushFileBuffers(file_) != 0;
+}
+
+bool StreamWriter::closeRaw(unsigned long long finalBytes)
+{
+	if (file_ == INVALID_HANDLE_VALUE)
+		return true;
+	bool ok = FlushFileBuffers(file_) != 0;
+	CloseHandle(file_);
+	file_ = INVALID_HANDLE_VALUE;
+
+	// Drop the preallocated tail and any padding; reopen with buffering, as
+	// the end of an unbuffered file can only be set on a sector boundary
+	HANDLE h = CreateFileA(rawPath_.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, NULL);
+	if (h == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER pos;
+	pos.QuadPart = (LONGLONG) finalBytes;
+	ok = SetFilePointerEx(h, pos, NULL, FILE_BEGIN) && SetEndOfFile(h) && ok;
+	CloseHandle(h);
+	return ok;
+}
+
+#else
+
+void* StreamWriter::ioThread(void* param)
+{
+	((StreamWriter*) param)->ioLoop();
+	return 0;
+}
+
+void StreamWriter::lock()
+{
+	pthread_mutex_lock(&lock_);
+}
+
+void StreamWriter::unlock()
+{
+	pthread_mutex_unlock(&lock_);
+}
+
+void StreamWriter::waitForData()
+{
+	pthread_cond_wait(&dataCond_, &lock_);
+}
+
+void StreamWriter::waitForSpace()
+{
+	pthread_cond_wait(&spaceCond_, &lock_);
+}
+
+void StreamWriter::signalData()
+{
+	pthread_cond_signal(&dataCond_);
+}
+
+void StreamWriter::signalSpace()
+{
+	pthread_cond_signal(&spaceCond_);
+}
+
+bool StreamWriter::openRaw(const std::string& path, unsigned long long preallocate)
+{
+	int flags = O_WRONLY | O_CREAT | O_TRUNC;
+	file_ = -1;
+	direct_ = false;
+#ifdef O_DIRECT
+	// not every file system takes O_DIRECT (tmpfs, some network mounts)
+	file_ = open(path.c_str(), flags | O_DIRECT, 0644);
+	direct_ = (file_ >= 0);
+#endif
+	if (file_ < 0)
+		file_ = open(path.c_str(), flags, 0644);
+	if (file_ < 0)
+		return false;
+#ifdef F_NOCACHE
+	fcntl(file_, F_NOCACHE, 1);
+#endif
+
+#ifdef __linux__
+	if (preallocate > 0)
+		posix_fallocate(file_, 0, (off_t) preallocate);
+#else
+	(void) preallocate;
+#endif
+	return true;
+}
+
+bool StreamWriter::writeRaw(const unsigned char* data, size_t bytes)
+{
+	while (bytes > 0)
+	{
+		ssize_t written = write(file_, data, bytes);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return false;
+		data += written;
+		bytes -= (size_t) written;
+	}
+	return true;
+}
+
+bool StreamWriter::syncRaw()
+{
+#ifdef __linux__
+	return fdatasync(file_) == 0;
+#else
+	return fsync(file_) == 0;
+#endif
+}
+
+bool StreamWriter::closeRaw(unsigned long long finalBytes)
+{
+	if (file_ < 0)
+		return true;
+	// drop the preallocated tail and any padding
+	bool ok = (ftruncate(file_, (off_t) finalBytes) == 0);
+	ok = (fsync(file_) == 0) && ok;
+	ok = (close(file_) == 0) && ok;
+	file_ = -1;
+	return ok;
+}
+
+#endif
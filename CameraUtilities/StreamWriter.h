@@ -0,0 +1,188 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          StreamWriter.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Asynchronous stream of camera frames to a raw file on disk
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#pragma once
+#ifndef _STREAMWRITER_H_
+#define _STREAMWRITER_H_
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stddef.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// StreamWriter
+// Appends frames to <base>.raw and their metadata to <base>.json. The raw
+// file has no header: uncompressed frames simply follow each other, and
+// compressed ones (see SetCompression) are records whose offset and size
+// are given in the sidecar. The caller (the sequence thread) only copies
+// each frame into a staging buffer; a dedicated I/O thread writes the full
+// buffers in order with large aligned writes, bypassing the OS cache where
+// the platform allows (O_DIRECT, FILE_FLAG_NO_BUFFERING), and flushes to the
+// disk in batches rather than per frame. The raw file is preallocated for the
+// expected number of frames and trimmed to what was written on Close().
+//
+// With two staging buffers one is filled while the other is written; more
+// buffers let a slow disk fall further behind before Write() has to wait.
+// Frames are never dropped: Write() blocks until a buffer is free.
+//////////////////////////////////////////////////////////////////////////////
+class StreamWriter
+{
+public:
+	StreamWriter();
+	~StreamWriter();
+
+	// Staging buffers used by the next Open(); bufferBytes is rounded up to
+	// whole alignment blocks
+	void SetBuffers(unsigned int count, size_t bufferBytes);
+	void SetSyncBytes(size_t syncBytes) {syncBytes_ = syncBytes;}
+
+	// Name of the codec used for the records, written to the sidecar by
+	// the next Open(); "none" for plain frames
+	void SetCompression(const std::string& name) {compression_ = name;}
+
+	// expectedFrames (0 if unknown) is used to preallocate the raw file
+	bool Open(const std::string& base, unsigned int width, unsigned int height,
+		unsigned int bytesPerPixel, unsigned long expectedFrames);
+	bool IsOpen() const {return open_;}
+
+	// Queue one frame of exactly width*height*bytesPerPixel bytes, with its
+	// metadata as a JSON object (see MetadataToJson). Returns false once an
+	// I/O error has occurred; GetError() says what.
+	bool Write(const unsigned char* pixels, const std::string& metadataJson);
+
+	// Queue one record of any size, e.g. a compressed frame
+	bool WriteRecord(const unsigned char* data, size_t bytes, const std::string& metadataJson);
+
+	// Write out everything queued and close both files
+	bool Close();
+
+	const std::string& GetRawPath() const {return rawPath_;}
+	std::string GetError();
+	bool IsDirect() const {return direct_;}
+	unsigned long GetFramesWritten();	// frames on their way to the disk
+	unsigned int GetQueueDepth();		// full buffers waiting for the I/O thread
+	unsigned int GetMaxQueueDepth();
+	unsigned long GetStalls();			// times Write() waited for a free buffer
+	double GetThroughputMBps();			// bytes written / time spent writing
+
+private:
+	StreamWriter(const StreamWriter&);
+	StreamWriter& operator=(const StreamWriter&);
+
+	struct Staging
+	{
+		unsigned char* data;
+		size_t used;
+		unsigned long frames;		// frames completed in this buffer
+		std::string metadata;		// sidecar entries for those frames
+		Staging() : data(0), used(0), frames(0) {}
+	};
+
+	void lock();
+	void unlock();
+	void waitForData();
+	void waitForSpace();
+	void signalData();
+	void signalSpace();
+	void publish();
+	bool openRaw(const std::string& path, unsigned long long preallocate);
+	bool writeRaw(const unsigned char* data, size_t bytes);
+	bool syncRaw();
+	bool closeRaw(unsigned long long finalBytes);
+	void freeBuffers();
+	void fail(const std::string& message);
+	void ioLoop();
+#ifdef WIN32
+	static unsigned __stdcall ioThread(void* param);
+#else
+	static void* ioThread(void* param);
+#endif
+
+	std::string rawPath_;
+	std::string compression_;
+	std::string error_;
+	size_t frameBytes_;
+	size_t bufferBytes_;
+	unsigned int bufferCount_;
+	size_t syncBytes_;
+	bool open_;
+	bool direct_;
+	bool failed_;
+	bool stop_;
+	FILE* sidecar_;
+
+	// Buffers are filled and written round robin: the producer fills
+	// head_ % count while the I/O thread writes tail_ % count
+	std::vector<Staging> buffers_;
+	unsigned long head_;
+	unsigned long tail_;
+	unsigned long framesQueued_;
+	unsigned long long recordOffset_;	// where the next record starts in the raw file
+	unsigned long framesWritten_;
+	unsigned int maxQueueDepth_;
+	unsigned long stalls_;
+	unsigned long long bytesWritten_;
+	unsigned long long bytesSinceSync_;
+	double busyUs_;
+
+#ifdef WIN32
+	HANDLE file_;
+	HANDLE thread_;
+	CRITICAL_SECTION lock_;
+	CONDITION_VARIABLE dataCond_;
+	CONDITION_VARIABLE spaceCond_;
+#else
+	int file_;
+	pthread_t thread_;
+	pthread_mutex_t lock_;
+	pthread_cond_t dataCond_;
+	pthread_cond_t spaceCond_;
+#endif
+};
+
+// Quote and escape a string for JSON
+std::string JsonString(const std::string& s);
+
+// One JSON object holding every tag of an MM Metadata (or anything else with
+// GetKeys() and GetSingleTag()), all values as strings
+template <class M>
+std::string MetadataToJson(const M& md)
+{
+	std::vector<std::string> keys = md.GetKeys();
+	std::string json = "{";
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		if (i > 0)
+			json += ",";
+		json += JsonString(keys[i]) + ":" + JsonString(md.GetSingleTag(keys[i].c_str()).GetValue());
+	}
+	return json + "}";
+}
+
+#endif //_STREAMWRITER_H_
@@ -0,0 +1,296 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SyntheticCamera.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Deterministic simulated sensor for benchmarking without hardware
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#include "SyntheticCamera.h"
+#include "FramePacer.h"
+#include <sstream>
+#include <stdlib.h>
+#include <math.h>
+
+SyntheticCamera::SyntheticCamera() :
+	regionX_(0),
+	regionY_(0),
+	regionW_(0),
+	regionH_(0),
+	binX_(1),
+	binY_(1),
+	continuous_(false),
+	overlapped_(false),
+	rendered_(false),
+	frameCount_(0),
+	startUs_(0),
+	endUs_(0),
+	readyUs_(0),
+	lastEndUs_(0)
+{
+	SetRegion(0, 0, config_.width, config_.height);
+}
+
+bool SyntheticCamera::Configure(const std::string& spec)
+{
+	std::string text = spec;
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		if (text[i] == ',')
+			text[i] = ' ';
+	}
+
+	SyntheticCameraConfig c = config_;
+	std::istringstream is(text);
+	std::string token;
+	while (is >> token)
+	{
+		size_t eq = token.find('=');
+		if (eq == std::string::npos)
+			return false;
+		std::string key = token.substr(0, eq);
+		std::string value = token.substr(eq + 1);
+		char* end;
+		double v = strtod(value.c_str(), &end);
+		if (value.empty() || *end != 0)
+			return false;
+
+		if (key == "width" && v >= 1 && v <= 65536)
+			c.width = (int) v;
+		else if (key == "height" && v >= 1 && v <= 65536)
+			c.height = (int) v;
+		else if (key == "bits" && v >= 1 && v <= 16)
+			c.bitDepth = (int) v;
+		else if (key == "pixel-um" && v > 0)
+			c.pixelUm = v;
+		else if (key == "readout-ms" && v >= 0)
+			c.readoutMs = v;
+		else if (key == "offset" && v >= 0)
+			c.offset = v;
+		else if (key == "signal" && v >= 0)
+			c.signalPerMs = v;
+		else if (key == "noise" && v >= 0)
+			c.noise = v;
+		else if (key == "seed" && v >= 0)
+			c.seed = (unsigned long) v;
+		else
+			return false;
+	}
+
+	bool resized = (c.width != config_.width || c.height != config_.height);
+	config_ = c;
+	if (resized)
+	{
+		scene_.clear();
+		SetRegion(0, 0, config_.width, config_.height);
+	}
+	return true;
+}
+
+std::string SyntheticCamera::GetConfigString() const
+{
+	std::ostringstream os;
+	os << "width=" << config_.width << " height=" << config_.height
+		<< " bits=" << config_.bitDepth << " pixel-um=" << config_.pixelUm
+		<< " readout-ms=" << config_.readoutMs << " offset=" << config_.offset
+		<< " signal=" << config_.signalPerMs << " noise=" << config_.noise
+		<< " seed=" << config_.seed;
+	return os.str();
+}
+
+void SyntheticCamera::SetRegion(int x, int y, int w, int h)
+{
+	if (x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > config_.width || y + h > config_.height)
+	{
+		x = 0;
+		y = 0;
+		w = config_.width;
+		h = config_.height;
+	}
+	regionX_ = x;
+	regionY_ = y;
+	regionW_ = w;
+	regionH_ = h;
+}
+
+void SyntheticCamera::GetRegion(int& x, int& y, int& w, int& h) const
+{
+	x = regionX_;
+	y = regionY_;
+	w = regionW_;
+	h = regionH_;
+}
+
+void SyntheticCamera::SetBinning(int binX, int binY)
+{
+	binX_ = (binX >= 1) ? binX : 1;
+	binY_ = (binY >= 1) ? binY : 1;
+}
+
+void SyntheticCamera::GetBinning(int& binX, int& binY) const
+{
+	binX = binX_;
+	binY = binY_;
+}
+
+void SyntheticCamera::StartExposure(double exposureMs)
+{
+	double now = MonotonicClock::NowUs();
+	overlapped_ = false;
+	if (continuous_ && frameCount_ > 0)
+		beginFrame(lastEndUs_, now);	//read out what has built up since the last read
+	else
+		beginFrame(now, now + exposureMs*1000);
+}
+
+void SyntheticCamera::StartOverlappedExposure(double exposureMs)
+{
+	// The camera went straight on to this exposure when the last one ended,
+	// unless we come back so late that it would already be over
+	double now = MonotonicClock::NowUs();
+	double exposureUs = exposureMs*1000;
+	double start = (overlapped_ && lastEndUs_ + exposureUs > now) ? lastEndUs_ : now;
+	overlapped_ = true;
+	beginFrame(start, start + exposureUs);
+}
+
+void SyntheticCamera::SetContinuous(bool continuous)
+{
+	continuous_ = continuous;
+	lastEndUs_ = MonotonicClock::NowUs();
+}
+
+void SyntheticCamera::Abort()
+{
+	readyUs_ = MonotonicClock::NowUs();
+}
+
+bool SyntheticCamera::IsReady()
+{
+	double now = MonotonicClock::NowUs();
+	if (now >= readyUs_)
+		return true;
+	MonotonicClock::SleepUntilUs((readyUs_ - now > 1000) ? now + 1000 : readyUs_);
+	return MonotonicClock::NowUs() >= readyUs_;
+}
+
+const unsigned short* SyntheticCamera::GetFrame()
+{
+	if (!rendered_)
+		render();
+	return frame_.empty() ? 0 : &frame_[0];
+}
+
+void SyntheticCamera::beginFrame(double startUs, double endUs)
+{
+	startUs_ = startUs;
+	endUs_ = endUs;
+	lastEndUs_ = endUs;
+	readyUs_ = endUs + config_.readoutMs*1000;
+	rendered_ = false;
+	++frameCount_;
+}
+
+/**
+* A smooth background with a grid of gaussian spots of different heights,
+* so that frames have both low and high spatial frequencies and the full
+* range of levels. Built on first use.
+*/
+void SyntheticCamera::buildScene()
+{
+	const int w = config_.width;
+	const int h = config_.height;
+	scene_.assign((size_t) w*h, 0.0f);
+
+	const int spacing = 64;
+	const double sigma2 = 2*6.0*6.0;
+	for (int y = 0; y < h; y++)
+	{
+		int cy = (y/spacing)*spacing + spacing/2;
+		double dy = y - cy;
+		for (int x = 0; x < w; x++)
+		{
+			int cx = (x/spacing)*spacing + spacing/2;
+			double dx = x - cx;
+			double peak = 0.3 + 0.7*(((x/spacing)*7 + (y/spacing)*13) % 10)/9.0;
+			double background = 0.05 + 0.1*x/w + 0.1*y/h;
+			double v = background + (1 - background)*peak*exp(-(dx*dx + dy*dy)/sigma2);
+			scene_[(size_t) y*w + x] = (float) v;
+		}
+	}
+}
+
+/**
+* Offset plus the scene, drifted right by one pixel per frame and scaled by
+* the exposure and the binned area, plus gaussian read noise. The noise is
+* the sum of four uniform bytes; one xorshift64* draw serves two pixels.
+*/
+void SyntheticCamera::render()
+{
+	const int w = GetImageWidth();
+	const int h = GetImageHeight();
+	frame_.resize((size_t) w*h);
+	rendered_ = true;
+	if (w <= 0 || h <= 0)
+		return;
+	if (scene_.empty())
+		buildScene();
+
+	const int sensorW = config_.width;
+	const float maxValue = (float) ((1 << config_.bitDepth) - 1);
+	const float gain = (float) (config_.signalPerMs*GetExposureMs()*binX_*binY_);
+	const float noiseScale = (float) (config_.noise*sqrt(3.0)/256);
+	const float base = (float) config_.offset - 2*255.0f*noiseScale + 0.5f;
+	const long drift = frameCount_ - 1;
+
+	unsigned long long state = ((unsigned long long) config_.seed + 1)*0x9E3779B97F4A7C15ULL
+		^ ((unsigned long long) drift + 1)*0xBF58476D1CE4E5B9ULL;
+	if (state == 0)
+		state = 1;
+
+	for (int j = 0; j < h; j++)
+	{
+		const float* sceneRow = &scene_[(size_t) (regionY_ + j*binY_)*sensorW];
+		unsigned short* out = &frame_[(size_t) j*w];
+		int sx = (int) ((regionX_ + drift) % sensorW);
+		unsigned long long r = 0;
+		for (int i = 0; i < w; i++)
+		{
+			if ((i & 1) == 0)
+			{
+				state ^= state >> 12;
+				state ^= state << 25;
+				state ^= state >> 27;
+				r = state*0x2545F4914F6CDD1DULL;
+			}
+			else
+				r >>= 32;
+			unsigned int sum = (unsigned int) ((r & 0xFF) + ((r >> 8) & 0xFF) + ((r >> 16) & 0xFF) + ((r >> 24) & 0xFF));
+
+			float v = base + gain*sceneRow[sx] + (float) sum*noiseScale;
+			if (v < 0)
+				v = 0;
+			else if (v > maxValue)
+				v = maxValue;
+			out[i] = (unsigned short) v;
+
+			sx += binX_;
+			if (sx >= sensorW)
+				sx -= sensorW;
+		}
+	}
+}
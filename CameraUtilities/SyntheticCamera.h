@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SyntheticCamera.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Deterministic simulated sensor for benchmarking without hardware
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+
+#pragma once
+#ifndef _SYNTHETICCAMERA_H_
+#define _SYNTHETICCAMERA_H_
+
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// SyntheticCameraConfig
+// Sensor model; see SyntheticCamera::Configure() for the text form
+//////////////////////////////////////////////////////////////////////////////
+struct SyntheticCameraConfig
+{
+	int width;				// sensor pixels
+	int height;
+	int bitDepth;			// significant bits in each 16 bit word
+	double pixelUm;
+	double readoutMs;		// from end of exposure to frame ready
+	double offset;			// DN
+	double signalPerMs;		// DN per ms of exposure at the brightest point of the scene
+	double noise;			// read noise, DN rms
+	unsigned long seed;
+
+	SyntheticCameraConfig() :
+		width(1392), height(1040), bitDepth(16), pixelUm(6.45), readoutMs(30),
+		offset(100), signalPerMs(50), noise(8), seed(1) {}
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// SyntheticCamera
+// A simulated sensor for exercising the acquisition path without hardware.
+// Exposures take real time - exposure plus readout on the monotonic clock -
+// and frames are rendered from a fixed scene that drifts by one pixel per
+// frame, plus read noise from a generator seeded by the frame number. The
+// same configuration, exposure and region therefore always produce the
+// same sequence of frames.
+//
+// Three exposure modes mirror what scientific CCDs offer: a normal exposure
+// clears the sensor when started; an overlapped exposure begins as soon as
+// the previous one ends, during its readout; and in continuous mode each
+// read ends the integration that has run since the previous read.
+//////////////////////////////////////////////////////////////////////////////
+class SyntheticCamera
+{
+public:
+	SyntheticCamera();
+	~SyntheticCamera() {};
+
+	// Whitespace or comma separated key=value pairs, e.g.
+	// "width=2048 height=2048 bits=12 readout-ms=10 noise=3 seed=7".
+	// Keys: width, height, bits, pixel-um, readout-ms, offset, signal, noise,
+	// seed. Unknown keys or bad values leave the configuration unchanged.
+	bool Configure(const std::string& spec);
+	std::string GetConfigString() const;
+	const SyntheticCameraConfig& GetConfig() const {return config_;}
+
+	// Region in unbinned sensor pixels; resets to the full sensor if invalid
+	void SetRegion(int x, int y, int w, int h);
+	void GetRegion(int& x, int& y, int& w, int& h) const;
+	void SetBinning(int binX, int binY);
+	void GetBinning(int& binX, int& binY) const;
+	int GetImageWidth() const {return regionW_/binX_;}
+	int GetImageHeight() const {return regionH_/binY_;}
+
+	void StartExposure(double exposureMs);
+	void StartOverlappedExposure(double exposureMs);
+	void SetContinuous(bool continuous);
+	bool IsContinuous() const {return continuous_;}
+	void Abort();
+
+	// Polling a frame that is not ready yet costs up to a millisecond, as a
+	// USB round trip to a real camera would, so that callers which spin on
+	// this do not occupy a whole core.
+	bool IsReady();
+
+	// The current frame, rendered on first access; GetImageWidth() x
+	// GetImageHeight() 16 bit pixels
+	const unsigned short* GetFrame();
+
+	long GetFrameCount() const {return frameCount_;}
+	double GetExposureStartUs() const {return startUs_;}
+	double GetExposureMs() const {return (endUs_ - startUs_)/1000;}
+
+private:
+	void beginFrame(double startUs, double endUs);
+	void buildScene();
+	void render();
+
+	SyntheticCameraConfig config_;
+	std::vector<float> scene_;	//0..1 per sensor pixel, built on first render
+	std::vector<unsigned short> frame_;
+
+	int regionX_;
+	int regionY_;
+	int regionW_;
+	int regionH_;
+	int binX_;
+	int binY_;
+
+	bool continuous_;
+	bool overlapped_;	//the previous exposure was overlapped
+	bool rendered_;
+	long frameCount_;
+	double startUs_;
+	double endUs_;
+	double readyUs_;
+	double lastEndUs_;	//end of the previous integration
+};
+
+#endif //_SYNTHETICCAMERA_H_
@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          FrameCodecCheck.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Round trip of FrameCodec over frame sizes, bit depths and
+//                thread counts, and rejection of damaged input. Needs no
+//                camera.
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "../FrameCodec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, unsigned int width, unsigned int height, unsigned int threads)
+{
+	if (!ok)
+	{
+		printf("FAIL %s, %ux%u, %u thread(s)\n", what, width, height, threads);
+		++failures;
+	}
+}
+
+// A smooth ramp plus noise of the given amplitude, clipped to bits
+static void makeFrame(std::vector<unsigned short>& frame, unsigned int width, unsigned int height, int bits, int noise)
+{
+	int maxValue = (1 << bits) - 1;
+	for (unsigned int y = 0; y < height; ++y)
+	{
+		for (unsigned int x = 0; x < width; ++x)
+		{
+			int v = (int) ((x + 2*y) % (maxValue + 1));
+			if (noise > 0)
+				v += rand() % (2*noise + 1) - noise;
+			v = (v < 0) ? 0 : ((v > maxValue) ? maxValue : v);
+			frame[(size_t) y*width + x] = (unsigned short) v;
+		}
+	}
+}
+
+int main()
+{
+	srand(11);
+	printf("SIMD residuals: %s\n", CodecHasSimd() ? "yes" : "no");
+
+	// Widths around the 8-pixel vector and 32-value block sizes, heights
+	// around the stripe size
+	const unsigned int widths[] = {1, 2, 7, 8, 9, 31, 33, 640, 1392};
+	const unsigned int heights[] = {1, 2, 63, 64, 65, 130, 1040};
+	const int bits[] = {8, 12, 16};
+	const unsigned int threads[] = {1, 2, 5};
+
+	FrameCodec codecs[3];
+	for (int t = 0; t < 3; ++t)
+		codecs[t].SetThreads(threads[t]);
+
+	for (size_t w = 0; w < sizeof(widths)/sizeof(widths[0]); ++w)
+	{
+		for (size_t h = 0; h < sizeof(heights)/sizeof(heights[0]); ++h)
+		{
+			unsigned int width = widths[w], height = heights[h];
+			if ((size_t) width*height > 1392*1040/4 && (w + h) % 2 != 0)
+				continue;	// a few large frames are enough
+			for (size_t b = 0; b < sizeof(bits)/sizeof(bits[0]); ++b)
+			{
+				std::vector<unsigned short> frame((size_t) width*height), out(frame.size());
+				makeFrame(frame, width, height, bits[b], (bits[b] == 16) ? 30000 : 8);
+
+				std::vector<unsigned char> first;
+				for (int t = 0; t < 3; ++t)
+				{
+					std::vector<unsigned char> packed(FrameCodec::MaxCompressedBytes(width, height));
+					size_t bytes = codecs[t].Compress(&frame[0], width, height, &packed[0]);
+					check(bytes <= packed.size(), "compressed size within bound", width, height, threads[t]);
+					packed.resize(bytes);
+
+					// the stripes are fixed, so the output must not depend on the threads
+					if (t == 0)
+						first = packed;
+					else
+						check(packed == first, "output independent of threads", width, height, threads[t]);
+
+					unsigned int fw = 0, fh = 0;
+					check(FrameCodec::GetFrameSize(&packed[0], bytes, fw, fh) && fw == width && fh == height,
+						"frame size in header", width, height, threads[t]);
+
+					out.assign(out.size(), 0);
+					bool ok = codecs[t].Decompress(&packed[0], bytes, &out[0], width, height);
+					check(ok && out == frame, "lossless round trip", width, height, threads[t]);
+
+					// truncated, or the wrong size, must be refused
+					check(!codecs[t].Decompress(&packed[0], bytes - 1, &out[0], width, height),
+						"truncated frame refused", width, height, threads[t]);
+					check(!codecs[t].Decompress(&packed[0], bytes, &out[0], width + 1, height),
+						"wrong width refused", width, height, threads[t]);
+				}
+			}
+		}
+	}
+
+	// 12-bit data in 16-bit pixels should shrink by at least the unused bits
+	{
+		unsigned int width = 1392, height = 1040;
+		std::vector<unsigned short> frame((size_t) width*height);
+		makeFrame(frame, width, height, 12, 8);
+		std::vector<unsigned char> packed(FrameCodec::MaxCompressedBytes(width, height));
+		size_t bytes = codecs[2].Compress(&frame[0], width, height, &packed[0]);
+		check(bytes*4 <= frame.size()*2*3, "12-bit frame compresses", width, height, threads[2]);
+	}
+
+	if (failures > 0)
+	{
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+	printf("all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,248 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SimdCheck.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Checks the vectorized CameraUtilities kernels against plain
+//                per-pixel reference loops, at sizes that exercise the
+//                scalar tails. Needs no camera.
+//
+// AUTHOR:        agent, agent@local, 18/10/2026
+//
+// COPYRIGHT:
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "../PixelUnpack.h"
+#include "../FrameAccumulator.h"
+#include "../FrameStatistics.h"
+#include "../SoftwareBinning.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, size_t size)
+{
+	if (!ok)
+	{
+		printf("FAIL %s, size %lu\n", what, (unsigned long) size);
+		++failures;
+	}
+}
+
+static void randomFill(std::vector<unsigned short>& v, unsigned int mask)
+{
+	for (size_t i = 0; i < v.size(); ++i)
+		v[i] = (unsigned short) (((rand() << 8) ^ rand()) & mask);
+}
+
+// Sizes around the vector widths, plus a whole sensor
+static const size_t sizes[] = {1, 2, 7, 8, 9, 15, 16, 17, 31, 33, 63, 65, 1001, 4099, 1392*1040};
+static const size_t nSizes = sizeof(sizes)/sizeof(sizes[0]);
+
+// On x86 with gcc/clang the CPU is asked directly, so that a build which
+// left out the vector unpack kernel fails rather than comparing the scalar
+// kernel with itself
+static bool cpuHasSsse3()
+{
+#if (defined(__i386__) || defined(__x86_64__)) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("ssse3") != 0;
+#else
+	return false;
+#endif
+}
+
+static void checkUnpack12()
+{
+	check(Unpack12HasSimd() || !cpuHasSsse3(), "Unpack12To16 uses SSSE3 on this CPU", 0);
+	for (size_t k = 0; k < nSizes; ++k)
+	{
+		size_t n = sizes[k];
+		std::vector<unsigned char> packed((n*3 + 1)/2);
+		for (size_t i = 0; i < packed.size(); ++i)
+			packed[i] = (unsigned char) rand();
+		std::vector<unsigned short> simd(n), scalar(n);
+		Unpack12To16(&packed[0], &simd[0], n);
+		Unpack12To16Scalar(&packed[0], &scalar[0], n);
+		check(simd == scalar, "Unpack12To16", n);
+	}
+}
+
+static void checkAccumulate()
+{
+	const unsigned int frames = 3;
+	for (size_t k = 0; k < nSizes; ++k)
+	{
+		size_t n = sizes[k];
+		std::vector<std::vector<unsigned short> > in(frames, std::vector<unsigned short>(n));
+		std::vector<double> sum(n, 0), sumSq(n, 0);
+		FrameAccumulator acc;
+		acc.Start(n, frames, true);
+		for (unsigned int f = 0; f < frames; ++f)
+		{
+			randomFill(in[f], 0xFFFF);
+			for (size_t i = 0; i < n; ++i)
+			{
+				sum[i] += in[f][i];
+				sumSq[i] += (double) in[f][i]*in[f][i];
+			}
+			acc.Add(&in[f][0]);
+		}
+		check(acc.IsComplete(), "FrameAccumulator complete", n);
+
+		bool sumOk = true, varOk = true;
+		std::vector<float> var(n);
+		acc.VarianceToFloat(&var[0]);
+		for (size_t i = 0; i < n; ++i)
+		{
+			if (acc.GetSum()[i] != sum[i])
+				sumOk = false;
+			double v = (sumSq[i] - sum[i]*sum[i]/frames)/(frames - 1);
+			if (fabs(var[i] - v) > 1e-3*v + 1)
+				varOk = false;
+		}
+		check(sumOk, "FrameAccumulator 16-bit sum", n);
+		check(varOk, "FrameAccumulator variance", n);
+
+		std::vector<unsigned char> in8(n);
+		acc.Start(n, 1, false);
+		for (size_t i = 0; i < n; ++i)
+			in8[i] = (unsigned char) rand();
+		acc.Add(&in8[0]);
+		bool sum8Ok = true;
+		for (size_t i = 0; i < n; ++i)
+			if (acc.GetSum()[i] != in8[i])
+				sum8Ok = false;
+		check(sum8Ok, "FrameAccumulator 8-bit sum", n);
+	}
+
+	// the largest sum allowed must still come out exactly as float
+	size_t n = 17;
+	std::vector<unsigned short> full(n, 65535);
+	std::vector<float> out(n);
+	FrameAccumulator acc;
+	acc.Start(n, FrameAccumulator::MaxExactFrames, false);
+	for (unsigned int f = 0; f < FrameAccumulator::MaxExactFrames; ++f)
+		acc.Add(&full[0]);
+	acc.SumToFloat(&out[0]);
+	bool exact = true;
+	for (size_t i = 0; i < n; ++i)
+		if ((unsigned int) out[i] != 65535u*FrameAccumulator::MaxExactFrames || out[i] + 1 == out[i])
+			exact = false;
+	check(exact, "FrameAccumulator float sum exact at MaxExactFrames", n);
+}
+
+static void checkStatistics()
+{
+	const int bits = 12;
+	for (size_t k = 0; k < nSizes; ++k)
+	{
+		size_t n = sizes[k];
+		std::vector<unsigned short> src(n), dst(n);
+		randomFill(src, 0x0FFF);
+		src[n/2] = 4095;	// at least one saturated pixel
+
+		unsigned int mn = 0xFFFFFFFF, mx = 0;
+		unsigned long long sum = 0, sumSq = 0;
+		size_t saturated = 0;
+		std::vector<unsigned int> hist(256, 0);
+		for (size_t i = 0; i < n; ++i)
+		{
+			unsigned int v = src[i];
+			mn = (v < mn) ? v : mn;
+			mx = (v > mx) ? v : mx;
+			sum += v;
+			sumSq += (unsigned long long) v*v;
+			if (v >= 4095)
+				++saturated;
+			++hist[v >> (bits - 8)];
+		}
+
+		FrameStatistics stats;
+		stats.SetBitDepth(bits);
+		stats.EnableHistogram(true);
+		stats.Process(&src[0], &dst[0], n);
+		check(dst == src, "FrameStatistics copy", n);
+		check(stats.GetMin() == mn && stats.GetMax() == mx, "FrameStatistics min/max", n);
+		check(stats.GetSum() == (double) sum && stats.GetSumSq() == (double) sumSq, "FrameStatistics sums", n);
+		check(stats.GetSaturated() == saturated, "FrameStatistics saturation", n);
+		check(stats.GetHistogram() == hist, "FrameStatistics histogram", n);
+	}
+}
+
+static void checkBinning()
+{
+	const unsigned int widths[] = {1, 7, 17, 64, 131};
+	for (size_t w = 0; w < sizeof(widths)/sizeof(widths[0]); ++w)
+	{
+		for (unsigned int binX = 1; binX <= 4; ++binX)
+		{
+			for (unsigned int binY = 1; binY <= 3; ++binY)
+			{
+				unsigned int width = widths[w] + binX;
+				unsigned int height = 11;
+				std::vector<unsigned short> src((size_t) width*height);
+				randomFill(src, 0xFFFF);
+
+				SoftwareBinning binning;
+				binning.Configure(width, height, binX, binY);
+				unsigned int ow = binning.GetOutputWidth(), oh = binning.GetOutputHeight();
+				std::vector<unsigned short> out16((size_t) ow*oh);
+				std::vector<float> out32((size_t) ow*oh);
+				binning.Bin(&src[0], &out16[0]);
+				binning.Bin(&src[0], &out32[0]);
+
+				bool ok16 = (ow == width/binX && oh == height/binY), ok32 = ok16;
+				for (unsigned int y = 0; ok16 && y < oh; ++y)
+				{
+					for (unsigned int x = 0; x < ow; ++x)
+					{
+						unsigned int s = 0;
+						for (unsigned int dy = 0; dy < binY; ++dy)
+							for (unsigned int dx = 0; dx < binX; ++dx)
+								s += src[(size_t) (y*binY + dy)*width + x*binX + dx];
+						if (out16[(size_t) y*ow + x] != ((s > 65535) ? 65535 : s))
+							ok16 = false;
+						if (out32[(size_t) y*ow + x] != (float) s)
+							ok32 = false;
+					}
+				}
+				check(ok16, "SoftwareBinning 16-bit", (size_t) width*100 + binX*10 + binY);
+				check(ok32, "SoftwareBinning float", (size_t) width*100 + binX*10 + binY);
+			}
+		}
+	}
+}
+
+int main()
+{
+	srand(7);
+	printf("SIMD kernels: unpack %s, accumulate %s, statistics %s\n",
+		Unpack12HasSimd() ? "yes" : "no", AccumulateHasSimd() ? "yes" : "no",
+		StatisticsHasSimd() ? "yes" : "no");
+
+	checkUnpack12();
+	checkAccumulate();
+	checkStatistics();
+	checkBinning();
+
+	if (failures > 0)
+	{
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+	printf("all checks passed\n");
+	return 0;
+}
@@ -23,6 +23,7 @@
 //#include "FlyCapture2.h"
 
 #include <cstdio>
+#include <ctime>
 #include <string>
 #include <math.h>
 #include "../MMDevice/ModuleInterface.h"
@@ -41,6 +42,7 @@ using namespace std;
 // External names used used by the rest of the system
 // to load particular device from the "Flea2.dll" library
 const char* g_CameraDeviceName = "Flea2Cam";
+const char* g_Keyword_CameraIndexSerial = "CameraIndex/Serial";
 
 
 // constants for naming pixel types (allowed values of the "PixelType" property)
@@ -99,6 +101,13 @@ MODULE_API void DeleteDevice(MM::Device* pDevice)
 */
 CFlea2::CFlea2() :
 CCameraBase<CFlea2> (),
+	activeFmt7Valid_(false),
+	bwClientId_(0),
+	bwGeneration_(0),
+	targetFps_(0),
+	packetBytes_(0),
+	packetUnit_(0),
+	packetMax_(0),
 	//exposureMaximum_(63312.04),
 	exposureMaximum_(10000),	//Currently hardcoded
 	initialized_(false),
@@ -112,6 +121,10 @@ CCameraBase<CFlea2> (),
 	sequenceMaxLength_(100),
 	sequenceRunning_(false),
 	sequenceIndex_(0),
+	frameExposure_(0),
+	shutterPropValid_(false),
+	appliedExposure_(-1),
+	grabTimeoutClass_(-1),
 	binSizeX_(1),
 	binSizeY_(1),
 	trigMode_("Isochronous"),
@@ -124,6 +137,55 @@ CCameraBase<CFlea2> (),
 	flipUD_(false),
 	flipLR_(false),
 	imageRotationAngle_(0),
+	streaming_(false),
+	grabBuffers_(20),
+	queueDepth_(16),
+	queueDropped_(0),
+	triggersPending_(0),
+	hwTriggerTimeoutMs_(10000),
+	snapRetrieved_(false),
+	embeddedInfo_(false),
+	frameCounter_(0),
+	frameTimestamp_(0),
+	embeddedShutter_(false),
+	frameShutter_(0),
+	timestampBaseUs_(0),
+	lastTimestampUs_(0),
+	accumulateFrames_(1),
+	accumulateVariance_(false),
+	accumReady_(false),
+	correctionFrames_(16),
+	hotPixelSigma_(5.0),
+	capturingReference_(false),
+	statsEnabled_(false),
+	histogramEnabled_(false),
+	frameScanned_(false),
+	autoExposureEnabled_(false),
+	autoExposurePending_(0),
+	aeOldExposure_(0),
+	aeOldShutter_(0),
+	aeInFlight_(0),
+	aeSumStale_(false),
+	softBinX_(1),
+	softBinY_(1),
+	softBin32_(false),
+	burstEnabled_(false),
+	burstBackground_(false),
+	burstCapacity_(200),
+	burstActive_(false),
+	streamEnabled_(false),
+	streamToCore_(false),
+	streamDir_(""),
+	streamBuffers_(2),
+	streamBufferMB_(16),
+	streamCount_(0),
+	streamActive_(false),
+	streamCompress_(false),
+	streamPacked_(false),
+	codecThreads_(0),
+	streamRawBytes_(0),
+	streamPackedBytes_(0),
+	codecBenchmark_(""),
 	
 	nComponents_(1)
 {
@@ -131,18 +193,41 @@ CCameraBase<CFlea2> (),
 
 	// call the base class method to set-up default error codes/messages
 	InitializeDefaultErrorMessages();
+	SetErrorText(ERR_TRIGGER_NOT_READY, "Camera did not become ready for a software trigger");
+	SetErrorText(ERR_HW_TRIGGER_TIMEOUT, "No external trigger received within HardwareTriggerTimeout-ms");
+	SetErrorText(ERR_CAMERA_NOT_FOUND, "No camera with this index or serial number - check CameraIndex/Serial");
+	SetErrorText(ERR_CORRECTION_PIXELTYPE, "Dark and flat correction need 16-bit pixels");
+	SetErrorText(ERR_CORRECTION_FILE, "Could not read or write the correction references - check CorrectionReferenceDir");
+	SetErrorText(ERR_BINNING_ACCUMULATE, "32-bit software binning cannot be combined with AccumulateFrames - use 16-bit");
+	SetErrorText(ERR_BURST_FULL, "Burst ring full - raise BurstCapacity or drain in the background");
+	SetErrorText(ERR_BURST_MEMORY, "Could not allocate the burst ring - lower BurstCapacity");
+	SetErrorText(ERR_STREAM_FILE, "Could not write the stream to disk - check StreamDir");
 	readoutStartTime_ = GetCurrentMMTime();
 	thd_ = new MySequenceThread(this);
+	burstDrain_ = new BurstDrainThread(this);
+	retrieval_ = new RetrievalThread(this);
+	frameEvent_ = CreateEvent(NULL, FALSE, FALSE, NULL);	//auto-reset
+	bwClientId_ = BandwidthPlanner::Instance().Register();
 
 	CreateFloatProperty("MaximumExposureMs", exposureMaximum_, false,
 		new CPropertyAction(this, &CFlea2::OnMaxExposure),
 		true);
 
-	//CreateIntegerProperty("Physical camera", 1, false, 
-	//	new CPropertyAction(this, &CFlea2::OnPhysicalCamera), 
-	//	true);
-
-	////
+	// Which camera this instance drives, by bus index or serial number, so
+	// several Flea2s can be loaded side by side
+	CreateStringProperty(g_Keyword_CameraIndexSerial, "0", false, 0, true);
+	FlyCapture2::BusManager busMgr;
+	unsigned int numCameras = 0;
+	if (busMgr.GetNumOfCameras(&numCameras) == FlyCapture2::PGRERROR_OK)
+	{
+		for (unsigned int i = 0; i < numCameras; i++)
+		{
+			unsigned int serial;
+			AddAllowedValue(g_Keyword_CameraIndexSerial, boost::lexical_cast<std::string>(i).c_str());
+			if (busMgr.GetCameraSerialNumberFromIndex(i, &serial) == FlyCapture2::PGRERROR_OK)
+				AddAllowedValue(g_Keyword_CameraIndexSerial, boost::lexical_cast<std::string>(serial).c_str());
+		}
+	}
 }
 
 /**
@@ -156,6 +241,10 @@ CFlea2::~CFlea2()
 {
 	StopSequenceAcquisition();
 	delete thd_;
+	delete burstDrain_;
+	delete retrieval_;
+	CloseHandle(frameEvent_);
+	BandwidthPlanner::Instance().Unregister(bwClientId_);
 }
 
 /**
@@ -175,7 +264,7 @@ void CFlea2::GetName(char* name) const
 * Device properties are typically created here as well, except
 * the ones we need to use for defining initialization parameters.
 * Such pre-initialization properties are created in the constructor.
-* (This device does not have any pre-initialization properties)
+* The camera is chosen by the CameraIndex/Serial pre-initialization property.
 */
 int CFlea2::Initialize()
 {
@@ -196,10 +285,25 @@ int CFlea2::Initialize()
         return DEVICE_ERR;
     }
 	else if (numCameras<1)
-		return FlyCapture2::PGRERROR_NOT_FOUND;
+		return ERR_CAMERA_NOT_FOUND;
+
+	// Values below the camera count are bus indices, anything else a serial number
+	char cameraId[MM::MaxStrLength];
+	GetProperty(g_Keyword_CameraIndexSerial, cameraId);
+	unsigned int id = (unsigned int) atol(cameraId);
+	if (id < numCameras)
+		pgrErr = busMgr.GetCameraFromIndex(id, &guid);
+	else
+		pgrErr = busMgr.GetCameraFromSerialNumber(id, &guid);
+	if (pgrErr != FlyCapture2::PGRERROR_OK)
+		return ERR_CAMERA_NOT_FOUND;
 
-	pgrErr = busMgr.GetCameraFromIndex(0, &guid);
 	pgrErr = hCam_.Connect(&guid);
+	if (pgrErr != FlyCapture2::PGRERROR_OK)
+	{
+		LogMessage( (std::string) pgrErr.GetDescription() );
+		return DEVICE_ERR;
+	}
 	pgrErr = hCam_.GetCameraInfo(&camInfo);
 
 	// set property list
@@ -286,7 +390,24 @@ int CFlea2::Initialize()
 	vector<string> bitDepths;
 	bitDepths.push_back("8");
 	//bitDepths.push_back("10");
-	//bitDepths.push_back("12");
+
+	// 12 bit uses packed MONO12 on the bus (1.5 bytes/pixel rather than 2)
+	// and is unpacked to 16 bit on the host. Its pixels are right aligned
+	// (0..4095), as GetBitDepth reports, whereas 16 bit uses the full range;
+	// switching between the two scales the values by 16.
+	FlyCapture2::Format7Info* pFmt7Info;
+	if (getFormat7Info(FlyCapture2::MODE_0, pFmt7Info) == DEVICE_OK
+		&& (pFmt7Info->pixelFormatBitField & FlyCapture2::PIXEL_FORMAT_MONO12))
+	{
+		bitDepths.push_back("12");
+
+		pAct = new CPropertyAction (this, &CFlea2::OnUnpackBenchmark);
+		CreateStringProperty("Unpack12Benchmark", "Idle", false, pAct);
+		AddAllowedValue("Unpack12Benchmark", "Idle");
+		AddAllowedValue("Unpack12Benchmark", "Run");
+		pAct = new CPropertyAction (this, &CFlea2::OnUnpackBenchmarkResult);
+		CreateStringProperty("Unpack12BenchmarkResult", "", true, pAct);
+	}
 	//bitDepths.push_back("14");
 	bitDepths.push_back("16");
 	//bitDepths.push_back("32");
@@ -294,6 +415,15 @@ int CFlea2::Initialize()
 	if (nRet != DEVICE_OK)
 		return nRet;
 
+	// Isochronous bandwidth: packet size is planned from the target rate and
+	// negotiated with any other Flea2 on the bus
+	pAct = new CPropertyAction (this, &CFlea2::OnTargetFrameRate);
+	CreateFloatProperty("TargetFrameRate", targetFps_, false, pAct);
+	pAct = new CPropertyAction (this, &CFlea2::OnBytesPerPacket);
+	CreateIntegerProperty("BytesPerPacket", 0, true, pAct);
+	pAct = new CPropertyAction (this, &CFlea2::OnAchievableFrameRate);
+	CreateFloatProperty("AchievableFrameRate", 0, true, pAct);
+
 	// exposure
 	float exp = 10.0;
 	nRet = CreateFloatProperty(MM::g_Keyword_Exposure, exp, false);
@@ -326,6 +456,12 @@ int CFlea2::Initialize()
 	AddAllowedValue("TriggerMode", "Asynchronous-software");
 	AddAllowedValue("TriggerMode", "Isochronous");
 
+	// In Asynchronous-hardware mode frames arrive whenever the trigger input
+	// fires, so the wait for each one is bounded by this rather than the exposure
+	pAct = new CPropertyAction (this, &CFlea2::OnHardwareTriggerTimeout);
+	CreateIntegerProperty("HardwareTriggerTimeout-ms", hwTriggerTimeoutMs_, false, pAct);
+	SetPropertyLimits("HardwareTriggerTimeout-ms", 100, 600000);
+
 	//Gain 
 	pAct = new CPropertyAction (this, &CFlea2::OnGain);
 	CreateFloatProperty("Gain", 1, false, pAct);
@@ -351,6 +487,208 @@ int CFlea2::Initialize()
     AddAllowedValue("RotateImage","180");
     //AddAllowedValue("RotateImage","270");
 
+	// Frame pacing statistics for sequence acquisition (read only)
+	pAct = new CPropertyAction(this, &CFlea2::OnJitterMean);
+	CreateFloatProperty("FrameJitterMeanUs", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnJitterStd);
+	CreateFloatProperty("FrameJitterStdUs", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnJitterMax);
+	CreateFloatProperty("FrameJitterMaxUs", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnLateFrames);
+	CreateIntegerProperty("LateFrames", 0, true, pAct);
+
+	// Buffered streaming for sequence acquisition
+	pAct = new CPropertyAction(this, &CFlea2::OnGrabBuffers);
+	CreateIntegerProperty("GrabBuffers", grabBuffers_, false, pAct);
+	SetPropertyLimits("GrabBuffers", 2, 100);
+	pAct = new CPropertyAction(this, &CFlea2::OnFrameQueueDepth);
+	CreateIntegerProperty("FrameQueueDepth", queueDepth_, false, pAct);
+	SetPropertyLimits("FrameQueueDepth", 2, 256);
+	pAct = new CPropertyAction(this, &CFlea2::OnFrameQueueFill);
+	CreateIntegerProperty("FrameQueueFill", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnFrameQueueHighWater);
+	CreateIntegerProperty("FrameQueueHighWater", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnQueueDroppedFrames);
+	CreateIntegerProperty("QueueDroppedFrames", 0, true, pAct);
+
+	// Embed the camera's frame counter and timestamp in each image so that
+	// missing frames can be detected and frames timed at the camera, and
+	// the shutter so that each frame's exposure is known
+	FlyCapture2::EmbeddedImageInfo embedded;
+	pgrErr = hCam_.GetEmbeddedImageInfo( &embedded );
+	if (pgrErr == FlyCapture2::PGRERROR_OK && embedded.frameCounter.available && embedded.timestamp.available)
+	{
+		embedded.frameCounter.onOff = true;
+		embedded.timestamp.onOff = true;
+		embedded.shutter.onOff = embedded.shutter.available;
+		pgrErr = hCam_.SetEmbeddedImageInfo( &embedded );
+		embeddedInfo_ = (pgrErr == FlyCapture2::PGRERROR_OK);
+		embeddedShutter_ = embeddedInfo_ && embedded.shutter.available;
+	}
+	if (embeddedInfo_)
+	{
+		pAct = new CPropertyAction(this, &CFlea2::OnDroppedFrames);
+		CreateIntegerProperty("DroppedFrames", 0, true, pAct);
+	}
+	else
+		LogMessage("Camera can't embed frame counter and timestamp, dropped frames won't be detected");
+
+	// Sum several exposures into each delivered frame (32-bit float)
+	pAct = new CPropertyAction(this, &CFlea2::OnAccumulateFrames);
+	CreateIntegerProperty("AccumulateFrames", accumulateFrames_, false, pAct);
+	SetPropertyLimits("AccumulateFrames", 1, FrameAccumulator::MaxExactFrames);	// float output stays exact
+	pAct = new CPropertyAction(this, &CFlea2::OnAccumulateVariance);
+	CreateStringProperty("AccumulateVariance", "No", false, pAct);
+	AddAllowedValue("AccumulateVariance", "No");
+	AddAllowedValue("AccumulateVariance", "Yes");
+
+	// Dark-frame subtraction and flat-field gain, captured from the camera
+	pAct = new CPropertyAction(this, &CFlea2::OnDarkCorrection);
+	CreateStringProperty("DarkCorrection", "Off", false, pAct);
+	AddAllowedValue("DarkCorrection", "Off");
+	AddAllowedValue("DarkCorrection", "On");
+	pAct = new CPropertyAction(this, &CFlea2::OnFlatCorrection);
+	CreateStringProperty("FlatCorrection", "Off", false, pAct);
+	AddAllowedValue("FlatCorrection", "Off");
+	AddAllowedValue("FlatCorrection", "On");
+	pAct = new CPropertyAction(this, &CFlea2::OnCorrectionFrames);
+	CreateIntegerProperty("CorrectionReferenceFrames", correctionFrames_, false, pAct);
+	SetPropertyLimits("CorrectionReferenceFrames", 1, 256);
+	pAct = new CPropertyAction(this, &CFlea2::OnCorrectionDir);
+	CreateStringProperty("CorrectionReferenceDir", "", false, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnCorrectionCommand);
+	CreateStringProperty("CorrectionCommand", "Idle", false, pAct);
+	AddAllowedValue("CorrectionCommand", "Idle");
+	AddAllowedValue("CorrectionCommand", "Capture dark");
+	AddAllowedValue("CorrectionCommand", "Capture flat");
+	AddAllowedValue("CorrectionCommand", "Save references");
+	AddAllowedValue("CorrectionCommand", "Load references");
+	AddAllowedValue("CorrectionCommand", "Clear references");
+	pAct = new CPropertyAction(this, &CFlea2::OnCorrectionStatus);
+	CreateStringProperty("CorrectionStatus", "", true, pAct);
+
+	// Hot pixels are found in the dark reference and repaired from their neighbours
+	pAct = new CPropertyAction(this, &CFlea2::OnHotPixelCorrection);
+	CreateStringProperty("HotPixelCorrection", "Off", false, pAct);
+	AddAllowedValue("HotPixelCorrection", "Off");
+	AddAllowedValue("HotPixelCorrection", "On");
+	pAct = new CPropertyAction(this, &CFlea2::OnHotPixelSigma);
+	CreateFloatProperty("HotPixelSigma", hotPixelSigma_, false, pAct);
+	SetPropertyLimits("HotPixelSigma", 2, 50);
+	pAct = new CPropertyAction(this, &CFlea2::OnHotPixelCount);
+	CreateIntegerProperty("HotPixelCount", 0, true, pAct);
+
+	// Statistics of the last frame read out, also put in sequence image metadata
+	pAct = new CPropertyAction(this, &CFlea2::OnFrameStatistics);
+	CreateStringProperty("FrameStatistics", "Off", false, pAct);
+	AddAllowedValue("FrameStatistics", "Off");
+	AddAllowedValue("FrameStatistics", "On");
+	pAct = new CPropertyAction(this, &CFlea2::OnFrameHistogram);
+	CreateStringProperty("FrameHistogram", "Off", false, pAct);
+	AddAllowedValue("FrameHistogram", "Off");
+	AddAllowedValue("FrameHistogram", "On");
+	pAct = new CPropertyAction(this, &CFlea2::OnFrameMin);
+	CreateIntegerProperty("FrameMin", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnFrameMax);
+	CreateIntegerProperty("FrameMax", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnFrameMean);
+	CreateFloatProperty("FrameMean", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnFrameStdDev);
+	CreateFloatProperty("FrameStdDev", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnFrameSaturated);
+	CreateIntegerProperty("FrameSaturatedPixels", 0, true, pAct);
+
+	// Closed-loop exposure: AutoExposurePercentile of each frame is brought to
+	// AutoExposureTarget-% of full scale, within MaximumExposureMs
+	pAct = new CPropertyAction(this, &CFlea2::OnAutoExposure);
+	CreateStringProperty("AutoExposure", "Off", false, pAct);
+	AddAllowedValue("AutoExposure", "Off");
+	AddAllowedValue("AutoExposure", "On");
+	pAct = new CPropertyAction(this, &CFlea2::OnAutoExposureTarget);
+	CreateFloatProperty("AutoExposureTarget-%", autoExposure_.GetTarget()*100, false, pAct);
+	SetPropertyLimits("AutoExposureTarget-%", 5, 95);
+	pAct = new CPropertyAction(this, &CFlea2::OnAutoExposurePercentile);
+	CreateFloatProperty("AutoExposurePercentile", autoExposure_.GetPercentile(), false, pAct);
+	SetPropertyLimits("AutoExposurePercentile", 50, 100);
+	pAct = new CPropertyAction(this, &CFlea2::OnAutoExposureDamping);
+	CreateFloatProperty("AutoExposureDamping", autoExposure_.GetDamping(), false, pAct);
+	SetPropertyLimits("AutoExposureDamping", 0, 0.95);
+
+	// Host-side NxM binning on top of the camera's own; edge remainders are cropped
+	pAct = new CPropertyAction(this, &CFlea2::OnSoftwareBinX);
+	CreateIntegerProperty("SoftwareBinningX", softBinX_, false, pAct);
+	SetPropertyLimits("SoftwareBinningX", 1, 16);
+	pAct = new CPropertyAction(this, &CFlea2::OnSoftwareBinY);
+	CreateIntegerProperty("SoftwareBinningY", softBinY_, false, pAct);
+	SetPropertyLimits("SoftwareBinningY", 1, 16);
+	pAct = new CPropertyAction(this, &CFlea2::OnSoftwareBinDepth);
+	CreateStringProperty("SoftwareBinningOutput", "16bit", false, pAct);
+	AddAllowedValue("SoftwareBinningOutput", "16bit");
+	AddAllowedValue("SoftwareBinningOutput", "32bit");
+
+	// Burst capture to RAM: sequence frames are held in a preallocated ring and
+	// passed to the core after the burst, or from a background thread
+	pAct = new CPropertyAction(this, &CFlea2::OnBurstMode);
+	CreateStringProperty("BurstMode", "Off", false, pAct);
+	AddAllowedValue("BurstMode", "Off");
+	AddAllowedValue("BurstMode", "Drain after burst");
+	AddAllowedValue("BurstMode", "Drain in background");
+	pAct = new CPropertyAction(this, &CFlea2::OnBurstCapacity);
+	CreateIntegerProperty("BurstCapacity", burstCapacity_, false, pAct);
+	SetPropertyLimits("BurstCapacity", 1, 10000);
+	pAct = new CPropertyAction(this, &CFlea2::OnBurstFramesHeld);
+	CreateIntegerProperty("BurstFramesHeld", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnBurstHighWater);
+	CreateIntegerProperty("BurstHighWater", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnBurstMemoryLocked);
+	CreateStringProperty("BurstMemoryLocked", "No", true, pAct);
+
+	// Stream to disk: StreamDir/Flea2_<date>_<time>_<n>.raw holds the frames
+	// back to back, the .json beside it their size and metadata
+	pAct = new CPropertyAction(this, &CFlea2::OnStreamToDisk);
+	CreateStringProperty("StreamToDisk", "Off", false, pAct);
+	AddAllowedValue("StreamToDisk", "Off");
+	AddAllowedValue("StreamToDisk", "Disk only");
+	AddAllowedValue("StreamToDisk", "Disk and core");
+	pAct = new CPropertyAction(this, &CFlea2::OnStreamDir);
+	CreateStringProperty("StreamDir", "", false, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnStreamBuffers);
+	CreateIntegerProperty("StreamBuffers", streamBuffers_, false, pAct);
+	SetPropertyLimits("StreamBuffers", 2, 64);
+	pAct = new CPropertyAction(this, &CFlea2::OnStreamBufferSize);
+	CreateIntegerProperty("StreamBufferSize-MB", streamBufferMB_, false, pAct);
+	SetPropertyLimits("StreamBufferSize-MB", 1, 256);
+	pAct = new CPropertyAction(this, &CFlea2::OnStreamFile);
+	CreateStringProperty("StreamFile", "", true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnStreamFramesWritten);
+	CreateIntegerProperty("StreamFramesWritten", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnStreamQueueDepth);
+	CreateIntegerProperty("StreamQueueDepth", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnStreamQueueHighWater);
+	CreateIntegerProperty("StreamQueueHighWater", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnStreamThroughput);
+	CreateFloatProperty("StreamThroughput-MB/s", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnStreamDirectIO);
+	CreateStringProperty("StreamDirectIO", "No", true, pAct);
+
+	// Lossless compression of 16-bit frames before they are streamed; the
+	// benchmark runs on the last frame read out
+	pAct = new CPropertyAction(this, &CFlea2::OnStreamCompression);
+	CreateStringProperty("StreamCompression", "Off", false, pAct);
+	AddAllowedValue("StreamCompression", "Off");
+	AddAllowedValue("StreamCompression", "Lossless");
+	pAct = new CPropertyAction(this, &CFlea2::OnCompressionThreads);
+	CreateIntegerProperty("CompressionThreads", codecThreads_, false, pAct);
+	SetPropertyLimits("CompressionThreads", 0, 32);
+	pAct = new CPropertyAction(this, &CFlea2::OnStreamCompressionRatio);
+	CreateFloatProperty("StreamCompressionRatio", 0, true, pAct);
+	pAct = new CPropertyAction(this, &CFlea2::OnCompressionBenchmark);
+	CreateStringProperty("CompressionBenchmark", "Idle", false, pAct);
+	AddAllowedValue("CompressionBenchmark", "Idle");
+	AddAllowedValue("CompressionBenchmark", "Run");
+	pAct = new CPropertyAction(this, &CFlea2::OnCompressionBenchmarkResult);
+	CreateStringProperty("CompressionBenchmarkResult", "", true, pAct);
+
 	// synchronize all properties
 	// --------------------------
 	nRet = UpdateStatus();
@@ -417,6 +755,10 @@ int CFlea2::Shutdown()
 {
 	initialized_ = false;
 	StopSequenceAcquisition();
+	finishStream();
+	burst_.Release();
+	hCam_.StopCapture();
+	hCam_.Disconnect();	// leave the camera free for another instance
 
 	return DEVICE_OK;
 }
@@ -429,9 +771,34 @@ int CFlea2::Shutdown()
 */
 int CFlea2::SnapImage()
 {
-	static int callCounter = 0;
-	++callCounter;
+	if (!IsCapturing())
+	{
+		int ret = followBusPlan();
+		if (ret != DEVICE_OK)
+			return ret;
+	}
+	applyAutoExposure();
+	if (accumulateFrames_ > 1)
+	{
+		// All but the last exposure are read here, GetImageBuffer reads the last
+		MMThreadGuard g(imgPixelsLock_);
+		accumulator_.Restart();
+		for (long i = 1; i < accumulateFrames_; i++)
+		{
+			int ret = snapFrame();
+			if (ret != DEVICE_OK)
+				return ret;
+			accumulateFrame(readFrame());
+		}
+	}
+	return snapFrame();
+}
 
+/**
+* Expose one frame, returning once the exposure has ended.
+*/
+int CFlea2::snapFrame()
+{
 	MM::MMTime startTime = GetCurrentMMTime();
 	double exp = GetExposure();
 	float exp_seconds = ((float) exp)/1000;
@@ -439,15 +806,21 @@ int CFlea2::SnapImage()
 	{
 		//exp = GetSequenceExposure();
 	}
+	frameExposure_ = exp;
 
 	if (trigMode_.compare("Asynchronous-hardware") == 0)
 	{
-		return DEVICE_NOT_YET_IMPLEMENTED;
+		// The exposure starts whenever the external trigger arrives, so block
+		// until the triggered frame has been read out rather than for exp
+		int ret = retrieveTriggeredFrame( frameTimeoutMs() );
+		readoutStartTime_ = GetCurrentMMTime();
+		return ret;
 	}
 	else if (trigMode_.compare("Asynchronous-software") == 0)
 	{
-		while (!PollForTriggerReady( &hCam_ )) {}	// wait for trigger ready
-		int ret = FireSoftwareTrigger( &hCam_);
+		int ret = WaitForTriggerReady( &hCam_, 1000 + exp );
+		if (ret == DEVICE_OK)
+			ret = FireSoftwareTrigger( &hCam_);
 		if (ret != DEVICE_OK)
 			return ret;
 	}
@@ -492,6 +865,82 @@ int CFlea2::SnapImage()
 * appropriate properties are set (such as binning, pixel type, etc.)
 */
 const unsigned char* CFlea2::GetImageBuffer()
+{
+	MMThreadGuard g(imgPixelsLock_);
+	const unsigned char* pixels = readFrame();
+	if (accumulateFrames_ <= 1)
+		return pixels;
+
+	accumulateFrame(pixels);
+	return accumImg_.GetPixels();
+}
+
+/**
+* Channel 1, when accumulating with variance, is the per-pixel variance of
+* the summed exposures. It is filled by reading channel 0.
+*/
+const unsigned char* CFlea2::GetImageBuffer(unsigned channelNr)
+{
+	if (channelNr == 0 || GetNumberOfChannels() < 2)
+		return GetImageBuffer();
+
+	MMThreadGuard g(imgPixelsLock_);
+	return varianceImg_.GetPixels();
+}
+
+unsigned CFlea2::GetNumberOfChannels() const
+{
+	return (accumulateFrames_ > 1 && accumulateVariance_) ? 2 : 1;
+}
+
+int CFlea2::GetChannelName(unsigned channel, char* name)
+{
+	CDeviceUtils::CopyLimitedString(name, (channel == 1) ? "Variance" : "Sum");
+	return DEVICE_OK;
+}
+
+/**
+* Add a frame to the accumulator; once the sum is complete, convert it (and
+* the variance) to the float output buffers.
+*/
+void CFlea2::accumulateFrame(const unsigned char* pixels)
+{
+	if (img_.Depth() == 1)
+		accumReady_ = accumulator_.Add(pixels);
+	else
+		accumReady_ = accumulator_.Add((const unsigned short*) pixels);
+
+	// Autoexposure judges the whole sum, from the histograms of its exposures
+	if (autoExposureEnabled_ && !capturingReference_)
+	{
+		const std::vector<unsigned int>& hist = stats_.GetHistogram();
+		if (accumulator_.GetCount() == 1 || aeHistogram_.size() != hist.size())
+		{
+			aeHistogram_ = hist;
+			aeSumStale_ = false;
+		}
+		else
+			for (size_t i = 0; i < hist.size(); ++i)
+				aeHistogram_[i] += hist[i];
+		if (aeOldExposure_ > 0)
+			aeSumStale_ = true;
+		if (accumReady_ && !aeSumStale_)
+			updateAutoExposure(aeHistogram_);
+	}
+
+	if (accumReady_)
+	{
+		accumulator_.SumToFloat((float*) accumImg_.GetPixelsRW());
+		if (accumulator_.HasVariance())
+			accumulator_.VarianceToFloat((float*) varianceImg_.GetPixelsRW());
+	}
+}
+
+/**
+* Fetch the next frame (from the retrieval thread's queue when streaming,
+* from the driver otherwise) and decode it into img_.
+*/
+const unsigned char* CFlea2::readFrame()
 {
 	MMThreadGuard g(imgPixelsLock_);
 	FlyCapture2::Error pgrErr;
@@ -504,35 +953,142 @@ const unsigned char* CFlea2::GetImageBuffer()
 	//}
 	//while (!PGRImageReady(hCam_)) {}
 
-	//Debug
-	int dw = img_.Width();
-	int dh = img_.Height();
-	int dd = img_.Depth();
+	if (streaming_)
+	{
+		// Sequence acquisition: take the oldest frame the retrieval thread queued
+		QueuedFrame* frame = waitForQueuedFrame(frameTimeoutMs());
+		if (frame == 0)
+		{
+			LogMessage("Timed out waiting for a frame from the retrieval thread");
+			return img_.GetPixels();
+		}
+
+		FlyCapture2::Image rawImage(frame->height, frame->width, frame->stride,
+			&frame->pixels[0], frame->bytes, (FlyCapture2::PixelFormat) frame->pixelFormat);
+		decodeImage(rawImage);
+		frameCounter_ = frame->deviceFrameNumber;
+		frameTimestamp_ = frame->deviceTimestamp;
+		frameShutter_ = frame->deviceShutter;
+		frameQueue_.Pop();
+	}
+	else if (snapRetrieved_)
+	{
+		// hardware triggered snap, already decoded by SnapImage
+		snapRetrieved_ = false;
+	}
+	else
+	{
+		FlyCapture2::Image rawImage;
+		pgrErr = hCam_.RetrieveBuffer( &rawImage );
+
+		if (pgrErr != FlyCapture2::PGRERROR_OK)
+		{
+			LogMessage("Error retrieving image from camera");
+		}
+
+		decodeImage(rawImage);
+		FlyCapture2::ImageMetadata embedded = rawImage.GetMetadata();
+		frameCounter_ = embedded.embeddedFrameCounter;
+		frameTimestamp_ = embedded.embeddedTimeStamp;
+		frameShutter_ = embedded.embeddedShutter;
+	}
+
+	if (aeOldExposure_ > 0)
+	{
+		if (frameShutter_ == aeOldShutter_ && --aeInFlight_ > 0)
+			frameExposure_ = aeOldExposure_;	// exposed before the change
+		else
+			aeOldExposure_ = 0;
+	}
+
+	if ((statsEnabled_ || autoExposureEnabled_) && !frameScanned_)
+		scanFrame(0);
+	if (autoExposureEnabled_ && !capturingReference_ && accumulateFrames_ <= 1)
+		updateAutoExposure(stats_.GetHistogram());
+
+	return softBinning() ? binFrame() : img_.GetPixels();
+}
 
+/**
+* Convert a raw frame to the current pixel type and copy it into img_,
+* applying any flip/rotation on the way. Frames already in the target
+* format are used as they are, and without a transform the conversion
+* writes straight into img_, so the only buffer is convertBuf_, which is
+* sized with the image rather than per frame. The dark/flat correction is
+* applied last, fused with the copy when the frame needs no conversion; so
+* are the frame statistics, if the correction is off.
+*/
+void CFlea2::decodeImage(FlyCapture2::Image& rawImage)
+{
 	unsigned int dataSize = img_.Height()*img_.Width()*img_.Depth();
-	unsigned char *pBuf;
-	unsigned char *nBuf = new unsigned char [dataSize];
-	
-	FlyCapture2::Image rawImage;
-	FlyCapture2::Image convertedImage(nBuf, dataSize);
-	pgrErr = hCam_.RetrieveBuffer( &rawImage );
+	unsigned char *pBuf = const_cast<unsigned char*>(img_.GetPixelsRW());
+	FlyCapture2::Error pgrErr;
 
-	if (pgrErr != FlyCapture2::PGRERROR_OK)
+	if (rawImage.GetRows()*rawImage.GetCols() != img_.Height()*img_.Width())
 	{
-		LogMessage("Error retrieving image from camera");
+		LogMessage("Frame size does not match the current ROI, frame discarded");
+		return;
 	}
-	
-	if (bitDepth_ == 8)
-		pgrErr = rawImage.Convert( FlyCapture2::PIXEL_FORMAT_MONO8, &convertedImage );
-	else if (bitDepth_ == 16)
-		pgrErr = rawImage.Convert( FlyCapture2::PIXEL_FORMAT_MONO16, &convertedImage );
-	else
-		convertedImage = rawImage;
 
+	FlyCapture2::PixelFormat targetFormat = (bitDepth_ == 8) ?
+		FlyCapture2::PIXEL_FORMAT_MONO8 : FlyCapture2::PIXEL_FORMAT_MONO16;
+	bool transform = flipUD_ || flipLR_ || (imageRotationAngle_ != 0);
+	bool asIs = (rawImage.GetPixelFormat() == targetFormat)
+		&& (rawImage.GetStride() == img_.Width()*img_.Depth());
+	bool correct = !capturingReference_ && img_.Depth() == 2 && correction_.IsActive();
+	frameScanned_ = false;
+
+	unsigned char *nBuf;
+	if (rawImage.GetPixelFormat() == FlyCapture2::PIXEL_FORMAT_MONO12 && img_.Depth() == 2)
+	{
+		// packed 12 bit: our own unpack, row by row as rows may be padded.
+		// Kept right aligned to match bitDepth_ (12), which the statistics,
+		// saturation count and autoexposure go by.
+		nBuf = transform ? &convertBuf_[0] : pBuf;
+		const unsigned char* src = rawImage.GetData();
+		unsigned short* dst = (unsigned short*) nBuf;
+		for (unsigned int y = 0; y < img_.Height(); ++y)
+			Unpack12To16(src + y*rawImage.GetStride(), dst + y*img_.Width(), img_.Width());
+		if (!transform)
+		{
+			if (correct)
+				correction_.Apply(dst, dst);
+			return;
+		}
+	}
+	else if (asIs)
+	{
+		nBuf = rawImage.GetData();
+		if (!transform)
+		{
+			if (correct)
+				correction_.Apply((const unsigned short*) nBuf, (unsigned short*) pBuf);
+			else if (statsEnabled_ || autoExposureEnabled_)
+				scanFrame(nBuf);
+			else
+				memcpy(pBuf, nBuf, dataSize);
+			return;
+		}
+	}
+	else
+	{
+		// decode into the image itself unless we still have to flip/rotate
+		nBuf = transform ? &convertBuf_[0] : pBuf;
+		FlyCapture2::Image convertedImage(nBuf, dataSize);
+		pgrErr = rawImage.Convert( targetFormat, &convertedImage );
+		if (pgrErr != FlyCapture2::PGRERROR_OK)
+		{
+			LogMessage("Error converting image");
+			return;
+		}
+		if (!transform)
+		{
+			if (correct)
+				correction_.Apply((const unsigned short*) pBuf, (unsigned short*) pBuf);
+			return;
+		}
+	}
 
-	pBuf = const_cast<unsigned char*>(img_.GetPixelsRW());
-	//nBuf = (unsigned short*) nBuf;
-	
 	if (flipUD_)
 		mirrorY(img_.Width(), img_.Height(), nBuf, pBuf);
 	else if (flipLR_)
@@ -551,11 +1107,8 @@ const unsigned char* CFlea2::GetImageBuffer()
         }
     }
 
-	else
-		memcpy(pBuf, nBuf, img_.Width()*img_.Height()*img_.Depth());
-
-	delete[] nBuf;
-	return img_.GetPixels();
+	if (correct)
+		correction_.Apply((const unsigned short*) pBuf, (unsigned short*) pBuf);
 }
 
 /**
@@ -564,7 +1117,7 @@ const unsigned char* CFlea2::GetImageBuffer()
 */
 unsigned CFlea2::GetImageWidth() const
 {
-	return img_.Width();
+	return softBinning() ? binning_.GetOutputWidth() : img_.Width();
 }
 
 /**
@@ -573,7 +1126,7 @@ unsigned CFlea2::GetImageWidth() const
 */
 unsigned CFlea2::GetImageHeight() const
 {
-	return img_.Height();
+	return softBinning() ? binning_.GetOutputHeight() : img_.Height();
 }
 
 /**
@@ -582,7 +1135,7 @@ unsigned CFlea2::GetImageHeight() const
 */
 unsigned CFlea2::GetImageBytesPerPixel() const
 {
-	return img_.Depth();
+	return (accumulateFrames_ > 1 || (softBinning() && softBin32_)) ? 4 : img_.Depth();
 } 
 
 /**
@@ -602,7 +1155,7 @@ unsigned CFlea2::GetBitDepth() const
 */
 long CFlea2::GetImageBufferSize() const
 {
-	return img_.Width() * img_.Height() * GetImageBytesPerPixel();
+	return GetImageWidth() * GetImageHeight() * GetImageBytesPerPixel();
 }
 
 /**
@@ -621,6 +1174,15 @@ long CFlea2::GetImageBufferSize() const
 */
 int CFlea2::SetROI(unsigned x, unsigned y, unsigned xSize, unsigned ySize)
 {
+	// an ROI drawn on a software binned image
+	if (softBinning())
+	{
+		x *= softBinX_;
+		y *= softBinY_;
+		xSize *= softBinX_;
+		ySize *= softBinY_;
+	}
+
 	if (xSize == 0 && ySize == 0)
 	{
 		// effectively clear ROI
@@ -662,6 +1224,13 @@ int CFlea2::GetROI(unsigned& x, unsigned& y, unsigned& xSize, unsigned& ySize)
 	ySize = img_.Height();
 
 	img_.Resize(xSize,ySize);
+	if (softBinning())
+	{
+		x /= softBinX_;
+		y /= softBinY_;
+		xSize = binning_.GetOutputWidth();
+		ySize = binning_.GetOutputHeight();
+	}
 	//roiX_ = x;
 	//roiY_ = y;
 
@@ -725,49 +1294,82 @@ double CFlea2::GetSequenceExposure()
 */
 void CFlea2::SetExposure(double exp)
 {
+	if (exp == appliedExposure_ && exp == GetExposure())
+		return;
 
 	SetProperty(MM::g_Keyword_Exposure, CDeviceUtils::ConvertToString(exp));
 	GetCoreCallback()->OnExposureChanged(this, exp);
+	applyShutter(exp);
+}
 
+/**
+* Write an exposure to the camera's shutter register. The Property is
+* fetched once (switching the shutter to manual, absolute control) and
+* only its value changed afterwards, so a change costs one driver call.
+*/
+int CFlea2::applyShutter(double exp)
+{
 	FlyCapture2::Error pgrErr;
-	FlyCapture2::Property prop;
-    prop.type = FlyCapture2::SHUTTER;
-    pgrErr = hCam_.GetProperty( &prop );
-    if (pgrErr != FlyCapture2::PGRERROR_OK)
-    {
-        LogMessage("Error getting shutter property");
-    }
 
-    prop.autoManualMode = false;
-    prop.absControl = true;
+	if (exp == appliedExposure_)
+		return DEVICE_OK;
 
-    prop.absValue = (float) exp;
+	if (!shutterPropValid_)
+	{
+		shutterProp_.type = FlyCapture2::SHUTTER;
+		pgrErr = hCam_.GetProperty( &shutterProp_ );
+		if (pgrErr != FlyCapture2::PGRERROR_OK)
+		{
+			LogMessage("Error getting shutter property");
+			return DEVICE_ERR;
+		}
+		shutterProp_.autoManualMode = false;
+		shutterProp_.absControl = true;
+		shutterPropValid_ = true;
+	}
 
-    pgrErr = hCam_.SetProperty( &prop );
-    if (pgrErr != FlyCapture2::PGRERROR_OK)
-    {
-        LogMessage("Error setting shutter property");
-    }
+	shutterProp_.absValue = (float) exp;
+	pgrErr = hCam_.SetProperty( &shutterProp_ );
+	if (pgrErr != FlyCapture2::PGRERROR_OK)
+	{
+		LogMessage("Error setting shutter property");
+		appliedExposure_ = -1;
+		return DEVICE_ERR;
+	}
+	appliedExposure_ = exp;
+
+	applyGrabTimeout(exp);
+	return DEVICE_OK;
+}
+
+/**
+* Keep the RetrieveBuffer timeout at 5 s plus the exposure, rounded up to
+* whole seconds so that small exposure changes don't touch the
+* configuration. During an exposure sequence it is only ever raised.
+*/
+void CFlea2::applyGrabTimeout(double exp)
+{
+	int timeoutClass = (int) ceil(exp/1000);
+	if (timeoutClass == grabTimeoutClass_ || (sequenceRunning_ && timeoutClass < grabTimeoutClass_))
+		return;
 
-	// Set timeout for retrieve buffer to be exposure time + 5 seconds:
-	// Get the camera configuration
+	FlyCapture2::Error pgrErr;
     FlyCapture2::FC2Config config;
     pgrErr = hCam_.GetConfiguration( &config );
     if (pgrErr != FlyCapture2::PGRERROR_OK)
     {
         LogMessage( "Error getting camera configuration" );
+		return;
     } 
     
-    // Set the grab timeout to 5 seconds
-    config.grabTimeout = 5000 + ((int) 1000 * exp);
-
-    // Set the camera configuration
+    config.grabTimeout = 5000 + 1000*timeoutClass;
     pgrErr = hCam_.SetConfiguration( &config );
     if (pgrErr != FlyCapture2::PGRERROR_OK)
     {
         LogMessage( "Error setting camera configuration" );
+		return;
     } 
-
+	grabTimeoutClass_ = timeoutClass;
 }
 
 /**
@@ -835,6 +1437,13 @@ int CFlea2::StartExposureSequence()
 		return DEVICE_UNSUPPORTED_COMMAND;
 	}
 
+	// The list is known up front: set the grab timeout for its longest
+	// exposure now, so that frames only change the shutter value
+	double longest = 0;
+	for (size_t i = 0; i < exposureSequence_.size(); i++)
+		longest = std::max(longest, exposureSequence_[i]);
+	applyGrabTimeout(longest);
+
 	// may need thread lock
 	sequenceRunning_ = true;
 	return DEVICE_OK;
@@ -849,7 +1458,9 @@ int CFlea2::StopExposureSequence()
 	// may need thread lock
 	sequenceRunning_ = false;
 	sequenceIndex_ = 0;
-	return DEVICE_OK;
+
+	// back to the exposure the Exposure property shows
+	return applyShutter(GetExposure());
 }
 
 /**
@@ -937,6 +1548,10 @@ int CFlea2::StopSequenceAcquisition()
 		thd_->wait();                                                       
 	}                                                                      
 
+	// normally already done as the sequence thread exits
+	if (streaming_)
+		return stopStreaming();
+
 	return DEVICE_OK;                                                      
 } 
 
@@ -951,12 +1566,44 @@ int CFlea2::StartSequenceAcquisition(long numImages, double interval_ms, bool st
 		return DEVICE_CAMERA_BUSY_ACQUIRING;
 
 	int ret = GetCoreCallback()->PrepareForAcq(this);
+	if (ret != DEVICE_OK)
+		return ret;
+	ret = followBusPlan();
 	if (ret != DEVICE_OK)
 		return ret;
 	sequenceStartTime_ = GetCurrentMMTime();
 	imageCounter_ = 0;
+	gapDetector_.Reset();
+	accumulator_.Restart();
+	accumReady_ = false;
+	triggersPending_ = 0;
+	timestampBaseUs_ = 0;
+	lastTimestampUs_ = 0;
+	ret = startBurst(numImages);
+	if (ret != DEVICE_OK)
+		return ret;
+	ret = startStream(numImages);
+	if (ret != DEVICE_OK)
+		return ret;
+
+	// Free running with a host interval, the camera outruns the sequence
+	// thread and a queue would deliver ever older frames. Leave the driver
+	// in DROP_FRAMES and read its newest frame at each deadline instead.
+	if (trigMode_.compare("Isochronous") != 0 || interval_ms <= 0)
+	{
+		ret = startStreaming();
+		if (ret != DEVICE_OK)
+			return ret;
+	}
+	pacer_.Start(interval_ms);
+	{
+		MMThreadGuard g(pacerLock_);
+		pacingStats_ = FramePacingStats();
+	}
+	stopOnOverflow_ = stopOnOverflow;	// read by both threads
+	if (burstActive_ && burstBackground_)
+		burstDrain_->Start();
 	thd_->Start(numImages,interval_ms);
-	stopOnOverflow_ = stopOnOverflow;
 	return DEVICE_OK;
 }
 
@@ -985,13 +1632,102 @@ int CFlea2::InsertImage()
 
 	MMThreadGuard g(imgPixelsLock_);
 
+	if (streaming_ && waitForQueuedFrame(frameTimeoutMs()) == 0)
+	{
+		LogMessage("No frame received within the grab timeout");
+		if (trigMode_.compare("Asynchronous-hardware") == 0)
+			return ERR_HW_TRIGGER_TIMEOUT;
+		return DEVICE_ERR;
+	}
+
 	const unsigned char* pI;
 	pI = GetImageBuffer();
+	md.put(MM::g_Keyword_Exposure, CDeviceUtils::ConvertToString(frameExposure_));	// as corrected for frames in flight
+
+	if (embeddedInfo_)
+	{
+		// Only streamed or triggered frames should be consecutive. Paced free
+		// running reads the newest frame at each deadline and skips the rest
+		// on purpose.
+		if (streaming_ || trigMode_.compare("Isochronous") != 0)
+		{
+			long missed = gapDetector_.AddFrameCounter(frameCounter_);
+			if (missed > 0)
+				LogMessage("Frame counter jumped, " + boost::lexical_cast<std::string>(missed) + " frame(s) missing", true);
+			md.put("DroppedFrames", CDeviceUtils::ConvertToString(gapDetector_.GetDropped()));
+		}
+		md.put("CameraFrameCounter", CDeviceUtils::ConvertToString((long) frameCounter_));
+		md.put("CameraTimestamp-us", CDeviceUtils::ConvertToString(unwrapCameraTimestamp(frameTimestamp_)));
+	}
+
+	if (statsEnabled_)
+		putFrameStatistics(md);
+	if (autoExposureEnabled_)
+		md.put("AutoExposureLevel-%", CDeviceUtils::ConvertToString(autoExposure_.GetLevel()*100));
+	if (softBinning())
+	{
+		std::ostringstream os;
+		os << softBinX_ << "x" << softBinY_;
+		md.put("SoftwareBinning", os.str());
+	}
+
+	if (accumulateFrames_ <= 1)
+		return insertIntoCore(pI, md);
+
+	// Accumulating: only complete sums go to the core
+	if (!accumReady_)
+		return DEVICE_OK;
+	md.put("AccumulatedFrames", CDeviceUtils::ConvertToString(accumulateFrames_));
+	if (!accumulateVariance_)
+		return insertIntoCore(pI, md);
+
+	md.put(MM::g_Keyword_CameraChannelIndex, "0");
+	md.put(MM::g_Keyword_CameraChannelName, "Sum");
+	int ret = insertIntoCore(pI, md);
+	if (ret != DEVICE_OK)
+		return ret;
+	md.put(MM::g_Keyword_CameraChannelIndex, "1");
+	md.put(MM::g_Keyword_CameraChannelName, "Variance");
+	return insertIntoCore(varianceImg_.GetPixels(), md);
+}
 
+int CFlea2::insertIntoCore(const unsigned char* pI, Metadata& md)
+{
 	unsigned int w = GetImageWidth();
 	unsigned int h = GetImageHeight();
 	unsigned int b = GetImageBytesPerPixel();
 
+	if (streamActive_)
+	{
+		bool written;
+		if (streamPacked_)
+		{
+			size_t bytes = codec_.Compress((const unsigned short*) pI, w, h, &packed_[0]);
+			streamRawBytes_ += (double) w*h*b;
+			streamPackedBytes_ += bytes;
+			written = stream_.WriteRecord(&packed_[0], bytes, MetadataToJson(md));
+		}
+		else
+			written = stream_.Write(pI, MetadataToJson(md));
+		if (!written)
+		{
+			LogMessage("Stream to disk: " + stream_.GetError(), false);
+			return ERR_STREAM_FILE;
+		}
+		if (!streamToCore_)
+			return DEVICE_OK;
+	}
+
+	if (burstActive_)
+	{
+		if (!burst_.Push(pI, w, h, b, md.Serialize()))
+		{
+			LogMessage("Burst ring full after " + boost::lexical_cast<std::string>(burst_.Capacity()) + " frames", false);
+			return ERR_BURST_FULL;
+		}
+		return DEVICE_OK;
+	}
+
 	int ret = GetCoreCallback()->InsertImage(this, pI, w, h, b, md.Serialize().c_str());
 	if (!stopOnOverflow_ && ret == DEVICE_BUFFER_OVERFLOW)
 	{
@@ -1007,20 +1743,90 @@ int CFlea2::InsertImage()
 * Do actual capturing
 * Called from inside the thread  
 */
-int CFlea2::RunSequenceOnThread(MM::MMTime startTime)
+int CFlea2::RunSequenceOnThread(MM::MMTime /*startTime*/)
+{
+	// When accumulating, one delivered image takes several exposures, all
+	// at the same exposure time
+	applyAutoExposure();
+	int ret;
+	do
+	{
+		ret = runSequenceFrame();
+	} while (ret == DEVICE_OK && accumulateFrames_ > 1 && !accumReady_ && !thd_->IsStopped());
+	return ret;
+}
+
+/*
+* Trigger and read one frame of a sequence
+*/
+int CFlea2::runSequenceFrame()
 {
 	int ret=DEVICE_ERR;
 
+	// Take this frame's exposure exactly once - GetSequenceExposure() advances
+	// the sequence index every time it is called.
+	// Straight to the shutter register: the Exposure property keeps the
+	// value the sequence was started with
+	frameExposure_ = GetExposure();
+	if (sequenceRunning_)
+	{
+		frameExposure_ = GetSequenceExposure();
+		ret = applyShutter(frameExposure_);
+		if (ret != DEVICE_OK)
+			return ret;
+	}
+
+	double readyTimeoutMs = 1000 + frameExposure_;
+
+	if (trigMode_.compare("Asynchronous-software") == 0 && triggersPending_ > 0)
+	{
+		// This frame's trigger went out last time round; nothing to wait for
+	}
+	else if (trigMode_.compare("Asynchronous-hardware") == 0)
+	{
+		// Paced by the external trigger, not by us
+	}
+	else
+	{
+		// Hold off until this frame's absolute deadline (no-op for interval 0)
+		pacer_.WaitForNextFrame();
+		{
+			MMThreadGuard g(pacerLock_);
+			pacingStats_ = pacer_.GetStats();
+		}
+	}
+
 	if (trigMode_.compare("Asynchronous-hardware") == 0)
 	{
-		return DEVICE_NOT_YET_IMPLEMENTED;
+		// The retrieval thread queues frames as the triggers arrive;
+		// InsertImage waits up to the hardware trigger timeout for the next
 	}
 	else if (trigMode_.compare("Asynchronous-software") == 0)
 	{
-		while (!PollForTriggerReady( &hCam_ )) {}	// wait for trigger ready
-		int ret = FireSoftwareTrigger( &hCam_);
-		if (ret != DEVICE_OK)
-			return ret;
+		if (triggersPending_ == 0)
+		{
+			ret = WaitForTriggerReady( &hCam_, readyTimeoutMs );
+			if (ret == DEVICE_OK)
+				ret = FireSoftwareTrigger( &hCam_);
+			if (ret != DEVICE_OK)
+				return ret;
+			++triggersPending_;
+		}
+
+		// Pipelining: when running flat out, trigger the next frame as soon as
+		// the camera can take it, so its exposure overlaps this frame's transfer.
+		// Not with an exposure sequence, which must be set before each trigger.
+		bool moreFrames = thd_->GetImageCounter() + 1 < thd_->GetLength()
+			|| accumulator_.GetCount() + 1 < accumulator_.GetFrames();
+		if (moreFrames && pacer_.GetIntervalMs() <= 0 && !sequenceRunning_)
+		{
+			ret = WaitForTriggerReady( &hCam_, readyTimeoutMs );
+			if (ret == DEVICE_OK)
+				ret = FireSoftwareTrigger( &hCam_);
+			if (ret != DEVICE_OK)
+				return ret;
+			++triggersPending_;
+		}
 	}
 	else if (trigMode_.compare("Isochronous") == 0)
 	{
@@ -1029,14 +1835,10 @@ int CFlea2::RunSequenceOnThread(MM::MMTime startTime)
 	
 
 	ret = InsertImage();
+	if (triggersPending_ > 0)
+		--triggersPending_;
 
-
-	while (((double) (this->GetCurrentMMTime() - startTime).getMsec() / imageCounter_) < this->GetSequenceExposure())
-	{
-		CDeviceUtils::SleepMs(1);
-	}
-
-	if (ret != DEVICE_OK)
+	if (ret != DEVICE_OK)
 	{
 		return ret;
 	}
@@ -1055,6 +1857,7 @@ void CFlea2::OnThreadExiting() throw()
 	try
 	{
 		LogMessage(g_Msg_SEQUENCE_ACQUISITION_THREAD_EXITING);
+		stopStreaming();
 		GetCoreCallback()?GetCoreCallback()->AcqFinished(this,0):DEVICE_OK;
 	}
 	catch(...)
@@ -1128,6 +1931,8 @@ int MySequenceThread::svc(void) throw()
 		} while (DEVICE_OK == ret && !IsStopped() && imageCounter_++ < numImages_-1);
 		if (IsStopped())
 			camera_->LogMessage("SeqAcquisition interrupted by the user\n");
+		camera_->finishBurst();	// hand over whatever is still held in RAM
+		camera_->finishStream();
 	}catch(...){
 		camera_->LogMessage(g_Msg_EXCEPTION_IN_THREAD, false);
 	}
@@ -1138,6 +1943,166 @@ int MySequenceThread::svc(void) throw()
 }
 
 
+BurstDrainThread::BurstDrainThread(CFlea2* pCam)
+	:camera_(pCam)
+	,stop_(true)
+{};
+
+BurstDrainThread::~BurstDrainThread()
+{
+	Stop();
+};
+
+void BurstDrainThread::Start()
+{
+	MMThreadGuard g(this->stopLock_);
+	if (!stop_)
+		return;
+	stop_ = false;
+	activate();
+}
+
+/**
+* Stop and wait for the thread to exit. Frames still in the ring are left
+* there for the sequence thread to pass on.
+*/
+void BurstDrainThread::Stop()
+{
+	{
+		MMThreadGuard g(this->stopLock_);
+		if (stop_)
+			return;
+		stop_ = true;
+	}
+	wait();
+}
+
+bool BurstDrainThread::IsStopped()
+{
+	MMThreadGuard g(this->stopLock_);
+	return stop_;
+}
+
+int BurstDrainThread::svc(void) throw()
+{
+	try
+	{
+		while (!IsStopped())
+		{
+			if (!camera_->drainBurstFrame())
+				CDeviceUtils::SleepMs(default_idleMS);
+		}
+	}catch(...){
+		camera_->LogMessage("Exception in burst drain thread", false);
+	}
+	return 0;
+}
+
+
+RetrievalThread::RetrievalThread(CFlea2* pCam)
+	:camera_(pCam)
+	,stop_(true)
+	,running_(false)
+{};
+
+RetrievalThread::~RetrievalThread() {};
+
+void RetrievalThread::Start()
+{
+	MMThreadGuard g(this->stopLock_);
+	stop_ = false;
+	running_ = true;
+	activate();
+}
+
+/**
+* Stop and wait for the thread to exit. Stopping capture makes a pending
+* RetrieveBuffer return straight away rather than after the grab timeout.
+* The thread may already have stopped itself on a camera error, but it
+* still has to be joined.
+*/
+void RetrievalThread::Stop()
+{
+	{
+		MMThreadGuard g(this->stopLock_);
+		if (!running_)
+			return;
+		running_ = false;
+		stop_ = true;
+	}
+	camera_->hCam_.StopCapture();
+	wait();
+}
+
+bool RetrievalThread::IsStopped()
+{
+	MMThreadGuard g(this->stopLock_);
+	return stop_;
+}
+
+int RetrievalThread::svc(void) throw()
+{
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+
+	FlyCapture2::Image rawImage;
+	FlyCapture2::Error pgrErr;
+	unsigned long frameNumber = 0;
+	try
+	{
+		while (!IsStopped())
+		{
+			pgrErr = camera_->hCam_.RetrieveBuffer( &rawImage );
+			if (pgrErr == FlyCapture2::PGRERROR_TIMEOUT)
+				continue;
+			if (pgrErr == FlyCapture2::PGRERROR_IMAGE_CONSISTENCY_ERROR)
+			{
+				// A damaged frame (e.g. skipped isochronous packets): lose it, keep going
+				++frameNumber;
+				InterlockedIncrement(&camera_->queueDropped_);
+				continue;
+			}
+			if (pgrErr != FlyCapture2::PGRERROR_OK)
+			{
+				if (!IsStopped())
+					camera_->LogMessage( (std::string) "Retrieval thread: " + pgrErr.GetDescription() );
+				MMThreadGuard g(this->stopLock_);
+				stop_ = true;	//the consumer sees this and stops waiting for frames
+				break;
+			}
+
+			++frameNumber;
+			QueuedFrame* frame = camera_->frameQueue_.BeginPush();
+			if (frame == 0)
+			{
+				InterlockedIncrement(&camera_->queueDropped_);
+				continue;
+			}
+
+			unsigned int bytes = rawImage.GetDataSize();
+			if (frame->pixels.size() < bytes)
+				frame->pixels.resize(bytes);
+			memcpy(&frame->pixels[0], rawImage.GetData(), bytes);
+			frame->bytes = bytes;
+			frame->width = rawImage.GetCols();
+			frame->height = rawImage.GetRows();
+			frame->stride = rawImage.GetStride();
+			frame->pixelFormat = (int) rawImage.GetPixelFormat();
+			frame->timestampUs = MonotonicClock::NowUs();
+			frame->frameNumber = frameNumber;
+			FlyCapture2::ImageMetadata embedded = rawImage.GetMetadata();
+			frame->deviceFrameNumber = embedded.embeddedFrameCounter;
+			frame->deviceTimestamp = embedded.embeddedTimeStamp;
+			frame->deviceShutter = embedded.embeddedShutter;
+			camera_->frameQueue_.Push();
+			SetEvent(camera_->frameEvent_);
+		}
+	}catch(...){
+		camera_->LogMessage("Exception in retrieval thread", false);
+	}
+	SetEvent(camera_->frameEvent_);	//wake the consumer so it sees we have gone
+	return 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // CFlea2 Action handlers
 ///////////////////////////////////////////////////////////////////////////////
@@ -1507,6 +2472,8 @@ int CFlea2::OnFlipUD(MM::PropertyBase* pProp, MM::ActionType eAct)
       long tvalue = 0;
       pProp->Get(tvalue);
 		flipUD_ = (0==tvalue)?false:true;
+		MMThreadGuard g(imgPixelsLock_);
+		selectCorrection();
    }
    else if (eAct == MM::BeforeGet)
    {
@@ -1523,6 +2490,8 @@ int CFlea2::OnFlipLR(MM::PropertyBase* pProp, MM::ActionType eAct)
       long tvalue = 0;
       pProp->Get(tvalue);
 		flipLR_ = (0==tvalue)?false:true;
+		MMThreadGuard g(imgPixelsLock_);
+		selectCorrection();
    }
    else if (eAct == MM::BeforeGet)
    {
@@ -1570,119 +2539,1404 @@ int CFlea2::OnGain(MM::PropertyBase* pProp, MM::ActionType eAct)
 	return DEVICE_OK;
 }
 
+int CFlea2::OnJitterMean(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(pacerLock_);
+		pProp->Set(pacingStats_.meanJitterUs);
+	}
+
+	return DEVICE_OK;
+}
 
-int CFlea2::ResizeImageBuffer()
+int CFlea2::OnJitterStd(MM::PropertyBase* pProp, MM::ActionType eAct)
 {
-	char buf[MM::MaxStrLength];
-	//int ret = GetProperty(MM::g_Keyword_Binning, buf);
-	//if (ret != DEVICE_OK)
-	//   return ret;
-	//binSizeX_ = atol(buf);
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(pacerLock_);
+		pProp->Set(pacingStats_.stdJitterUs);
+	}
 
-	int ret = GetProperty(MM::g_Keyword_PixelType, buf);
-	if (ret != DEVICE_OK)
-		return ret;
+	return DEVICE_OK;
+}
 
-	std::string pixelType(buf);
-	int byteDepth = 0;
+int CFlea2::OnJitterMax(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(pacerLock_);
+		pProp->Set(pacingStats_.maxJitterUs);
+	}
 
-	if (pixelType.compare(g_PixelType_8bit) == 0)
+	return DEVICE_OK;
+}
+
+int CFlea2::OnLateFrames(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
 	{
-		byteDepth = 1;
+		MMThreadGuard g(pacerLock_);
+		pProp->Set(pacingStats_.lateFrames);
 	}
-	else if (pixelType.compare(g_PixelType_16bit) == 0)
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnGrabBuffers(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
 	{
-		byteDepth = 2;
+		pProp->Set(grabBuffers_);
 	}
-	else if ( pixelType.compare(g_PixelType_32bitRGB) == 0)
+	else if (eAct == MM::AfterSet)
 	{
-		byteDepth = 4;
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		pProp->Get(grabBuffers_);
 	}
-	else if ( pixelType.compare(g_PixelType_32bit) == 0)
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnFrameQueueDepth(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
 	{
-		byteDepth = 4;
+		pProp->Set(queueDepth_);
 	}
-	else if ( pixelType.compare(g_PixelType_64bitRGB) == 0)
+	else if (eAct == MM::AfterSet)
 	{
-		byteDepth = 8;
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		pProp->Get(queueDepth_);
 	}
 
-    if ((imageRotationAngle_ == 90) || (imageRotationAngle_ == 270))
-        img_.Resize(cameraCCDYSize_/binSizeY_, cameraCCDXSize_/binSizeX_, byteDepth);
-    else
-		//img_.Resize(roiW_/binSizeX_, roiH_/binSizeY_, byteDepth);
-		img_.Resize(roiW_, roiH_, byteDepth);
+	return DEVICE_OK;
+}
 
+int CFlea2::OnHardwareTriggerTimeout(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(hwTriggerTimeoutMs_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		pProp->Get(hwTriggerTimeoutMs_);
+	}
 
 	return DEVICE_OK;
 }
 
-void CFlea2::GenerateEmptyImage(ImgBuffer& img)
+int CFlea2::OnTargetFrameRate(MM::PropertyBase* pProp, MM::ActionType eAct)
 {
-	MMThreadGuard g(imgPixelsLock_);
-	if (img.Height() == 0 || img.Width() == 0 || img.Depth() == 0)
-		return;
-	unsigned char* pBuf = const_cast<unsigned char*>(img.GetPixels());
-	memset(pBuf, 0, img.Height()*img.Width()*img.Depth());
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(targetFps_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		double fps;
+		pProp->Get(fps);
+		if (fps < 0)
+			return DEVICE_INVALID_PROPERTY_VALUE;
+		targetFps_ = fps;
+		return applyPacketSize();
+	}
+
+	return DEVICE_OK;
 }
 
-void CFlea2::TestResourceLocking(const bool recurse)
+int CFlea2::OnBytesPerPacket(MM::PropertyBase* pProp, MM::ActionType eAct)
 {
-	if(recurse)
-		TestResourceLocking(false);
-}
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) packetBytes_);
+	}
 
-void CFlea2::rotate90(int original_xsize, int original_ysize, unsigned char *in_arr, unsigned char *out_arr){
+	return DEVICE_OK;
+}
 
-	int xsize = original_ysize;
-	int ysize = original_xsize;	//swapped here for clairty...
-	for (int y = 0; y < ysize; ++y){
-		for (int x = 0, destx = xsize-1; x<xsize; ++x, --destx){
-			out_arr[y * xsize + destx] = in_arr[x * ysize + y];
-		}
+/**
+* Frame rate the current packet size and exposure allow, whichever is lower.
+*/
+int CFlea2::OnAchievableFrameRate(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		double fps = BandwidthPlanner::FrameRateFor(packetBytes_, bytesPerFrame());
+		double exp = GetExposure();
+		if (exp > 0 && 1000/exp < fps)
+			fps = 1000/exp;
+		pProp->Set(fps);
 	}
-}
 
-void CFlea2::rotate180(int original_xsize, int original_ysize, unsigned char *in_arr, unsigned char *out_arr){
+	return DEVICE_OK;
+}
 
-	for (int i = 0; i < original_xsize*original_ysize; ++i){
-		out_arr[original_xsize*original_ysize - 1 -i] = in_arr[i];
+int CFlea2::OnAccumulateFrames(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(accumulateFrames_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		long frames;
+		pProp->Get(frames);
+		if (frames > 1 && softBin32_ && binning_.IsActive())
+			return ERR_BINNING_ACCUMULATE;
+		accumulateFrames_ = frames;
+		return ResizeImageBuffer();
 	}
-}
 
-void CFlea2::rotate270(int original_xsize, int original_ysize, unsigned char *in_arr, unsigned char *out_arr){
+	return DEVICE_OK;
+}
 
-	int xsize = original_ysize;
-	int ysize = original_xsize;	//swapped here for clairty...
-	for (int x = 0; x < xsize; ++x){
-		for (int y = 0, desty = ysize-1; y<ysize; ++y, --desty){
-			out_arr[x + desty*xsize] = in_arr[x * ysize + y];
-		}
+int CFlea2::OnAccumulateVariance(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(accumulateVariance_ ? "Yes" : "No");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		std::string val;
+		pProp->Get(val);
+		accumulateVariance_ = (val == "Yes");
+		return ResizeImageBuffer();
 	}
-}
 
-void CFlea2::mirrorY(int original_xsize, int original_ysize, unsigned char *in_arr, unsigned char *out_arr){
+	return DEVICE_OK;
+}
 
-	for (int x = 0; x < original_xsize; ++x){
-		for (int y = 0, desty = original_ysize - 1; y < original_ysize; ++y, --desty){
-			out_arr[desty * original_xsize + x] = in_arr[y * original_xsize + x];
-		}
+int CFlea2::OnDarkCorrection(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(correction_.IsDarkEnabled() ? "On" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		MMThreadGuard g(imgPixelsLock_);
+		correction_.EnableDark(val == "On");
 	}
-}
 
-void CFlea2::mirrorX(int original_xsize, int original_ysize, unsigned char *in_arr, unsigned char *out_arr){
+	return DEVICE_OK;
+}
 
-	for (int y = 0; y < original_ysize; ++y){
-		for (int x = 0, destx = original_xsize - 1; x < original_xsize; ++x, --destx){
-			out_arr[y * original_xsize + destx] = in_arr[y * original_xsize + x];
-		}
+int CFlea2::OnFlatCorrection(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(correction_.IsFlatEnabled() ? "On" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		MMThreadGuard g(imgPixelsLock_);
+		correction_.EnableFlat(val == "On");
 	}
-}
 
+	return DEVICE_OK;
+}
 
-double CFlea2::roundUp(double numToRound, double toMultipleOf) 
-{ 
-	if(toMultipleOf == 0) 
+int CFlea2::OnCorrectionFrames(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(correctionFrames_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		pProp->Get(correctionFrames_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnCorrectionDir(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(correctionDir_.c_str());
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		pProp->Get(correctionDir_);
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Capture the dark (shutter closed) or flat (uniform illumination) reference
+* for the current binning/ROI, or save, load or clear the references. The
+* dark is taken off the flat, so capture the dark first.
+*/
+int CFlea2::OnCorrectionCommand(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set("Idle");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		int ret = DEVICE_OK;
+		if (val == "Capture dark")
+			ret = captureReference(true);
+		else if (val == "Capture flat")
+			ret = captureReference(false);
+		else if (val == "Save references" || val == "Load references")
+		{
+			if (correctionDir_.empty())
+				return ERR_CORRECTION_FILE;
+			MMThreadGuard g(imgPixelsLock_);
+			bool ok = (val == "Save references") ? correction_.Save(correctionFile()) : correction_.Load(correctionFile());
+			if (!ok)
+				ret = ERR_CORRECTION_FILE;
+		}
+		else if (val == "Clear references")
+		{
+			MMThreadGuard g(imgPixelsLock_);
+			correction_.ClearDark();
+			correction_.ClearFlat();
+			correction_.ClearHotPixels();
+		}
+		pProp->Set("Idle");
+		return ret;
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnHotPixelCorrection(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(correction_.IsHotPixelEnabled() ? "On" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		MMThreadGuard g(imgPixelsLock_);
+		correction_.EnableHotPixels(val == "On");
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Takes effect with the next dark capture
+*/
+int CFlea2::OnHotPixelSigma(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(hotPixelSigma_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		pProp->Get(hotPixelSigma_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnHotPixelCount(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) correction_.GetHotPixelCount());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnFrameStatistics(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(statsEnabled_ ? "On" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		MMThreadGuard g(imgPixelsLock_);
+		statsEnabled_ = (val == "On");
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnFrameHistogram(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(histogramEnabled_ ? "On" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		MMThreadGuard g(imgPixelsLock_);
+		histogramEnabled_ = (val == "On");
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnAutoExposure(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(autoExposureEnabled_ ? "On" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		MMThreadGuard g(imgPixelsLock_);
+		autoExposureEnabled_ = (val == "On");
+		autoExposurePending_ = 0;
+		aeOldExposure_ = 0;
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnAutoExposureTarget(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(autoExposure_.GetTarget()*100);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		double target;
+		pProp->Get(target);
+		autoExposure_.SetTarget(target/100);
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnAutoExposurePercentile(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(autoExposure_.GetPercentile());
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		double percentile;
+		pProp->Get(percentile);
+		autoExposure_.SetPercentile(percentile);
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Fraction of each correction (in log exposure) held back: 0 jumps straight
+* to the estimate, 0.9 moves a tenth of the way per frame
+*/
+int CFlea2::OnAutoExposureDamping(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(autoExposure_.GetDamping());
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		double damping;
+		pProp->Get(damping);
+		autoExposure_.SetDamping(damping);
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnSoftwareBinX(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(softBinX_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		long bin;
+		pProp->Get(bin);
+		if (bin > 1 && softBin32_ && accumulateFrames_ > 1)
+			return ERR_BINNING_ACCUMULATE;
+		softBinX_ = bin;
+		return ResizeImageBuffer();
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnSoftwareBinY(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(softBinY_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		long bin;
+		pProp->Get(bin);
+		if (bin > 1 && softBin32_ && accumulateFrames_ > 1)
+			return ERR_BINNING_ACCUMULATE;
+		softBinY_ = bin;
+		return ResizeImageBuffer();
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* 16bit clips the sums at 65535; 32bit gives exact sums as float pixels
+*/
+int CFlea2::OnSoftwareBinDepth(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(softBin32_ ? "32bit" : "16bit");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		std::string val;
+		pProp->Get(val);
+		if (val == "32bit" && accumulateFrames_ > 1 && binning_.IsActive())
+			return ERR_BINNING_ACCUMULATE;
+		softBin32_ = (val == "32bit");
+		return ResizeImageBuffer();
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Burst frames go to the core after the sequence ends ("Drain after burst"),
+* or as fast as the core takes them while it runs ("Drain in background")
+*/
+int CFlea2::OnBurstMode(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		if (!burstEnabled_)
+			pProp->Set("Off");
+		else
+			pProp->Set(burstBackground_ ? "Drain in background" : "Drain after burst");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		std::string val;
+		pProp->Get(val);
+		burstEnabled_ = (val != "Off");
+		burstBackground_ = (val == "Drain in background");
+		if (!burstEnabled_)
+			burst_.Release();	// give the memory back
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnBurstCapacity(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(burstCapacity_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		pProp->Get(burstCapacity_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnBurstFramesHeld(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) burst_.Size());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnBurstHighWater(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) burst_.HighWater());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnBurstMemoryLocked(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(burst_.IsLocked() ? "Yes" : "No");
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* "Disk only" keeps sequence frames out of the core altogether, so nothing
+* will be seen (or saved) by the application while it runs
+*/
+int CFlea2::OnStreamToDisk(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		if (!streamEnabled_)
+			pProp->Set("Off");
+		else
+			pProp->Set(streamToCore_ ? "Disk and core" : "Disk only");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		std::string val;
+		pProp->Get(val);
+		streamEnabled_ = (val != "Off");
+		streamToCore_ = (val == "Disk and core");
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnStreamDir(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(streamDir_.c_str());
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		pProp->Get(streamDir_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnStreamBuffers(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(streamBuffers_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		pProp->Get(streamBuffers_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnStreamBufferSize(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(streamBufferMB_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		pProp->Get(streamBufferMB_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnStreamFile(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(stream_.GetRawPath().c_str());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnStreamFramesWritten(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) stream_.GetFramesWritten());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnStreamQueueDepth(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) stream_.GetQueueDepth());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnStreamQueueHighWater(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) stream_.GetMaxQueueDepth());
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Rate of the writes themselves, i.e. what the disk sustains, not the rate
+* at which the camera produces frames
+*/
+int CFlea2::OnStreamThroughput(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(stream_.GetThroughputMBps());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnStreamDirectIO(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(stream_.IsDirect() ? "Yes" : "No");
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Streamed 16-bit frames are coded with FrameCodec; the records in the raw
+* file are then FrameCodec::Decompress input
+*/
+int CFlea2::OnStreamCompression(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(streamCompress_ ? "Lossless" : "Off");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		std::string val;
+		pProp->Get(val);
+		streamCompress_ = (val == "Lossless");
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnCompressionThreads(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(codecThreads_);
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+		pProp->Get(codecThreads_);
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnStreamCompressionRatio(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		pProp->Set((streamPackedBytes_ > 0) ? streamRawBytes_/streamPackedBytes_ : 0.0);
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnCompressionBenchmark(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set("Idle");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		if (val.compare("Run") != 0)
+			return DEVICE_OK;
+		if (IsCapturing())
+			return DEVICE_CAMERA_BUSY_ACQUIRING;
+
+		MMThreadGuard g(imgPixelsLock_);
+		if (img_.Depth() != 2)
+		{
+			codecBenchmark_ = "needs 16-bit pixels";
+		}
+		else
+		{
+			codec_.SetThreads((unsigned int) codecThreads_);
+			FrameCodecBenchmark result = BenchmarkFrameCodec(codec_, (const unsigned short*) img_.GetPixels(),
+				img_.Width(), img_.Height(), 10);
+
+			std::ostringstream os;
+			os.setf(std::ios::fixed);
+			os.precision(2);
+			os << "ratio " << result.ratio;
+			os.precision(0);
+			os << ", compress " << result.compressMBps << " MB/s, decompress " << result.decompressMBps << " MB/s, "
+				<< codec_.GetThreads() << (CodecHasSimd() ? " SSE2" : "") << " thread(s), "
+				<< (result.lossless ? "lossless" : "MISMATCH") << " (" << img_.Width() << "x" << img_.Height() << ")";
+			codecBenchmark_ = os.str();
+		}
+		LogMessage("Compression benchmark: " + codecBenchmark_, false);
+		pProp->Set("Idle");
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnCompressionBenchmarkResult(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(codecBenchmark_.c_str());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnFrameMin(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		pProp->Set((long) stats_.GetMin());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnFrameMax(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		pProp->Set((long) stats_.GetMax());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnFrameMean(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		pProp->Set(stats_.GetMean());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnFrameStdDev(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		pProp->Set(stats_.GetStdDev());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnFrameSaturated(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		pProp->Set((long) stats_.GetSaturated());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnCorrectionStatus(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		std::ostringstream os;
+		os << "dark " << (correction_.HasDark() ? "captured" : "none")
+			<< ", flat " << (correction_.HasFlat() ? "captured" : "none")
+			<< ", " << correction_.GetHotPixelCount() << " hot pixels"
+			<< " (" << correction_.GetKey() << ")";
+		pProp->Set(os.str().c_str());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnFrameQueueFill(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) frameQueue_.Size());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnFrameQueueHighWater(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) frameQueue_.HighWater());
+	}
+
+	return DEVICE_OK;
+}
+
+/**
+* Setting "Run" times the scalar and vector 12-bit unpack kernels on a frame
+* of the current ROI size and puts the result in Unpack12BenchmarkResult.
+*/
+int CFlea2::OnUnpackBenchmark(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set("Idle");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		std::string val;
+		pProp->Get(val);
+		if (val.compare("Run") != 0)
+			return DEVICE_OK;
+
+		double scalarMpix, simdMpix;
+		BenchmarkUnpack12(roiW_*roiH_, 20, scalarMpix, simdMpix);
+
+		std::ostringstream os;
+		os.setf(std::ios::fixed);
+		os.precision(0);
+		os << "scalar " << scalarMpix << " Mpix/s, " << (Unpack12HasSimd() ? "SSSE3 " : "scalar ")
+			<< simdMpix << " Mpix/s (" << roiW_ << "x" << roiH_ << ")";
+		unpackBenchmark_ = os.str();
+		LogMessage("Unpack12 benchmark: " + unpackBenchmark_, false);
+		pProp->Set("Idle");
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnUnpackBenchmarkResult(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(unpackBenchmark_.c_str());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnDroppedFrames(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(gapDetector_.GetDropped());
+	}
+
+	return DEVICE_OK;
+}
+
+int CFlea2::OnQueueDroppedFrames(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set((long) queueDropped_);
+	}
+
+	return DEVICE_OK;
+}
+
+
+int CFlea2::ResizeImageBuffer()
+{
+	char buf[MM::MaxStrLength];
+	//int ret = GetProperty(MM::g_Keyword_Binning, buf);
+	//if (ret != DEVICE_OK)
+	//   return ret;
+	//binSizeX_ = atol(buf);
+
+	int ret = GetProperty(MM::g_Keyword_PixelType, buf);
+	if (ret != DEVICE_OK)
+		return ret;
+
+	std::string pixelType(buf);
+	int byteDepth = 0;
+
+	if (pixelType.compare(g_PixelType_8bit) == 0)
+	{
+		byteDepth = 1;
+	}
+	else if (pixelType.compare(g_PixelType_16bit) == 0)
+	{
+		byteDepth = 2;
+	}
+	else if ( pixelType.compare(g_PixelType_32bitRGB) == 0)
+	{
+		byteDepth = 4;
+	}
+	else if ( pixelType.compare(g_PixelType_32bit) == 0)
+	{
+		byteDepth = 4;
+	}
+	else if ( pixelType.compare(g_PixelType_64bitRGB) == 0)
+	{
+		byteDepth = 8;
+	}
+
+    if ((imageRotationAngle_ == 90) || (imageRotationAngle_ == 270))
+        img_.Resize(cameraCCDYSize_/binSizeY_, cameraCCDXSize_/binSizeX_, byteDepth);
+    else
+		//img_.Resize(roiW_/binSizeX_, roiH_/binSizeY_, byteDepth);
+		img_.Resize(roiW_, roiH_, byteDepth);
+
+	// scratch for frames that need converting before a flip/rotation
+	{
+		MMThreadGuard g(imgPixelsLock_);
+		convertBuf_.resize(img_.Width()*img_.Height()*img_.Depth());
+
+		binning_.Configure(img_.Width(), img_.Height(), softBinX_, softBinY_);
+		binImg_.Resize(std::max(1u, binning_.GetOutputWidth()), std::max(1u, binning_.GetOutputHeight()), softBin32_ ? 4 : 2);
+
+		// 32-bit float output of the accumulator
+		if (accumulateFrames_ > 1)
+		{
+			accumImg_.Resize(GetImageWidth(), GetImageHeight(), 4);
+			varianceImg_.Resize(accumulateVariance_ ? GetImageWidth() : 1, accumulateVariance_ ? GetImageHeight() : 1, 4);
+			accumulator_.Start(GetImageWidth()*GetImageHeight(), accumulateFrames_, accumulateVariance_);
+		}
+		else
+			accumulator_.Start(0, 1, false);
+		accumReady_ = false;
+
+		selectCorrection();
+	}
+
+
+	return DEVICE_OK;
+}
+
+/**
+* Readout geometry the correction references belong to
+*/
+std::string CFlea2::correctionKey() const
+{
+	std::ostringstream os;
+	os << "bin" << binSizeX_ << "x" << binSizeY_ << "_roi" << roiX_ << "-" << roiY_ << "-"
+		<< img_.Width() << "x" << img_.Height() << "_rot" << imageRotationAngle_
+		<< (flipUD_ ? "_ud" : "") << (flipLR_ ? "_lr" : "");
+	return os.str();
+}
+
+std::string CFlea2::correctionFile() const
+{
+	return correctionDir_ + "/Flea2_" + correctionKey() + ".ffc";
+}
+
+/**
+* Switch the correction to the references of the current geometry, loading
+* them from CorrectionReferenceDir if none are held yet
+*/
+void CFlea2::selectCorrection()
+{
+	correction_.Select(correctionKey(), img_.Width(), img_.Height());
+	if (!correctionDir_.empty() && !correction_.HasDark() && !correction_.HasFlat())
+		correction_.Load(correctionFile());
+}
+
+/**
+* Average CorrectionReferenceFrames uncorrected frames into the dark or the
+* flat reference for the current geometry. The dark also gives the hot pixels.
+*/
+int CFlea2::captureReference(bool dark)
+{
+	if (IsCapturing())
+		return DEVICE_CAMERA_BUSY_ACQUIRING;
+	if (img_.Depth() != 2)
+		return ERR_CORRECTION_PIXELTYPE;
+
+	capturingReference_ = true;
+	correction_.BeginReference(correctionFrames_);
+	int ret = DEVICE_OK;
+	for (long i = 0; i < correctionFrames_ && ret == DEVICE_OK; i++)
+	{
+		ret = snapFrame();
+		if (ret == DEVICE_OK)
+		{
+			readFrame();
+			correction_.AddReference((const unsigned short*) img_.GetPixels());
+		}
+	}
+	capturingReference_ = false;
+	if (ret != DEVICE_OK)
+		return ret;
+
+	if (dark)
+	{
+		correction_.SetDarkFromReference();
+		correction_.DetectHotPixels(hotPixelSigma_);
+		std::ostringstream os;
+		os << correction_.GetHotPixelCount() << " hot pixels above " << hotPixelSigma_ << " sigma";
+		LogMessage(os.str(), false);
+	}
+	else
+		correction_.SetFlatFromReference();
+	return DEVICE_OK;
+}
+
+/**
+* Take the statistics of img_, copying src into it on the way unless src
+* is null
+*/
+void CFlea2::scanFrame(const unsigned char* src)
+{
+	unsigned char* pBuf = const_cast<unsigned char*>(img_.GetPixelsRW());
+	size_t n = img_.Width()*img_.Height();
+	stats_.SetBitDepth(bitDepth_);
+	stats_.EnableHistogram(histogramEnabled_ || autoExposureEnabled_);
+	if (img_.Depth() == 2)
+		stats_.Process((const unsigned short*) (src ? src : pBuf), src ? (unsigned short*) pBuf : 0, n);
+	else if (img_.Depth() == 1)
+		stats_.Process(src ? src : pBuf, src ? pBuf : 0, n);
+	else if (src)
+		memcpy(pBuf, src, n*img_.Depth());
+	frameScanned_ = true;
+}
+
+void CFlea2::putFrameStatistics(Metadata& md)
+{
+	md.put("FrameMin", CDeviceUtils::ConvertToString((long) stats_.GetMin()));
+	md.put("FrameMax", CDeviceUtils::ConvertToString((long) stats_.GetMax()));
+	md.put("FrameSum", CDeviceUtils::ConvertToString(stats_.GetSum()));
+	md.put("FrameSumSq", CDeviceUtils::ConvertToString(stats_.GetSumSq()));
+	md.put("FrameMean", CDeviceUtils::ConvertToString(stats_.GetMean()));
+	md.put("FrameStdDev", CDeviceUtils::ConvertToString(stats_.GetStdDev()));
+	md.put("FrameSaturatedPixels", CDeviceUtils::ConvertToString((long) stats_.GetSaturated()));
+	if (histogramEnabled_)
+		md.put("FrameHistogram", stats_.HistogramToString());
+}
+
+/**
+* Work out the exposure for the next frame from the histogram of the one
+* just read. It is set by applyAutoExposure, outside the image lock.
+*/
+void CFlea2::updateAutoExposure(const std::vector<unsigned int>& histogram)
+{
+	if (sequenceRunning_)
+		return;		// exposure is not ours to choose
+	if (aeOldExposure_ > 0 || (streaming_ && !embeddedShutter_))
+		return;		// can't tell which exposure this frame had
+	autoExposure_.SetLimits(0.1, exposureMaximum_);
+	double next = autoExposure_.Update(histogram, frameExposure_);
+	if (next != frameExposure_)
+		autoExposurePending_ = next;
+}
+
+/**
+* Software binning applies to 16-bit frames only
+*/
+bool CFlea2::softBinning() const
+{
+	return binning_.IsActive() && img_.Depth() == 2;
+}
+
+/**
+* Bin the frame in img_ into binImg_
+*/
+const unsigned char* CFlea2::binFrame()
+{
+	const unsigned short* src = (const unsigned short*) img_.GetPixels();
+	if (softBin32_)
+		binning_.Bin(src, (float*) binImg_.GetPixelsRW());
+	else
+		binning_.Bin(src, (unsigned short*) binImg_.GetPixelsRW());
+	return binImg_.GetPixels();
+}
+
+/**
+* Set up the burst ring for a new sequence. When draining after the burst the
+* ring has to hold the whole sequence: a continuous sequence is cut short at
+* the ring capacity, and a longer finite one is refused up front.
+*/
+int CFlea2::startBurst(long& numImages)
+{
+	burstActive_ = false;
+	if (!burstEnabled_)
+		return DEVICE_OK;
+
+	if (!burstBackground_)
+	{
+		long images = burstCapacity_ / (long) GetNumberOfChannels();
+		if (numImages == LONG_MAX)
+			numImages = images;
+		else if (numImages > images)
+			return ERR_BURST_FULL;
+	}
+
+	if (!burst_.Allocate((unsigned int) burstCapacity_, GetImageBufferSize()))
+		return ERR_BURST_MEMORY;
+	if (!burst_.IsLocked())
+		LogMessage("Burst ring could not be locked in memory, frames may be paged out", true);
+	burstActive_ = true;
+	return DEVICE_OK;
+}
+
+/**
+* Pass the oldest frame in the burst ring to the core. Returns false if there
+* was nothing to pass on, or if the core buffer is full and the frame has to
+* wait. Outside live mode the frame is never dropped.
+*/
+bool CFlea2::drainBurstFrame()
+{
+	const BurstFrame* f = burst_.Front();
+	if (f == 0)
+		return false;
+
+	MM::Core* core = GetCoreCallback();
+	int ret = core->InsertImage(this, f->pixels, f->width, f->height, f->bytesPerPixel, f->metadata.c_str());
+	if (ret == DEVICE_BUFFER_OVERFLOW)
+	{
+		if (stopOnOverflow_)
+			return false;
+		// live mode: as insertIntoCore, reset the buffer rather than wait
+		core->ClearImageBuffer(this);
+		ret = core->InsertImage(this, f->pixels, f->width, f->height, f->bytesPerPixel, f->metadata.c_str(), false);
+	}
+	if (ret != DEVICE_OK)
+		LogMessage("Burst frame rejected by the core, error " + boost::lexical_cast<std::string>(ret), false);
+	burst_.Pop();
+	return true;
+}
+
+/**
+* Called on the sequence thread as it finishes: stop the background drain and
+* pass on everything left in the ring. If the core buffer stays full for 10 s
+* the rest is given up, so a client that has stopped reading cannot hang us.
+*/
+void CFlea2::finishBurst()
+{
+	if (!burstActive_)
+		return;
+	burstDrain_->Stop();
+	// no more frames are coming, so let go of the camera before draining
+	stopStreaming();
+
+	const double timeoutUs = 10.0e6;
+	double lastProgressUs = MonotonicClock::NowUs();
+	while (burst_.Size() > 0)
+	{
+		if (drainBurstFrame())
+			lastProgressUs = MonotonicClock::NowUs();
+		else if (MonotonicClock::NowUs() - lastProgressUs > timeoutUs)
+		{
+			LogMessage("Core buffer stayed full, " + boost::lexical_cast<std::string>(burst_.Size()) + " burst frames discarded", false);
+			break;
+		}
+		else
+			CDeviceUtils::SleepMs(1);
+	}
+	burstActive_ = false;
+}
+
+/**
+* Base name (no extension) of the files for a new stream
+*/
+std::string CFlea2::streamFile()
+{
+	char stamp[32];
+	time_t now = time(0);
+	strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+	char count[8];
+	sprintf(count, "_%03ld", ++streamCount_ % 1000);
+	return streamDir_ + "/Flea2_" + stamp + count;
+}
+
+/**
+* Open the stream files for a new sequence, preallocated for numImages
+*/
+int CFlea2::startStream(long numImages)
+{
+	finishStream();
+	if (!streamEnabled_)
+		return DEVICE_OK;
+	if (streamDir_.empty())
+		return ERR_STREAM_FILE;
+
+	unsigned long frames = (numImages == LONG_MAX) ? 0 : (unsigned long) numImages*GetNumberOfChannels();
+	stream_.SetBuffers((unsigned int) streamBuffers_, (size_t) streamBufferMB_ << 20);
+	streamPacked_ = streamCompress_ && GetImageBytesPerPixel() == 2;
+	if (streamCompress_ && !streamPacked_)
+		LogMessage("Stream to disk: compression needs 16-bit pixels, writing uncompressed", true);
+	stream_.SetCompression(streamPacked_ ? "FC16" : "none");
+	if (streamPacked_)
+	{
+		codec_.SetThreads((unsigned int) codecThreads_);
+		packed_.resize(FrameCodec::MaxCompressedBytes(GetImageWidth(), GetImageHeight()));
+	}
+	streamRawBytes_ = 0;
+	streamPackedBytes_ = 0;
+	if (!stream_.Open(streamFile(), GetImageWidth(), GetImageHeight(), GetImageBytesPerPixel(), frames))
+	{
+		LogMessage("Stream to disk: " + stream_.GetError(), false);
+		return ERR_STREAM_FILE;
+	}
+	if (!stream_.IsDirect())
+		LogMessage("Stream to disk: unbuffered I/O not available, writing through the file cache", true);
+	streamActive_ = true;
+	return DEVICE_OK;
+}
+
+/**
+* Called on the sequence thread as it finishes: wait for the I/O thread to
+* write out what is queued and close the files
+*/
+void CFlea2::finishStream()
+{
+	if (!streamActive_)
+		return;
+	streamActive_ = false;
+	if (!stream_.Close())
+		LogMessage("Stream to disk: " + stream_.GetError(), false);
+	else
+		LogMessage("Streamed " + boost::lexical_cast<std::string>(stream_.GetFramesWritten()) + " frames to " + stream_.GetRawPath(), true);
+}
+
+void CFlea2::applyAutoExposure()
+{
+	if (autoExposurePending_ <= 0)
+		return;
+	double exp = autoExposurePending_;
+	autoExposurePending_ = 0;
+	if (embeddedShutter_ && exp != appliedExposure_)
+	{
+		aeOldExposure_ = frameExposure_;
+		aeOldShutter_ = frameShutter_;
+		aeInFlight_ = grabBuffers_ + queueDepth_ + 1;
+	}
+	SetExposure(exp);
+}
+
+void CFlea2::GenerateEmptyImage(ImgBuffer& img)
+{
+	MMThreadGuard g(imgPixelsLock_);
+	if (img.Height() == 0 || img.Width() == 0 || img.Depth() == 0)
+		return;
+	unsigned char* pBuf = const_cast<unsigned char*>(img.GetPixels());
+	memset(pBuf, 0, img.Height()*img.Width()*img.Depth());
+}
+
+void CFlea2::TestResourceLocking(const bool recurse)
+{
+	if(recurse)
+		TestResourceLocking(false);
+}
+
+void CFlea2::rotate90(int original_xsize, int original_ysize, unsigned char *in_arr, unsigned char *out_arr){
+
+	int xsize = original_ysize;
+	int ysize = original_xsize;	//swapped here for clairty...
+	for (int y = 0; y < ysize; ++y){
+		for (int x = 0, destx = xsize-1; x<xsize; ++x, --destx){
+			out_arr[y * xsize + destx] = in_arr[x * ysize + y];
+		}
+	}
+}
+
+void CFlea2::rotate180(int original_xsize, int original_ysize, unsigned char *in_arr, unsigned char *out_arr){
+
+	for (int i = 0; i < original_xsize*original_ysize; ++i){
+		out_arr[original_xsize*original_ysize - 1 -i] = in_arr[i];
+	}
+}
+
+void CFlea2::rotate270(int original_xsize, int original_ysize, unsigned char *in_arr, unsigned char *out_arr){
+
+	int xsize = original_ysize;
+	int ysize = original_xsize;	//swapped here for clairty...
+	for (int x = 0; x < xsize; ++x){
+		for (int y = 0, desty = ysize-1; y<ysize; ++y, --desty){
+			out_arr[x + desty*xsize] = in_arr[x * ysize + y];
+		}
+	}
+}
+
+void CFlea2::mirrorY(int original_xsize, int original_ysize, unsigned char *in_arr, unsigned char *out_arr){
+
+	for (int x = 0; x < original_xsize; ++x){
+		for (int y = 0, desty = original_ysize - 1; y < original_ysize; ++y, --desty){
+			out_arr[desty * original_xsize + x] = in_arr[y * original_xsize + x];
+		}
+	}
+}
+
+void CFlea2::mirrorX(int original_xsize, int original_ysize, unsigned char *in_arr, unsigned char *out_arr){
+
+	for (int y = 0; y < original_ysize; ++y){
+		for (int x = 0, destx = original_xsize - 1; x < original_xsize; ++x, --destx){
+			out_arr[y * original_xsize + destx] = in_arr[y * original_xsize + x];
+		}
+	}
+}
+
+
+double CFlea2::roundUp(double numToRound, double toMultipleOf) 
+{ 
+	if(toMultipleOf == 0) 
 	{ 
 		return numToRound; 
 	} 
@@ -1715,8 +3969,6 @@ int CFlea2::findFactors(int input, std::vector<int> factors){
 
 int CFlea2::applyFormat7Commands(int binning, int bitdepth, int roi[4]) //and array for ROI?
 {
-			hCam_.StopCapture();
-	
 			FlyCapture2::Mode k_fmt7Mode;
 			FlyCapture2::PixelFormat k_fmt7PixFmt;
 			FlyCapture2::Error pgrErr;
@@ -1728,26 +3980,27 @@ int CFlea2::applyFormat7Commands(int binning, int bitdepth, int roi[4]) //and ar
 
 			if (bitdepth == 8)
 				k_fmt7PixFmt = FlyCapture2::PIXEL_FORMAT_MONO8;
+			else if (bitdepth == 12)
+				k_fmt7PixFmt = FlyCapture2::PIXEL_FORMAT_MONO12;
 			else
 				k_fmt7PixFmt = FlyCapture2::PIXEL_FORMAT_MONO16;
 
-			FlyCapture2::Format7Info fmt7Info;
-			bool supported;
-			fmt7Info.mode = k_fmt7Mode;
-			pgrErr = hCam_.GetFormat7Info( &fmt7Info, &supported );
-			
+			FlyCapture2::Format7Info* pFmt7Info;
+			int ret = getFormat7Info(k_fmt7Mode, pFmt7Info);
+			if (ret != DEVICE_OK)
+				return ret;
 
-			if ((!supported) || ( (k_fmt7PixFmt & fmt7Info.pixelFormatBitField) == 0 ))
+			if ( (k_fmt7PixFmt & pFmt7Info->pixelFormatBitField) == 0 )
 			{
 				LogMessage("Pixel format not supported");
 				return DEVICE_INVALID_PROPERTY_VALUE;
 			}
 
 			FlyCapture2::Format7ImageSettings fmt7ImageSettings;
-			roiW_ = roundUp(roi[2], fmt7Info.imageHStepSize);
-			roiH_ = roundUp(roi[3], fmt7Info.imageVStepSize);
-			roiX_ = roundUp(roi[0], fmt7Info.offsetHStepSize);
-			roiY_ = roundUp(roi[1], fmt7Info.offsetVStepSize);
+			roiW_ = roundUp(roi[2], pFmt7Info->imageHStepSize);
+			roiH_ = roundUp(roi[3], pFmt7Info->imageVStepSize);
+			roiX_ = roundUp(roi[0], pFmt7Info->offsetHStepSize);
+			roiY_ = roundUp(roi[1], pFmt7Info->offsetVStepSize);
 			//roiH_ = ySize;
 			//roiX_ = x;
 			//roiY_ = y;
@@ -1758,7 +4011,7 @@ int CFlea2::applyFormat7Commands(int binning, int bitdepth, int roi[4]) //and ar
 			fmt7ImageSettings.height = roiH_;
 			fmt7ImageSettings.pixelFormat = k_fmt7PixFmt;
 
-			bool valid;
+			bool valid = false;
 			FlyCapture2::Format7PacketInfo fmt7PacketInfo;
 			
 			// Validate the settings to make sure that they are valid
@@ -1766,7 +4019,6 @@ int CFlea2::applyFormat7Commands(int binning, int bitdepth, int roi[4]) //and ar
 				&fmt7ImageSettings,
 				&valid,
 				&fmt7PacketInfo );
-			int rbpp = fmt7PacketInfo.recommendedBytesPerPacket;
 
 			if (!valid)
 			{
@@ -1774,21 +4026,201 @@ int CFlea2::applyFormat7Commands(int binning, int bitdepth, int roi[4]) //and ar
 				return DEVICE_INVALID_PROPERTY_VALUE;
 			}
 
+			// Compare with what the camera is running: nothing to do, or only
+			// the offset has moved, which many cameras accept while streaming
+			if (activeFmt7Valid_
+				&& fmt7ImageSettings.mode == activeFmt7_.mode
+				&& fmt7ImageSettings.width == activeFmt7_.width
+				&& fmt7ImageSettings.height == activeFmt7_.height
+				&& fmt7ImageSettings.pixelFormat == activeFmt7_.pixelFormat)
+			{
+				if (fmt7ImageSettings.offsetX == activeFmt7_.offsetX && fmt7ImageSettings.offsetY == activeFmt7_.offsetY)
+					return applyPacketSize();
+
+				if (moveFormat7Offset(k_fmt7Mode, roiX_, roiY_) == DEVICE_OK)
+				{
+					activeFmt7_ = fmt7ImageSettings;
+					return DEVICE_OK;
+				}
+				LogMessage("Camera did not accept an offset change while streaming, restarting capture", true);
+			}
+
+			// Packet size for the target rate, instead of the recommended one
+			activeFmt7_ = fmt7ImageSettings;
+			packetUnit_ = fmt7PacketInfo.unitBytesPerPacket;
+			packetMax_ = fmt7PacketInfo.maxBytesPerPacket;
+			unsigned int packetBytes = planPacketSize();
+			if (packetBytes == 0)
+				packetBytes = fmt7PacketInfo.recommendedBytesPerPacket;
+
 			// Set the settings to the camera
+			hCam_.StopCapture();
+			activeFmt7Valid_ = false;
 			pgrErr = hCam_.SetFormat7Configuration(
 				&fmt7ImageSettings,
-				fmt7PacketInfo.recommendedBytesPerPacket );
+				packetBytes );
 			if (pgrErr != FlyCapture2::PGRERROR_OK)
 			{
 				LogMessage( "Error sending Format7 commands to camera" );
+				hCam_.StartCapture();
 				return DEVICE_ERR;
 			}
+			activeFmt7Valid_ = true;
+			packetBytes_ = packetBytes;
 
 			hCam_.StartCapture();
 
 			return DEVICE_OK;
 }
 
+/**
+* Format7 capabilities of a mode, read from the camera the first time only.
+*/
+int CFlea2::getFormat7Info(FlyCapture2::Mode mode, FlyCapture2::Format7Info*& pInfo)
+{
+	std::map<int, FlyCapture2::Format7Info>::iterator it = fmt7InfoCache_.find((int) mode);
+	if (it == fmt7InfoCache_.end())
+	{
+		FlyCapture2::Format7Info fmt7Info;
+		bool supported = false;
+		fmt7Info.mode = mode;
+		FlyCapture2::Error pgrErr = hCam_.GetFormat7Info( &fmt7Info, &supported );
+		if (pgrErr != FlyCapture2::PGRERROR_OK || !supported)
+		{
+			LogMessage("Format7 mode not supported");
+			return DEVICE_INVALID_PROPERTY_VALUE;
+		}
+		it = fmt7InfoCache_.insert(std::make_pair((int) mode, fmt7Info)).first;
+	}
+	pInfo = &it->second;
+	return DEVICE_OK;
+}
+
+/**
+* Bytes of one raw frame in the active Format7 configuration.
+*/
+double CFlea2::bytesPerFrame()
+{
+	double bytesPerPixel = 2;
+	if (activeFmt7_.pixelFormat == FlyCapture2::PIXEL_FORMAT_MONO8)
+		bytesPerPixel = 1;
+	else if (activeFmt7_.pixelFormat == FlyCapture2::PIXEL_FORMAT_MONO12)
+		bytesPerPixel = 1.5;
+	return (double) activeFmt7_.width * activeFmt7_.height * bytesPerPixel;
+}
+
+/**
+* Ask the bus planner for the packet size that carries the active ROI at
+* the target frame rate, and return what we have been allotted.
+*/
+unsigned int CFlea2::planPacketSize()
+{
+	if (packetMax_ == 0)
+		return 0;
+	BandwidthPlanner& planner = BandwidthPlanner::Instance();
+	unsigned int request = BandwidthPlanner::BytesPerPacketFor(targetFps_, bytesPerFrame(), packetUnit_, packetMax_);
+	planner.SetRequest(bwClientId_, request, packetUnit_, packetMax_);
+	bwGeneration_ = planner.GetGeneration();
+	return planner.GetAllotment(bwClientId_);
+}
+
+/**
+* Re-plan the packet size (target rate changed, or another camera on the bus
+* changed its request) and reconfigure the camera if our share has moved.
+* The packet size can only change with capture stopped.
+*/
+int CFlea2::applyPacketSize()
+{
+	if (!activeFmt7Valid_)
+		return DEVICE_OK;
+	unsigned int packetBytes = planPacketSize();
+	if (packetBytes == 0 || packetBytes == packetBytes_)
+		return DEVICE_OK;
+	if (IsCapturing())
+		return DEVICE_CAMERA_BUSY_ACQUIRING;
+
+	hCam_.StopCapture();
+	FlyCapture2::Error pgrErr = hCam_.SetFormat7Configuration( &activeFmt7_, packetBytes );
+	hCam_.StartCapture();
+	if (pgrErr != FlyCapture2::PGRERROR_OK)
+	{
+		LogMessage( "Error setting packet size" );
+		return DEVICE_ERR;
+	}
+	packetBytes_ = packetBytes;
+	return DEVICE_OK;
+}
+
+/**
+* Take up our current share of the bus if another camera has changed its
+* request, or closed, since we last planned. Called before each snap and
+* sequence, as a change elsewhere is not pushed to us.
+*/
+int CFlea2::followBusPlan()
+{
+	if (BandwidthPlanner::Instance().GetGeneration() == bwGeneration_)
+		return DEVICE_OK;
+	return applyPacketSize();
+}
+
+/**
+* Move the image position of the running Format7 mode without stopping
+* isochronous transmission: write IMAGE_POSITION in the mode's IIDC CSR
+* block, latch it with VALUE_SETTING, wait for the camera to clear Setting_1
+* and check its error flag. The position must already have been validated.
+*/
+int CFlea2::moveFormat7Offset(FlyCapture2::Mode mode, unsigned int offsetX, unsigned int offsetY)
+{
+	const unsigned int k_fmt7CsrInq = 0x2E0;		// V_CSR_INQ_7_0, one quadlet per mode
+	const unsigned int k_imagePosition = 0x008;
+	const unsigned int k_valueSetting = 0x07C;
+	const unsigned int k_presence = 0x80000000;
+	const unsigned int k_setting1 = 0x40000000;
+	const unsigned int k_error1 = 0x00800000;
+
+	FlyCapture2::Error pgrErr;
+	unsigned int csrOffset = 0;
+	pgrErr = hCam_.ReadRegister( k_fmt7CsrInq + 4*(unsigned int) mode, &csrOffset );
+	if (pgrErr != FlyCapture2::PGRERROR_OK || csrOffset == 0)
+		return DEVICE_ERR;
+
+	// quadlet offset from 0xFFFFF0000000; registers are relative to 0xFFFFF0F00000
+	unsigned int csrBase = csrOffset*4 - 0xF00000;
+
+	unsigned int valueSetting = 0;
+	pgrErr = hCam_.ReadRegister( csrBase + k_valueSetting, &valueSetting );
+	if (pgrErr != FlyCapture2::PGRERROR_OK || (valueSetting & k_presence) == 0)
+		return DEVICE_ERR;
+
+	pgrErr = hCam_.WriteRegister( csrBase + k_imagePosition, (offsetX << 16) | (offsetY & 0xFFFF) );
+	if (pgrErr == FlyCapture2::PGRERROR_OK)
+		pgrErr = hCam_.WriteRegister( csrBase + k_valueSetting, k_setting1 );
+	if (pgrErr != FlyCapture2::PGRERROR_OK)
+		return DEVICE_ERR;
+
+	// the error flag is only meaningful once Setting_1 has cleared
+	const double timeoutUs = 100000;
+	double startUs = MonotonicClock::NowUs();
+	do
+	{
+		pgrErr = hCam_.ReadRegister( csrBase + k_valueSetting, &valueSetting );
+		if (pgrErr != FlyCapture2::PGRERROR_OK)
+			return DEVICE_ERR;
+		if ((valueSetting & k_setting1) == 0)
+			break;
+		if (MonotonicClock::NowUs() - startUs > timeoutUs)
+		{
+			LogMessage("Camera did not finish the image position change", true);
+			return DEVICE_ERR;
+		}
+		CDeviceUtils::SleepMs(1);
+	} while (true);
+	if ((valueSetting & k_error1) != 0)
+		return DEVICE_ERR;
+
+	return DEVICE_OK;
+}
+
 int CFlea2::setGain(double gain)
 {
 	FlyCapture2::Error pgrErr;
@@ -1821,8 +4253,6 @@ int CFlea2::setTrigMode(std::string trigMode)
 	FlyCapture2::Error pgrErr;
 	FlyCapture2::TriggerMode triggerMode;
 
-	hCam_.StopCapture();
-
 	if (trigMode.compare("Asynchronous-hardware") == 0)
 	{
 		//Check that hardware option is supported
@@ -1854,7 +4284,7 @@ int CFlea2::setTrigMode(std::string trigMode)
 		triggerMode.parameter = 0;
 		triggerMode.source = 0;
 
-		pgrErr = hCam_.SetTriggerMode( &triggerMode );
+		pgrErr = setTriggerModeLive( triggerMode );
 		if (pgrErr != FlyCapture2::PGRERROR_OK)
 		{
 			LogMessage("Error in setting trigger mode");
@@ -1893,7 +4323,7 @@ int CFlea2::setTrigMode(std::string trigMode)
 		triggerMode.parameter = 0;
 		triggerMode.source = 7;	//Software trigger
 
-		pgrErr = hCam_.SetTriggerMode( &triggerMode );
+		pgrErr = setTriggerModeLive( triggerMode );
 		if (pgrErr != FlyCapture2::PGRERROR_OK)
 		{
 			LogMessage("Error in setting trigger mode");
@@ -1903,7 +4333,7 @@ int CFlea2::setTrigMode(std::string trigMode)
 	else //default, isochronous
 	{
 		triggerMode.onOff = false;    
-		pgrErr = hCam_.SetTriggerMode( &triggerMode );
+		pgrErr = setTriggerModeLive( triggerMode );
 		if (pgrErr != FlyCapture2::PGRERROR_OK)
 		{
 			LogMessage("Error in setting trigger mode");
@@ -1911,11 +4341,181 @@ int CFlea2::setTrigMode(std::string trigMode)
 		}
 		//hCam_.StartCapture();
 	}
-	hCam_.StartCapture();
 	
 	return DEVICE_OK;
 }
 
+/**
+* Change the trigger mode register while isochronous capture keeps running;
+* only if the camera refuses is capture stopped around the change.
+*/
+FlyCapture2::Error CFlea2::setTriggerModeLive(const FlyCapture2::TriggerMode& triggerMode)
+{
+	FlyCapture2::Error pgrErr = hCam_.SetTriggerMode( &triggerMode );
+	if (pgrErr != FlyCapture2::PGRERROR_OK)
+	{
+		hCam_.StopCapture();
+		pgrErr = hCam_.SetTriggerMode( &triggerMode );
+		hCam_.StartCapture();
+	}
+	return pgrErr;
+}
+
+/**
+* Put the driver into BUFFER_FRAMES mode with grabBuffers_ buffers and start
+* the retrieval thread feeding frameQueue_.
+*/
+int CFlea2::startStreaming()
+{
+	FlyCapture2::Error pgrErr;
+	FlyCapture2::FC2Config config;
+
+	hCam_.StopCapture();
+
+	pgrErr = hCam_.GetConfiguration( &config );
+	if (pgrErr == FlyCapture2::PGRERROR_OK)
+	{
+		config.numBuffers = grabBuffers_;
+		config.grabMode = FlyCapture2::BUFFER_FRAMES;
+		pgrErr = hCam_.SetConfiguration( &config );
+	}
+	if (pgrErr != FlyCapture2::PGRERROR_OK)
+	{
+		LogMessage( "Error configuring buffered grab mode" );
+		hCam_.StartCapture();
+		return DEVICE_ERR;
+	}
+
+	// 16 bits per pixel is the largest raw format we request
+	frameQueue_.Allocate(queueDepth_, roiW_*roiH_*2);
+	queueDropped_ = 0;
+	ResetEvent(frameEvent_);
+
+	pgrErr = hCam_.StartCapture();
+	if (pgrErr != FlyCapture2::PGRERROR_OK)
+	{
+		LogMessage( "Error starting capture" );
+		return DEVICE_ERR;
+	}
+
+	streaming_ = true;
+	retrieval_->Start();
+	return DEVICE_OK;
+}
+
+/**
+* Stop the retrieval thread and go back to DROP_FRAMES, where RetrieveBuffer
+* returns the newest frame, for snaps.
+*/
+int CFlea2::stopStreaming()
+{
+	if (!streaming_)
+		return DEVICE_OK;
+
+	retrieval_->Stop();
+	streaming_ = false;
+
+	FlyCapture2::Error pgrErr;
+	FlyCapture2::FC2Config config;
+	pgrErr = hCam_.GetConfiguration( &config );
+	if (pgrErr == FlyCapture2::PGRERROR_OK)
+	{
+		config.grabMode = FlyCapture2::DROP_FRAMES;
+		pgrErr = hCam_.SetConfiguration( &config );
+	}
+	hCam_.StartCapture();
+
+	if (pgrErr != FlyCapture2::PGRERROR_OK)
+	{
+		LogMessage( "Error restoring grab mode" );
+		return DEVICE_ERR;
+	}
+	return DEVICE_OK;
+}
+
+/**
+* Embedded timestamps are the IIDC cycle time, which wraps every 128 s.
+* Returns microseconds on a continuous scale for the current sequence.
+*/
+double CFlea2::unwrapCameraTimestamp(unsigned int raw)
+{
+	double us = (raw >> 25)*1.0e6 + ((raw >> 12) & 0x1FFF)*125.0 + (raw & 0xFFF)*125.0/3072;
+	us += timestampBaseUs_;
+	if (us < lastTimestampUs_)
+	{
+		timestampBaseUs_ += 128.0e6;
+		us += 128.0e6;
+	}
+	lastTimestampUs_ = us;
+	return us;
+}
+
+/**
+* Oldest queued frame, waiting up to timeoutMs for one to arrive. Returns
+* NULL on timeout or if the retrieval thread has stopped.
+*/
+QueuedFrame* CFlea2::waitForQueuedFrame(double timeoutMs)
+{
+	double deadlineUs = MonotonicClock::NowUs() + timeoutMs*1000;
+	QueuedFrame* frame = frameQueue_.Front();
+	while (frame == 0)
+	{
+		double remainingUs = deadlineUs - MonotonicClock::NowUs();
+		if (remainingUs <= 0 || retrieval_->IsStopped())
+			return 0;
+		WaitForSingleObject(frameEvent_, (DWORD) ceil(remainingUs/1000));
+		frame = frameQueue_.Front();
+	}
+	return frame;
+}
+
+/**
+* How long to wait for the next frame. With an external trigger that is set
+* by the trigger source, otherwise by the exposure.
+*/
+double CFlea2::frameTimeoutMs()
+{
+	if (trigMode_.compare("Asynchronous-hardware") == 0)
+		return hwTriggerTimeoutMs_ + GetExposure();
+	return 5000 + GetExposure();
+}
+
+/**
+* Snap in Asynchronous-hardware mode: wait for the externally triggered frame
+* and decode it into img_. RetrieveBuffer gives up after the grab timeout, so
+* keep asking until our own deadline passes.
+*/
+int CFlea2::retrieveTriggeredFrame(double timeoutMs)
+{
+	MMThreadGuard g(imgPixelsLock_);
+	double deadlineUs = MonotonicClock::NowUs() + timeoutMs*1000;
+	FlyCapture2::Image rawImage;
+	FlyCapture2::Error pgrErr;
+
+	snapRetrieved_ = false;
+	while (true)
+	{
+		pgrErr = hCam_.RetrieveBuffer( &rawImage );
+		if (pgrErr == FlyCapture2::PGRERROR_OK)
+			break;
+		if (pgrErr != FlyCapture2::PGRERROR_TIMEOUT)
+		{
+			LogMessage( (std::string) "Error retrieving triggered image: " + pgrErr.GetDescription() );
+			return DEVICE_ERR;
+		}
+		if (MonotonicClock::NowUs() > deadlineUs)
+			return ERR_HW_TRIGGER_TIMEOUT;
+	}
+
+	decodeImage(rawImage);
+	FlyCapture2::ImageMetadata embedded = rawImage.GetMetadata();
+	frameCounter_ = embedded.embeddedFrameCounter;
+	frameTimestamp_ = embedded.embeddedTimeStamp;
+	frameShutter_ = embedded.embeddedShutter;
+	snapRetrieved_ = true;
+	return DEVICE_OK;
+}
+
 int CFlea2::FireSoftwareTrigger( FlyCapture2::Camera* pCam )
 {
     const unsigned int k_softwareTrigger = 0x62C;
@@ -1932,22 +4532,37 @@ int CFlea2::FireSoftwareTrigger( FlyCapture2::Camera* pCam )
     return DEVICE_OK;
 }
 
-bool CFlea2::PollForTriggerReady( FlyCapture2::Camera* pCam )
+/**
+* Wait until the camera can accept a software trigger (bit 31 of 0x62C
+* clear). The register is polled with a backoff, from back-to-back reads up
+* to one read per millisecond, so a long exposure doesn't keep the bus and
+* a core busy. Gives up after timeoutMs.
+*/
+int CFlea2::WaitForTriggerReady( FlyCapture2::Camera* pCam, double timeoutMs )
 {
     const unsigned int k_softwareTrigger = 0x62C;
     FlyCapture2::Error pgrErr;
     unsigned int regVal = 0;
 
-    do 
+	double deadlineUs = MonotonicClock::NowUs() + timeoutMs*1000;
+	double backoffUs = 0;
+    while (true)
     {
         pgrErr = pCam->ReadRegister( k_softwareTrigger, &regVal );
         if (pgrErr != FlyCapture2::PGRERROR_OK)
         {
             LogMessage("Error in polling for trigger readiness");
-			return false;
+			return DEVICE_ERR;
         }
+		if ( (regVal >> 31) == 0 )
+			return DEVICE_OK;
 
-    } while ( (regVal >> 31) != 0 );
+		double nowUs = MonotonicClock::NowUs();
+		if (nowUs > deadlineUs)
+			return ERR_TRIGGER_NOT_READY;
 
-	return true;
+		if (backoffUs > 0)
+			MonotonicClock::SleepUntilUs(nowUs + backoffUs);
+		backoffUs = (backoffUs == 0) ? 20 : ((backoffUs < 500) ? 2*backoffUs : 1000);
+    }
 }
\ No newline at end of file
@@ -62,6 +62,20 @@
 #include "../../3rdparty/PGR/include/TopologyNode.h"
 #include "../../3rdparty/PGR/include/ImageStatistics.h"
 
+#include "../CameraUtilities/FramePacer.h"
+#include "../CameraUtilities/FrameQueue.h"
+#include "../CameraUtilities/PixelUnpack.h"
+#include "../CameraUtilities/FrameGapDetector.h"
+#include "../CameraUtilities/BandwidthPlanner.h"
+#include "../CameraUtilities/FrameAccumulator.h"
+#include "../CameraUtilities/FrameCorrection.h"
+#include "../CameraUtilities/FrameStatistics.h"
+#include "../CameraUtilities/AutoExposure.h"
+#include "../CameraUtilities/SoftwareBinning.h"
+#include "../CameraUtilities/BurstBuffer.h"
+#include "../CameraUtilities/StreamWriter.h"
+#include "../CameraUtilities/FrameCodec.h"
+
 
 //////////////////////////////////////////////////////////////////////////////
 // Error codes
@@ -72,6 +86,15 @@
 #define ERR_SEQUENCE_INACTIVE    105
 #define ERR_STAGE_MOVING         106
 #define HUB_NOT_AVAILABLE        107
+#define ERR_TRIGGER_NOT_READY    108
+#define ERR_HW_TRIGGER_TIMEOUT   109
+#define ERR_CAMERA_NOT_FOUND     110
+#define ERR_CORRECTION_PIXELTYPE 111
+#define ERR_CORRECTION_FILE      112
+#define ERR_BINNING_ACCUMULATE   113
+#define ERR_BURST_FULL           114
+#define ERR_BURST_MEMORY         115
+#define ERR_STREAM_FILE          116
 
 const char* NoHubError = "Parent Hub not defined.";
 
@@ -82,6 +105,8 @@ const char* NoHubError = "Parent Hub not defined.";
 //////////////////////////////////////////////////////////////////////////////
 
 class MySequenceThread;
+class BurstDrainThread;
+class RetrievalThread;
 
 class CFlea2 : public CCameraBase<CFlea2>  
 {
@@ -100,6 +125,9 @@ public:
 	// ------------
 	int SnapImage();
 	const unsigned char* GetImageBuffer();
+	const unsigned char* GetImageBuffer(unsigned channelNr);
+	unsigned GetNumberOfChannels() const;
+	int GetChannelName(unsigned channel, char* name);
 	unsigned GetImageWidth() const;
 	unsigned GetImageHeight() const;
 	unsigned GetImageBytesPerPixel() const;
@@ -151,6 +179,67 @@ public:
 	
 	int OnTrigMode(MM::PropertyBase* pProp, MM::ActionType eAct);
 	int OnGain(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnJitterMean(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnJitterStd(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnJitterMax(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnLateFrames(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnGrabBuffers(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameQueueDepth(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnHardwareTriggerTimeout(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnTargetFrameRate(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnBytesPerPacket(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAchievableFrameRate(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameQueueFill(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameQueueHighWater(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnQueueDroppedFrames(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnUnpackBenchmark(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnUnpackBenchmarkResult(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnDroppedFrames(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAccumulateFrames(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAccumulateVariance(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnDarkCorrection(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFlatCorrection(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCorrectionFrames(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCorrectionDir(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCorrectionCommand(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCorrectionStatus(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnHotPixelCorrection(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnHotPixelSigma(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnHotPixelCount(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameStatistics(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameHistogram(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameMin(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameMax(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameMean(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameStdDev(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnFrameSaturated(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAutoExposure(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAutoExposureTarget(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAutoExposurePercentile(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnAutoExposureDamping(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnSoftwareBinX(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnSoftwareBinY(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnSoftwareBinDepth(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnBurstMode(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnBurstCapacity(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnBurstFramesHeld(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnBurstHighWater(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnBurstMemoryLocked(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamToDisk(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamDir(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamBuffers(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamBufferSize(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamFile(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamFramesWritten(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamQueueDepth(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamQueueHighWater(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamThroughput(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamDirectIO(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamCompression(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCompressionThreads(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnStreamCompressionRatio(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCompressionBenchmark(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnCompressionBenchmarkResult(MM::PropertyBase* pProp, MM::ActionType eAct);
 
 
 private:
@@ -159,6 +248,27 @@ private:
 	void TestResourceLocking(const bool);
 	void GenerateEmptyImage(ImgBuffer& img);
 	int ResizeImageBuffer();
+	int snapFrame();
+	const unsigned char* readFrame();
+	int runSequenceFrame();
+	void accumulateFrame(const unsigned char* pixels);
+	int insertIntoCore(const unsigned char* pI, Metadata& md);
+	std::string correctionKey() const;
+	std::string correctionFile() const;
+	void selectCorrection();
+	int captureReference(bool dark);
+	void scanFrame(const unsigned char* src);
+	void putFrameStatistics(Metadata& md);
+	void updateAutoExposure(const std::vector<unsigned int>& histogram);
+	void applyAutoExposure();
+	bool softBinning() const;
+	const unsigned char* binFrame();
+	int startBurst(long& numImages);
+	bool drainBurstFrame();
+	void finishBurst();
+	std::string streamFile();
+	int startStream(long numImages);
+	void finishStream();
 
 	double roundUp(double numToRound, double toMultipleOf);
 	int findFactors(int input, std::vector<int> factors);
@@ -170,18 +280,48 @@ private:
 	void mirrorX(int original_xsize, int original_ysize, unsigned char *in_arr, unsigned char *out_arr);
 
 	int applyFormat7Commands(int binning, int bitdepth, int roi[4]);
+	int getFormat7Info(FlyCapture2::Mode mode, FlyCapture2::Format7Info*& pInfo);
+	int moveFormat7Offset(FlyCapture2::Mode mode, unsigned int offsetX, unsigned int offsetY);
+	unsigned int planPacketSize();
+	int applyPacketSize();
+	int followBusPlan();
+	double bytesPerFrame();
 	int setGain(double gain);
 	int setTrigMode(std::string trigMode);
+	FlyCapture2::Error setTriggerModeLive(const FlyCapture2::TriggerMode& triggerMode);
 	int FireSoftwareTrigger( FlyCapture2::Camera* pCam );
-	bool PollForTriggerReady( FlyCapture2::Camera* pCam );
+	int WaitForTriggerReady( FlyCapture2::Camera* pCam, double timeoutMs );
+	int startStreaming();
+	int stopStreaming();
+	QueuedFrame* waitForQueuedFrame(double timeoutMs);
+	double frameTimeoutMs();
+	int retrieveTriggeredFrame(double timeoutMs);
+	void decodeImage(FlyCapture2::Image& rawImage);
+	double unwrapCameraTimestamp(unsigned int raw);
 
 	FlyCapture2::Camera hCam_;
+
+	// Format7: capabilities per mode (fixed for a camera, so read once) and
+	// the configuration currently on the camera
+	std::map<int, FlyCapture2::Format7Info> fmt7InfoCache_;
+	FlyCapture2::Format7ImageSettings activeFmt7_;
+	bool activeFmt7Valid_;
+
+	// Isochronous packet size, shared out between the cameras on the bus
+	int bwClientId_;
+	unsigned long bwGeneration_;	// planner generation our packet size was planned at
+	double targetFps_;			// 0 = as fast as the bus allows
+	unsigned int packetBytes_;	// in use on the camera
+	unsigned int packetUnit_;
+	unsigned int packetMax_;
 	double gain_;
 
 	double exposureMaximum_;
 	std::string trigMode_;
 	double dPhase_;
 	ImgBuffer img_;
+	std::vector<unsigned char> convertBuf_;
+	std::string unpackBenchmark_;
 	bool busy_;
 	bool stopOnOverFlow_;
 	bool initialized_;
@@ -198,6 +338,16 @@ private:
 	unsigned long sequenceIndex_;
 	double GetSequenceExposure();
 	std::vector<double> exposureSequence_;
+	double frameExposure_;		// exposure of the frame being acquired in a sequence
+
+	// Exposure fast path: the shutter Property is read from the camera once
+	// and reused, and the grab timeout only rewritten when its class changes
+	int applyShutter(double exp);
+	void applyGrabTimeout(double exp);
+	FlyCapture2::Property shutterProp_;
+	bool shutterPropValid_;
+	double appliedExposure_;	// on the camera, or -1 if unknown
+	int grabTimeoutClass_;		// whole seconds of exposure the timeout covers
 	long imageCounter_;
 	long binSizeX_;
 	long binSizeY_;
@@ -214,10 +364,113 @@ private:
 	bool flipLR_;
 	long imageRotationAngle_;
 
+	FramePacer pacer_;
+	FramePacingStats pacingStats_;
+	MMThreadLock pacerLock_;
+
+	// Buffered streaming: the retrieval thread drains the driver into
+	// frameQueue_, the sequence thread consumes from it.
+	FrameQueue frameQueue_;
+	bool streaming_;
+	long grabBuffers_;			// FlyCapture2 driver buffers (BUFFER_FRAMES mode)
+	long queueDepth_;
+	volatile LONG queueDropped_;	// frames lost because frameQueue_ was full
+	HANDLE frameEvent_;			// set by the retrieval thread for each queued frame
+	int triggersPending_;		// software triggers fired whose frames we haven't consumed
+	long hwTriggerTimeoutMs_;	// how long to wait for an external trigger
+	bool snapRetrieved_;		// SnapImage already read the frame into img_
+
+	// Embedded image info of the frame in img_, and gaps in the sequence
+	bool embeddedInfo_;
+	unsigned long frameCounter_;
+	unsigned int frameTimestamp_;	// IIDC cycle time: 7 bit s, 13 bit 125us cycles, 12 bit offset
+	bool embeddedShutter_;			// frames also carry their shutter register
+	unsigned long frameShutter_;
+	double timestampBaseUs_;		// unwrapping of the 128 s timestamp period
+	double lastTimestampUs_;
+	FrameGapDetector gapDetector_;
+
+	// Frame accumulation: AccumulateFrames exposures are summed in 32-bit
+	// integers and delivered as one 32-bit float frame, with a variance
+	// channel if asked for
+	long accumulateFrames_;
+	bool accumulateVariance_;
+	FrameAccumulator accumulator_;
+	ImgBuffer accumImg_;
+	ImgBuffer varianceImg_;
+	bool accumReady_;			// accumImg_ holds a completed sum
+
+	// Dark/flat correction of 16-bit frames, references per readout geometry
+	FrameCorrection correction_;
+	long correctionFrames_;		// frames averaged into a reference
+	double hotPixelSigma_;		// hot pixel threshold, standard deviations above the dark mean
+	std::string correctionDir_;	// where references are saved; empty for none
+	bool capturingReference_;	// bypass the correction while capturing
+
+	// Statistics of each frame read out, taken while it is copied into img_
+	FrameStatistics stats_;
+	bool statsEnabled_;
+	bool histogramEnabled_;
+	bool frameScanned_;			// stats_ already describes the frame in img_
+
+	// Autoexposure from the statistics of each frame
+	AutoExposure autoExposure_;
+	bool autoExposureEnabled_;
+	double autoExposurePending_;	// exposure (ms) to set before the next frame, 0 for none
+	// Frames exposed before a change are still in the driver's buffers and
+	// our queue after it. Told apart by their embedded shutter value, they
+	// keep the old exposure and are not fed back into the autoexposure.
+	double aeOldExposure_;		// exposure of the frames in flight at the change, 0 for none
+	unsigned long aeOldShutter_;	// their embedded shutter value
+	long aeInFlight_;			// frames which may still predate the change
+	std::vector<unsigned int> aeHistogram_;	// pooled over the exposures of an accumulated frame
+	bool aeSumStale_;			// some of those exposures predate the change
+
+	// Software binning of 16-bit frames, after any binning done by the camera.
+	// The image (and ROI) seen by the core is the binned one.
+	SoftwareBinning binning_;
+	long softBinX_;
+	long softBinY_;
+	bool softBin32_;			// exact 32-bit float sums rather than clipped 16-bit
+	ImgBuffer binImg_;
+
+	// Burst capture: sequence frames are parked in a preallocated ring in RAM
+	// and passed to the core after the burst, or by BurstDrainThread
+	BurstBuffer burst_;
+	bool burstEnabled_;
+	bool burstBackground_;		// drain while the burst runs rather than after it
+	long burstCapacity_;		// frames
+	bool burstActive_;			// the running sequence is writing to burst_
+
+	// Stream to disk: sequence frames are written to StreamDir by the
+	// StreamWriter I/O thread, instead of or as well as going to the core
+	StreamWriter stream_;
+	bool streamEnabled_;
+	bool streamToCore_;
+	std::string streamDir_;
+	long streamBuffers_;
+	long streamBufferMB_;
+	long streamCount_;			// streams written since the adapter was loaded
+	bool streamActive_;			// the running sequence is writing to stream_
+
+	// Lossless compression of streamed 16-bit frames
+	FrameCodec codec_;
+	bool streamCompress_;
+	bool streamPacked_;			// the running stream is compressed
+	long codecThreads_;			// 0 for one per processor
+	std::vector<unsigned char> packed_;
+	double streamRawBytes_;
+	double streamPackedBytes_;
+	std::string codecBenchmark_;
+
 	MMThreadLock imgPixelsLock_;
 	friend class MySequenceThread;
+	friend class BurstDrainThread;
+	friend class RetrievalThread;
 	int nComponents_;
 	MySequenceThread * thd_;
+	BurstDrainThread * burstDrain_;
+	RetrievalThread * retrieval_;
 };
 
 class MySequenceThread : public MMDeviceThreadBase
@@ -254,6 +507,48 @@ private:
 	MMThreadLock suspendLock_;                                                
 }; 
 
+//////////////////////////////////////////////////////////////////////////////
+// RetrievalThread class
+// Calls RetrieveBuffer back to back while streaming and copies each frame
+// into the camera's FrameQueue, so a slow consumer never stalls the driver.
+//////////////////////////////////////////////////////////////////////////////
+class RetrievalThread : public MMDeviceThreadBase
+{
+public:
+	RetrievalThread(CFlea2* pCam);
+	~RetrievalThread();
+	void Start();
+	void Stop();
+	bool IsStopped();
+private:
+	int svc(void) throw();
+	CFlea2* camera_;
+	bool stop_;
+	bool running_;	// started and not yet joined
+	MMThreadLock stopLock_;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// BurstDrainThread class
+// Passes frames from the burst ring to the core while the burst is still
+// running, when BurstMode is "Drain in background".
+//////////////////////////////////////////////////////////////////////////////
+class BurstDrainThread : public MMDeviceThreadBase
+{
+	enum { default_idleMS = 2 };
+public:
+	BurstDrainThread(CFlea2* pCam);
+	~BurstDrainThread();
+	void Start();
+	void Stop();
+	bool IsStopped();
+private:
+	int svc(void) throw();
+	CFlea2* camera_;
+	bool stop_;
+	MMThreadLock stopLock_;
+};
+
 
 
 